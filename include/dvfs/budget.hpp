@@ -0,0 +1,84 @@
+// dvfs/budget.hpp
+// Weighted power-budget sharing between co-located tenants (cgroup v2
+// dirs) under the cap. Every control period:
+//
+//   attribute  rail power above idle is split by CPU time: a tenant gets
+//              (P - P_idle) * usage / busy, usage from <cg>/cpu.stat
+//              (usage_usec) and busy from /proc/stat; the remainder is
+//              "other" (system, untracked work)
+//   share      budget = cap - P_idle - other, water-filled by weight: a
+//              tenant below its share is given what it uses plus 25%
+//              headroom, and the unused rest is re-shared among the tenants
+//              that want more (active ones)
+//   enforce    each tenant has a level in (0, 1] steered toward its
+//              allocation (level *= sqrt(alloc / attributed)), written as
+//              cpu.max quota = level * ncpus * period, or cpu.uclamp.max =
+//              level * 100%
+//
+// Original cpu.max / cpu.uclamp.* values are restored on restore().
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dvfs/uclamp.hpp"
+
+namespace dvfs {
+
+struct Tenant {
+    std::string cgroup;
+    double weight = 1.0;
+};
+
+// "<cgroup dir>:<weight>" (weight defaults to 1).
+bool parse_tenant(const std::string& s, Tenant& out);
+
+// Weighted max-min fair split of budget; demand < 0 = unbounded.
+std::vector<double> share_budget(double budget, const std::vector<double>& weights,
+                                 const std::vector<double>& demand);
+
+enum class BudgetEnforce { CpuMax, Uclamp };
+
+struct TenantState {
+    double usage_pct = 0;   // of one CPU over the period
+    double attr_mw = 0;
+    double alloc_mw = 0;
+    double level = 1.0;
+    double energy_mj = 0;   // attributed, since start
+};
+
+class BudgetSharer {
+public:
+    BudgetSharer(std::vector<Tenant> tenants, BudgetEnforce mode, double min_level = 0.05);
+    ~BudgetSharer() { restore(); }
+
+    // Check the cgroups and save what enforcement will change.
+    bool start(std::string& err);
+    // One period: rail power (filtered), idle power, cap. Writes the levels.
+    void step(double mw, double idle_mw, double cap_mw);
+    void restore();
+
+    const std::vector<Tenant>& tenants() const { return t_; }
+    const std::vector<TenantState>& state() const { return st_; }
+    double other_mw() const { return other_mw_; }
+
+private:
+    bool read_usage(std::vector<long long>& usec, long long& busy_usec) const;
+    void enforce(size_t i);
+
+    std::vector<Tenant> t_;
+    std::vector<TenantState> st_;
+    BudgetEnforce mode_;
+    double min_level_;
+    int ncpus_ = 1;
+    std::vector<long long> last_usec_;
+    long long last_busy_ = -1;
+    int64_t last_ts_ = 0;
+    std::vector<std::string> saved_max_;  // cpu.max originals
+    UclampActuator uc_;
+    double other_mw_ = 0;
+    bool started_ = false;
+};
+
+} // namespace dvfs
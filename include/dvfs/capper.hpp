@@ -0,0 +1,60 @@
+// dvfs/capper.hpp
+// Power capper: keeps a rail under cap_mw by moving the CPU / GPU ceilings
+// one OPP at a time. It only decides; the ceilings are sent to the daemon as
+// cap requests (dvfs/daemon.hpp), so they bound every other client.
+//
+// Per step on the EWMA-filtered reading:
+//   above cap              lower the domain sitting higher in its OPP table
+//                          (relative index; the GPU first on a tie)
+//   below cap * (1 - hyst) raise the domain sitting lower
+//
+// With CPU pressure fed in (set_cpu_pressure, PSI "some" %), the choice of
+// domain follows the stall: a lower CPU clock only hurts when tasks are
+// waiting for CPU, so
+//
+//   stall < psi_low        over cap: the CPU goes down first; under: the
+//                          GPU comes back up first
+//   stall > psi_high       over cap: the GPU goes down first; under: the
+//                          CPU comes back up first
+//   in between / unknown   by OPP level as above
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+class PowerCapper {
+public:
+    // OPP tables ascending; an empty table leaves that domain alone.
+    PowerCapper(std::vector<long long> cpu_opps, std::vector<long long> gpu_opps, double cap_mw,
+                double hyst = 0.08, double alpha = 0.5);
+
+    // CPU stall share over the last period, in %; NaN = unknown.
+    void set_cpu_pressure(double some_pct) { psi_ = some_pct; }
+    void set_pressure_band(double low_pct, double high_pct) { psi_low_ = low_pct; psi_high_ = high_pct; }
+
+    // One control step; true + note when a ceiling moved.
+    bool step(double mw, std::string& note);
+
+    // Current ceilings (0 = domain not capped).
+    long long cpu_max() const { return cpu_.empty() ? 0 : cpu_[ci_]; }
+    long long gpu_max() const { return gpu_.empty() ? 0 : gpu_[gi_]; }
+    double filtered_mw() const { return mw_; }
+    double cap_mw() const { return cap_mw_; }
+
+private:
+    double level(const std::vector<long long>& t, size_t i) const {
+        return t.size() < 2 ? 0.0 : (double)i / (double)(t.size() - 1);
+    }
+
+    std::vector<long long> cpu_, gpu_;
+    size_t ci_ = 0, gi_ = 0;
+    double cap_mw_, hyst_, alpha_;
+    double mw_ = -1.0;
+    double psi_ = std::nan("");
+    double psi_low_ = 5.0, psi_high_ = 20.0;
+};
+
+} // namespace dvfs
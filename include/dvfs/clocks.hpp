@@ -0,0 +1,70 @@
+// dvfs/clocks.hpp
+// Timestamp domains: CLOCK_MONOTONIC (ts_ns in every log), CLOCK_BOOTTIME
+// (keeps counting through suspend) and CLOCK_REALTIME (wall clock, NTP
+// slewed / stepped).
+//
+// A log records anchors - near-simultaneous reads of all three clocks - in a
+// "<out>.clocks" sidecar at start, every --anchor_s and at stop:
+//
+//   mono_ns,boot_ns,real_ns,unc_ns
+//
+// unc_ns is half the CLOCK_MONOTONIC window the three reads fit in (the
+// tightest of several tries), i.e. the read uncertainty of that anchor.
+// ClockMap converts any timestamp between domains from those anchors.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+enum class ClockDomain : uint8_t { Monotonic, Boottime, Realtime };
+
+// mono|monotonic, boot|boottime, real|realtime
+bool parse_clock_domain(const std::string& s, ClockDomain& d);
+const char* clock_domain_name(ClockDomain d);
+
+int64_t clock_ns(ClockDomain d);
+
+struct ClockAnchor {
+    int64_t mono_ns = 0;
+    int64_t boot_ns = 0;
+    int64_t real_ns = 0;
+    int64_t unc_ns = 0;
+
+    int64_t get(ClockDomain d) const {
+        return d == ClockDomain::Monotonic ? mono_ns : d == ClockDomain::Boottime ? boot_ns : real_ns;
+    }
+};
+
+// Read BOOTTIME and REALTIME between two MONOTONIC reads; keep the tightest
+// of `tries` windows.
+ClockAnchor read_anchor(int tries = 7);
+
+void append_anchor_header(std::string& out);
+void append_anchor(std::string& out, const ClockAnchor& a);
+bool load_anchors(const std::string& path, std::vector<ClockAnchor>& out, std::string& err);
+
+// Piecewise-linear mapping between the anchors that bracket a timestamp, so
+// NTP slewing between anchors is followed. An offset change faster than
+// kStepPpm between two anchors is a step (suspend for BOOTTIME, a settime for
+// REALTIME) rather than a rate: the earlier anchor's offset is held up to the
+// later anchor. Outside the anchored range the nearest anchor's offset applies.
+class ClockMap {
+public:
+    static constexpr double kStepPpm = 1000.0;
+
+    explicit ClockMap(std::vector<ClockAnchor> anchors);
+    bool empty() const { return a_.empty(); }
+    size_t size() const { return a_.size(); }
+
+    // unc (optional): read uncertainty of the anchors used.
+    int64_t convert(int64_t ts, ClockDomain from, ClockDomain to, int64_t* unc = nullptr) const;
+
+private:
+    std::vector<ClockAnchor> a_;
+    bool sorted_[3] = {true, true, true};
+};
+
+} // namespace dvfs
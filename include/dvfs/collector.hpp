@@ -0,0 +1,100 @@
+// dvfs/collector.hpp
+// Fleet collector: ingests many board streams (dvfs/stream.hpp) and writes
+// one merged, time-ordered CSV:
+//
+//   board,ts_ns,src_ts_ns,<columns>
+//
+// ts_ns is the board timestamp mapped onto the collector's CLOCK_MONOTONIC
+// (src_ts_ns - offset from the board's latest Clock frame); src_ts_ns is the
+// board's own. The column set is the first board's; later boards are matched
+// by name (missing -> empty, extra -> dropped).
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dvfs/writer.hpp"
+
+namespace dvfs {
+
+// Rows are held per board and emitted in ts order once every live board has
+// caught up (k-way merge); a board that lags more than max_lag_ns behind the
+// newest row stops holding the others back.
+class MergeStore {
+public:
+    explicit MergeStore(int64_t max_lag_ns = 2000000000LL) : max_lag_ns_(max_lag_ns) {}
+
+    bool open(const std::string& path);
+    // Register a stream; returns its board id. Extra columns are reported in dropped.
+    int add_board(const std::string& name, const std::vector<std::string>& cols,
+                  std::vector<std::string>& dropped);
+    // nrows rows of the board's columns; ts aligned as src_ts - offset_ns.
+    void push(int board, const int64_t* src_ts, const double* vals, size_t nrows, int64_t offset_ns);
+    // Stream ended: its queued rows no longer wait for more.
+    void finish(int board);
+    // Emit everything still queued and close the file.
+    void close();
+
+    uint64_t rows_written() const { return written_; }
+    bool ok() const { return w_.ok(); }
+
+private:
+    struct Row {
+        int64_t ts, src;
+        std::vector<double> v;
+    };
+    struct Board {
+        std::string name;
+        std::vector<int> map;    // board column -> store column (-1 = dropped)
+        std::deque<Row> q;
+        bool done = false;
+    };
+    void pump(bool drain);
+
+    std::mutex mu_;
+    BufWriter w_;
+    std::vector<std::string> cols_;
+    std::deque<Board> boards_;
+    int64_t newest_ = INT64_MIN;
+    int64_t max_lag_ns_;
+    uint64_t written_ = 0;
+    std::string line_;
+};
+
+// One epoll loop per thread, each on its own SO_REUSEPORT listener, so the
+// kernel spreads connections across threads.
+class Collector {
+public:
+    explicit Collector(MergeStore& store) : store_(store) {}
+    ~Collector() { stop(); }
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
+
+    // port 0 picks an ephemeral port (see port()); threads <= 0 = one per core.
+    bool start(int port, int threads, std::string& err);
+    void stop();
+    int port() const { return port_; }
+
+    // Connection / clock / error notes (called from worker threads).
+    std::function<void(const std::string&)> on_event;
+
+private:
+    void worker(int listen_fd);
+    void note(const std::string& msg);
+
+    MergeStore& store_;
+    std::vector<int> listeners_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_{false};
+    std::mutex note_mu_;
+    int port_ = 0;
+};
+
+} // namespace dvfs
@@ -0,0 +1,52 @@
+// dvfs/controller.hpp
+// CPU/GPU frequency actuation through cpufreq / devfreq sysfs limits.
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+// One planned sysfs write. An empty value means "skip" (note says why).
+struct SysfsWrite {
+    std::string path;
+    std::string value;
+    std::string note;
+};
+
+class Controller {
+public:
+    Controller(std::string cpu_dir, std::string gpu_dir);
+
+    // nullopt if the cpufreq policy or GPU devfreq dir can't be found.
+    static std::optional<Controller> discover();
+
+    const std::string& cpu_dir() const { return cpu_dir_; }
+    const std::string& gpu_dir() const { return gpu_dir_; }
+
+    // Pin both clocks: min = max = the given value.
+    std::vector<SysfsWrite> plan_lock(const std::string& cpu_khz, const std::string& gpu_hz) const;
+    // Restore full ranges (cpuinfo limits, GPU available_frequencies ends, podgov).
+    std::vector<SysfsWrite> plan_unlock() const;
+    // Perform the writes in order; one result per entry (skips count as ok).
+    static std::vector<bool> apply(const std::vector<SysfsWrite>& plan);
+
+    // In-process actuation. Writes min/max in the order that keeps min <= max
+    // at every step, so moving a range past the current one never fails.
+    bool set_cpu_range_khz(long long min_khz, long long max_khz) const;
+    bool set_gpu_range_hz(long long min_hz, long long max_hz) const;
+
+    std::optional<long long> cpu_cur_khz() const;
+    std::optional<long long> gpu_cur_hz() const;
+
+    // Available operating points, ascending.
+    std::vector<long long> cpu_opps_khz() const;
+    std::vector<long long> gpu_opps_hz() const;
+
+private:
+    std::string cpu_dir_;
+    std::string gpu_dir_;
+};
+
+} // namespace dvfs
@@ -0,0 +1,133 @@
+// dvfs/daemon.hpp
+// The clock daemon: owns the cpufreq/devfreq limits and takes frequency
+// requests from clients over a Unix stream socket; only the arbitrated
+// range (dvfs/qos.hpp) is ever written.
+//
+// Protocol: one command per line, exactly one "ok ..." or "err <msg>" line
+// back (status sends "req ..." lines before its ok).
+//
+//   hello <name>                                  name this client (default pid<N>)
+//   set <cpu|gpu> [min=<v>] [max=<v>] [prio=<n>] [cap=1]
+//   clear <cpu|gpu>
+//   get                                           ok cpu=<min>:<max> gpu=<min>:<max>
+//   opps <cpu|gpu>                                ok <v> <v> ...
+//   status                                        req <client> <dom> ... per request
+//   latency <us> [cpus=<list>] [label=<name>]     hold a wake-up latency limit
+//   latency off                                   (dvfs/latency.hpp) until off
+//
+// Values are kHz for cpu and Hz for gpu. Like a PM QoS request fd, a
+// client's requests live as long as its connection.
+//
+// Trace (--trace): one CSV line per request, drop and write:
+//   ts_ns,client,event,domain,priority,cap,min,max,eff_min,eff_max,note
+// (latency holds: domain "lat", min = the request and eff_min = the global
+// effective value in us, cpus in note).
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dvfs/latency.hpp"
+#include "dvfs/qos.hpp"
+#include "dvfs/writer.hpp"
+
+namespace dvfs {
+
+constexpr char kDaemonSocket[] = "/run/dvfs_tool.sock";
+
+class QosServer {
+public:
+    explicit QosServer(QosArbiter& arb) : arb_(arb) {}
+    ~QosServer() { close(); }
+    QosServer(const QosServer&) = delete;
+    QosServer& operator=(const QosServer&) = delete;
+
+    // Binds path (a stale socket file is replaced).
+    bool listen(const std::string& path, std::string& err);
+    bool open_trace(const std::string& path);
+    // Enables the latency command; meter (optional) costs each hold window.
+    void set_latency(LatencyQos* lat, PhaseMeter* meter) { lat_ = lat; meter_ = meter; }
+    // Write the current aggregate of every domain (the daemon takes over the
+    // limits at start); afterwards only changes are written.
+    void apply_all();
+    // Accept / serve for up to timeout_ms.
+    void poll(int timeout_ms);
+    // Drop every client, write the released range, remove the socket.
+    void close();
+
+    // In-process clients (e.g. the profile agent): arbitrated and traced
+    // exactly like a socket client named r.client / client.
+    void local_set(QosDomain d, QosRequest r);
+    void local_release(const std::string& client, const std::string& note);
+    // Poll fd alongside the socket; cb runs from poll() when it is readable.
+    void watch(int fd, std::function<void()> cb) { watches_.push_back({fd, std::move(cb)}); }
+
+    // Write a new effective range; false = write failed (traced).
+    std::function<bool(QosDomain, const QosRange&)> on_apply;
+    // Connects, requests, drops and writes, one line each.
+    std::function<void(const std::string&)> on_event;
+
+    QosRange applied(QosDomain d) const { return applied_[(int)d]; }
+
+private:
+    struct Conn {
+        int fd = -1;
+        std::string name;
+        std::string in;
+        bool dead = false;
+    };
+    void handle(Conn& c, const std::string& line);
+    void reply(Conn& c, const std::string& line);
+    void drop(Conn& c);
+    // Re-aggregate d and write it when it changed.
+    void update(QosDomain d, const std::string& client);
+    void write(QosDomain d, const QosResult& res);
+    void trace(const std::string& client, const char* event, QosDomain d, const QosRequest* r,
+               const std::string& note);
+    void trace_latency(const std::string& client, const char* event, int us, const std::string& note);
+    void end_latency(Conn& c);
+
+    QosArbiter& arb_;
+    int lfd_ = -1;
+    std::string path_;
+    std::vector<std::unique_ptr<Conn>> conns_;
+    QosRange applied_[kQosDomains];
+    BufWriter tw_{4096};
+    bool tracing_ = false;
+    LatencyQos* lat_ = nullptr;
+    PhaseMeter* meter_ = nullptr;
+    std::vector<std::pair<int, std::function<void()>>> watches_;
+};
+
+// Blocking client side of the protocol.
+class QosClient {
+public:
+    ~QosClient() { close(); }
+
+    bool connect(const std::string& path, const std::string& name, std::string& err);
+    void close();
+    bool connected() const { return fd_ >= 0; }
+
+    // One command; reply = text after "ok " (false + err on "err ..." or I/O
+    // failure). status-style extra lines go to lines.
+    bool call(const std::string& cmd, std::string& reply, std::string& err,
+              std::vector<std::string>* lines = nullptr);
+
+private:
+    bool read_line(std::string& line);
+
+    int fd_ = -1;
+    std::string in_;
+};
+
+// The effective range of d in a get / set reply ("cpu=<min>:<max> gpu=...").
+bool parse_qos_reply(const std::string& reply, QosDomain d, QosRange& out);
+// Clock a client pinned at v actually gets under the effective range r
+// (0 = unbounded side): v clamped into it, so a cap or a higher-priority
+// request shows up as a lower (or higher) clock.
+long long qos_in_force(long long v, const QosRange& r);
+
+} // namespace dvfs
@@ -0,0 +1,50 @@
+// dvfs/deadline.hpp
+// Deadline-aware per-frame DVFS for periodic pipelines. After each frame
+// (a "<span>:begin" ... "<span>:end" pair) the governor turns its busy time
+// at the clock it ran at into work (busy x f, i.e. cycles as if fully
+// clock-bound), predicts the next frame's work from recent history and picks
+// the lowest OPP whose predicted busy time fits the deadline minus a slack
+// margin:
+//
+//   W_pred = max(W_last, mean + k * sd)        (EWMA mean / variance)
+//   f      = lowest OPP with W_pred / f <= deadline * (1 - margin)
+//
+// Treating all time as clock-bound overestimates the work when moving down
+// (memory stalls do not stretch) and underestimates it when moving up; the
+// margin and k absorb the latter.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace dvfs {
+
+struct FrameGovParams {
+    double deadline_s = 0;
+    double margin = 0.1;   // fraction of the deadline kept as slack
+    double k_sd = 2.0;     // standard deviations of headroom
+    double alpha = 0.25;   // EWMA weight of the newest frame
+};
+
+class FrameGovernor {
+public:
+    // OPP table ascending (kHz or Hz; only ratios matter). Starts at the top.
+    FrameGovernor(std::vector<long long> opps, FrameGovParams p);
+
+    // The frame that just ended ran at opp for busy_s; returns the OPP for
+    // the next one.
+    long long frame(long long opp, double busy_s);
+
+    long long opp() const { return opps_[cur_]; }
+    // Predicted busy time of the next frame at the chosen OPP.
+    double predicted_s() const { return pred_ / (double)opps_[cur_]; }
+
+private:
+    std::vector<long long> opps_;
+    FrameGovParams p_;
+    size_t cur_ = 0;
+    int n_ = 0;
+    double mean_ = 0, var_ = 0, pred_ = 0;
+};
+
+} // namespace dvfs
@@ -0,0 +1,72 @@
+// dvfs/derive.hpp
+// Derived columns: tiny expression language -> bytecode.
+//
+// A derive spec is "name=expr". The expression is parsed once into a
+// postfix bytecode program; evaluation runs each instruction over a whole
+// column batch (kDeriveBatch rows) so the per-row cost is a tight loop.
+// Missing values are NaN and propagate; NaN is written as an empty field.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+constexpr size_t kDeriveBatch = 256;
+
+enum class DOp : uint8_t { Col, Const, Add, Sub, Mul, Div, Neg, Abs, Min, Max, Clamp, Diff, Ewma };
+
+struct DInsn {
+    DOp op;
+    int arg = 0;       // column index (Col) or state slot (Diff/Ewma)
+    double k = 0.0;    // constant (Const) or alpha (Ewma)
+};
+
+struct DeriveExpr {
+    std::string name;
+    std::vector<DInsn> code;
+    int stack_max = 0;
+    std::vector<double> state;   // per stateful instruction, carried across batches
+    std::vector<double> stack;   // stack_max * kDeriveBatch
+};
+
+// Compile "name=expr" against the visible column names.
+bool compile_derive(const std::string& spec, const std::vector<std::string>& cols,
+                    DeriveExpr& out, std::string& err);
+
+// Run one program over n <= kDeriveBatch rows. cols[i] points at column i's batch.
+void eval_derive(DeriveExpr& d, const double* const* cols, size_t n, double* out);
+
+// A set of derive programs evaluated in order; each may reference base
+// columns and any earlier derived column.
+class DeriveSet {
+public:
+    explicit DeriveSet(std::vector<std::string> base_cols) : names_(std::move(base_cols)), nbase_(names_.size()) {}
+
+    bool add(const std::string& spec, std::string& err);
+
+    bool empty() const { return exprs_.empty(); }
+    size_t size() const { return exprs_.size(); }
+    const std::string& name(size_t i) const { return exprs_[i].name; }
+    const double* out(size_t i) const { return outs_[i].data(); }
+
+    // Which base columns any program reads (lets callers skip the rest).
+    std::vector<bool> base_refs() const;
+
+    // base[i] points at base column i's batch of n rows.
+    void eval(const double* const* base, size_t n);
+
+private:
+    std::vector<std::string> names_;
+    size_t nbase_;
+    std::vector<DeriveExpr> exprs_;
+    std::vector<std::vector<double>> outs_;
+    std::vector<const double*> ptrs_;
+};
+
+// Add every spec in order; err names the first failing spec.
+bool build_derive_set(DeriveSet& ds, const std::vector<std::string>& specs, std::string& err);
+
+} // namespace dvfs
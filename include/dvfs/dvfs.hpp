@@ -0,0 +1,38 @@
+// dvfs/dvfs.hpp
+// libdvfs: sysfs discovery, sampling, power reading, actuation and its
+// arbitration daemon, writers and fleet streaming for Jetson Orin DVFS work.
+// dvfs_tool (src/dvfs_tool.cpp) is the CLI on top: argument parsing, output
+// and the subcommand drivers, with analyze's CSV scan and the bench harnesses.
+#pragma once
+
+#include "dvfs/budget.hpp"
+#include "dvfs/capper.hpp"
+#include "dvfs/clocks.hpp"
+#include "dvfs/collector.hpp"
+#include "dvfs/controller.hpp"
+#include "dvfs/daemon.hpp"
+#include "dvfs/deadline.hpp"
+#include "dvfs/derive.hpp"
+#include "dvfs/edp.hpp"
+#include "dvfs/filter.hpp"
+#include "dvfs/frame.hpp"
+#include "dvfs/latency.hpp"
+#include "dvfs/linfit.hpp"
+#include "dvfs/markers.hpp"
+#include "dvfs/meter.hpp"
+#include "dvfs/pacing.hpp"
+#include "dvfs/power.hpp"
+#include "dvfs/procmon.hpp"
+#include "dvfs/profiles.hpp"
+#include "dvfs/psi.hpp"
+#include "dvfs/qos.hpp"
+#include "dvfs/rpm.hpp"
+#include "dvfs/schema.hpp"
+#include "dvfs/sensors.hpp"
+#include "dvfs/stream.hpp"
+#include "dvfs/sysfs.hpp"
+#include "dvfs/topology.hpp"
+#include "dvfs/tuner.hpp"
+#include "dvfs/uclamp.hpp"
+#include "dvfs/util.hpp"
+#include "dvfs/writer.hpp"
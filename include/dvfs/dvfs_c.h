@@ -0,0 +1,116 @@
+/* dvfs/dvfs_c.h
+ * Stable C ABI over the libdvfs sampler (libdvfs_c.so), for bindings that
+ * want live power/frequency samples without parsing CSV from a subprocess.
+ *
+ * A dvfs_sampler is an opaque handle owning a Sampler and a background
+ * thread that samples every period_ms into a ring of the last
+ * DVFS_RING_ROWS rows. Consumers either poll the latest row or drain every
+ * row since their last read with one call per batch:
+ *
+ *   dvfs_sampler* h = dvfs_sampler_create(NULL, 100);
+ *   dvfs_sampler_start(h);
+ *   uint64_t seq = 0;
+ *   int n = dvfs_sampler_read(h, &seq, ts, vals, 64);   // vals: 64 * ncols
+ *   dvfs_sampler_mark(h, "phase:decode");
+ *   dvfs_sampler_destroy(h);                            // stops if running
+ *
+ * Values are doubles in column order (dvfs_sampler_column); NaN = missing.
+ * Text columns (e.g. cpu_governor) are NaN here; use dvfs_sampler_text.
+ * Functions returning int use 0 / a count on success and a negative
+ * DVFS_E_* code on failure; dvfs_last_error() describes the last failure
+ * on the calling thread. All functions are thread-safe per handle.
+ * No C++ exception ever escapes: an internal failure (out of memory, thread
+ * creation, ...) is reported as DVFS_E_INTERNAL, or NULL from
+ * dvfs_sampler_create; one inside the sampling thread stops sampling.
+ *
+ * Compatibility: only additions are made within one DVFS_C_ABI_VERSION.
+ * Structs carry struct_size so fields can be appended later.
+ */
+#ifndef DVFS_DVFS_C_H
+#define DVFS_DVFS_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(DVFS_C_BUILD)
+#define DVFS_C_API __attribute__((visibility("default")))
+#else
+#define DVFS_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DVFS_C_ABI_VERSION 1
+#define DVFS_RING_ROWS 4096
+
+/* Error codes mirror dvfs_tool exit codes where they overlap. */
+enum {
+    DVFS_OK = 0,
+    DVFS_E_OPEN = -1,     /* config file could not be read */
+    DVFS_E_ARG = -2,      /* bad argument / config / state */
+    DVFS_E_DISCOVER = -3, /* sensors could not be resolved */
+    DVFS_E_NODATA = -5,   /* no sample taken yet */
+    DVFS_E_INTERNAL = -6  /* internal failure (C++ exception caught at the boundary) */
+};
+
+typedef struct dvfs_sampler dvfs_sampler;
+
+/* Latest row. values must hold `capacity` doubles; ncols is the number of
+ * columns available (min(ncols, capacity) are written). */
+typedef struct dvfs_sample {
+    uint32_t struct_size; /* in: sizeof(dvfs_sample) */
+    uint32_t capacity;    /* in: length of values */
+    double* values;       /* in: caller buffer */
+    uint32_t ncols;       /* out */
+    uint32_t reserved;
+    uint64_t seq;         /* out: 1-based sample number */
+    int64_t ts_ns;        /* out: CLOCK_MONOTONIC */
+    int64_t dt_ns;        /* out */
+} dvfs_sample;
+
+typedef struct dvfs_marker {
+    uint32_t struct_size; /* in: sizeof(dvfs_marker) */
+    uint32_t reserved;
+    uint64_t seq;         /* out: last sample seq at registration (0 = none) */
+    int64_t ts_ns;        /* out: CLOCK_MONOTONIC at registration */
+    char label[64];       /* out: NUL-terminated, truncated */
+} dvfs_marker;
+
+DVFS_C_API int dvfs_abi_version(void);
+DVFS_C_API const char* dvfs_last_error(void);
+
+/* sensor_config: path to a --sensors registry file, NULL = built-in set.
+ * Returns NULL on failure (see dvfs_last_error). */
+DVFS_C_API dvfs_sampler* dvfs_sampler_create(const char* sensor_config, int period_ms);
+DVFS_C_API void dvfs_sampler_destroy(dvfs_sampler* h);
+
+DVFS_C_API int dvfs_sampler_ncols(const dvfs_sampler* h);
+/* Column name; NULL if out of range. Valid for the handle's lifetime. */
+DVFS_C_API const char* dvfs_sampler_column(const dvfs_sampler* h, int col);
+/* Column index by name; DVFS_E_ARG if absent. */
+DVFS_C_API int dvfs_sampler_column_index(const dvfs_sampler* h, const char* name);
+
+DVFS_C_API int dvfs_sampler_start(dvfs_sampler* h);
+DVFS_C_API int dvfs_sampler_stop(dvfs_sampler* h);
+
+DVFS_C_API int dvfs_sampler_latest(dvfs_sampler* h, dvfs_sample* out);
+/* Copy up to max_rows rows newer than *seq into ts_ns[max_rows] (may be
+ * NULL) and values[max_rows * ncols], oldest first; advances *seq. Rows that
+ * fell out of the ring are skipped. Returns the row count. */
+DVFS_C_API int dvfs_sampler_read(dvfs_sampler* h, uint64_t* seq, int64_t* ts_ns,
+                                 double* values, int max_rows);
+/* Latest text of a text column into buf (NUL-terminated); returns its length. */
+DVFS_C_API int dvfs_sampler_text(dvfs_sampler* h, int col, char* buf, size_t len);
+
+/* Record a phase marker at the current time. */
+DVFS_C_API int dvfs_sampler_mark(dvfs_sampler* h, const char* label);
+/* Pop the oldest pending marker; returns 1 if one was written, 0 if none. */
+DVFS_C_API int dvfs_sampler_next_marker(dvfs_sampler* h, dvfs_marker* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DVFS_DVFS_C_H */
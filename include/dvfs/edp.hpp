@@ -0,0 +1,84 @@
+// dvfs/edp.hpp
+// Online energy-delay minimizer for batch work: hill-climbs the (CPU OPP,
+// GPU OPP) grid toward the lowest
+//
+//   cost = (E / W) * (T / W)^k        k = 1: EDP, k = 2: ED^2P
+//
+// per measurement window (E energy, T time, W units of progress: heartbeats
+// or instructions retired). Like the capper it only decides; the chosen
+// point is pinned through the daemon (dvfs/daemon.hpp).
+//
+// Search: a coordinate pattern search from the top OPPs. Probe the
+// neighbours of the centre at +-stride per domain (lower ones first), move
+// to the first one cheaper by > margin, halve the stride when none is and
+// settle at stride 1. The first windows after each move are discarded
+// (settle) so the transition is not charged to the new point. Once settled,
+// progress rate and power are watched: two windows in a row more than phase
+// off the settled reference mean a new workload phase, and the search
+// restarts from where it is. A point the daemon clips is never measured:
+// it costs infinity, and a clipped centre moves to the point that did run.
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dvfs {
+
+struct EdpParams {
+    int exponent = 1;       // 1 = EDP, 2 = ED^2P
+    double margin = 0.03;   // relative improvement needed to move
+    double phase = 0.25;    // relative rate / power change that re-explores
+    int settle = 1;         // windows discarded after each move
+};
+
+class EdpClimber {
+public:
+    // OPP tables ascending; an empty table leaves that domain alone.
+    EdpClimber(std::vector<long long> cpu_opps, std::vector<long long> gpu_opps, EdpParams p = {});
+
+    // One window (mJ, s, work units). True + note when the point moved; the
+    // caller pins cpu_khz() / gpu_hz() before the next window.
+    bool step(double mj, double s, double work, std::string& note);
+    // The daemon clipped the current point to cpu_khz / gpu_hz (a cap or a
+    // higher-priority client; 0 = that domain unchanged). The point costs
+    // infinity; a clipped probe moves on to the next one, a clipped centre
+    // is replaced by the OPP point actually in force. False if that is the
+    // current point already.
+    bool clipped(long long cpu_khz, long long gpu_hz, std::string& note);
+
+    long long cpu_khz() const { return cpu_.empty() ? 0 : cpu_[ci_]; }
+    long long gpu_hz() const { return gpu_.empty() ? 0 : gpu_[gi_]; }
+    bool settled() const { return settled_; }
+    // Cost of the last window (NaN when it was discarded).
+    double last_cost() const { return last_; }
+    const char* state() const { return settled_ ? "settled" : skip_ > 0 ? "settle" : "probe"; }
+
+private:
+    using Point = std::pair<size_t, size_t>;
+    double cost(double mj, double s, double work) const;
+    void explore(bool reset_strides);
+    // Move to the next unmeasured neighbour of the centre; false if none.
+    bool next_probe();
+    bool move_to(const Point& p);
+    // Probe the next point, or settle on the centre when none is left.
+    bool advance(double c, std::string& note);
+
+    std::vector<long long> cpu_, gpu_;
+    EdpParams p_;
+    size_t ci_ = 0, gi_ = 0;
+    Point centre_;
+    size_t cs_ = 1, gs_ = 1;              // strides
+    std::map<Point, double> cost_;        // measured this exploration
+    bool settled_ = false;
+    int skip_ = 0;
+    double last_;
+    double ref_rate_ = 0.0, ref_mw_ = 0.0;
+    int ref_n_ = 0;
+    int off_ = 0;
+};
+
+bool parse_edp_metric(const std::string& s, int& exponent);  // "edp" / "ed2p"
+
+} // namespace dvfs
@@ -0,0 +1,91 @@
+// dvfs/filter.hpp
+// Online sensor filters (median glitch rejection / EWMA / Kalman).
+//
+// --filter '<col>:<stage>[+<stage>...]' adds a "<col>_f" column next to the
+// raw one. Stages run in order on each new value; state is a few doubles and
+// a small ring, and dispatch is a switch over a flat stage array (no heap or
+// virtual calls per value); dvfs_tool bench --filter measures the cost per
+// value of a chain. Text columns cannot be filtered.
+//   median(N)   median of the last N values (N odd, <= 9): rejects single-sample glitches
+//   ewma(a)     exponential moving average, 0 < a <= 1
+//   kalman(q,r) scalar random-walk Kalman filter; q = process noise, r = measurement noise
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+constexpr int kMedianMax = 9;
+
+enum class FStage : uint8_t { Median, Ewma, Kalman };
+
+struct FilterStage {
+    FStage kind;
+    int n = 0;                 // median window
+    double a = 0.0;            // ewma alpha / kalman q
+    double r = 0.0;            // kalman r
+    // state
+    double ring[kMedianMax] = {};
+    int fill = 0, head = 0;
+    double x = std::nan("");   // ewma / kalman estimate
+    double p = 0.0;            // kalman variance
+
+    double step(double v) {
+        switch (kind) {
+        case FStage::Median: {
+            ring[head] = v;
+            head = (head + 1) % n;
+            if (fill < n) fill++;
+            double w[kMedianMax];
+            std::memcpy(w, ring, sizeof(double) * (size_t)fill);
+            // insertion sort: fill <= 9
+            for (int i = 1; i < fill; ++i) {
+                double t = w[i];
+                int j = i - 1;
+                while (j >= 0 && w[j] > t) { w[j + 1] = w[j]; j--; }
+                w[j + 1] = t;
+            }
+            return w[fill / 2];
+        }
+        case FStage::Ewma:
+            x = std::isnan(x) ? v : x + a * (v - x);
+            return x;
+        case FStage::Kalman: {
+            if (std::isnan(x)) { x = v; p = r; return x; }
+            p += a;
+            const double k = p / (p + r);
+            x += k * (v - x);
+            p *= (1.0 - k);
+            return x;
+        }
+        }
+        return v;
+    }
+};
+
+struct SensorFilter {
+    std::string col;
+    int col_idx = -1;
+    std::vector<FilterStage> stages;
+
+    // Missing input -> missing output; state is left untouched.
+    double step(double v) {
+        if (std::isnan(v)) return v;
+        for (auto& s : stages) v = s.step(v);
+        return v;
+    }
+};
+
+// Parse "col:median(5)+kalman(1,100)" against the visible columns.
+bool parse_filter(const std::string& spec, const std::vector<std::string>& cols,
+                  SensorFilter& f, std::string& err);
+
+// Parse every spec in order; err names the first failing spec.
+bool build_filters(std::vector<SensorFilter>& out, const std::vector<std::string>& cols,
+                   const std::vector<std::string>& specs, std::string& err);
+
+} // namespace dvfs
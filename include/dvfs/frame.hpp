@@ -0,0 +1,184 @@
+// dvfs/frame.hpp
+// Columnar frame for analyze queries (--where / --group-by).
+//
+// The CSV text is loaded once into an arena; columns are parsed lazily on
+// first reference into typed arrays (int32 / int64 / double, or int32
+// dictionary codes for text), also arena-allocated. Missing values use a
+// per-type sentinel so the hot loops stay branch-light.
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+class Arena {
+public:
+    explicit Arena(size_t chunk = 1 << 20) : chunk_(chunk) {}
+
+    template <typename T>
+    T* alloc(size_t n) {
+        const size_t bytes = n * sizeof(T);
+        const size_t align = alignof(T) < 16 ? 16 : alignof(T);
+        used_ = (used_ + align - 1) & ~(align - 1);
+        if (blocks_.empty() || used_ + bytes > cap_) {
+            cap_ = bytes > chunk_ ? bytes : chunk_;
+            blocks_.emplace_back(new char[cap_]);
+            used_ = 0;
+        }
+        T* p = reinterpret_cast<T*>(blocks_.back().get() + used_);
+        used_ += bytes;
+        return p;
+    }
+
+private:
+    size_t chunk_;
+    size_t cap_ = 0;
+    size_t used_ = 0;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+};
+
+enum class ColType : uint8_t { I32, I64, F64, Dict };
+
+struct FrameCol {
+    std::string name;
+    ColType type = ColType::F64;
+    void* data = nullptr;
+    std::vector<std::string> dict;   // Dict only: code -> text
+
+    // Scalar view for output / grouping (NaN when missing).
+    double get(size_t r) const {
+        switch (type) {
+        case ColType::I32: { auto v = static_cast<const int32_t*>(data)[r]; return v == kMissI32 ? std::nan("") : (double)v; }
+        case ColType::I64: { auto v = static_cast<const int64_t*>(data)[r]; return v == kMissI64 ? std::nan("") : (double)v; }
+        case ColType::F64: return static_cast<const double*>(data)[r];
+        case ColType::Dict: { auto v = static_cast<const int32_t*>(data)[r]; return v < 0 ? std::nan("") : (double)v; }
+        }
+        return std::nan("");
+    }
+};
+
+// Calls fn(const T* data, T missing) with the column's concrete element type.
+template <typename Fn>
+void visit_col(const FrameCol& c, Fn&& fn) {
+    switch (c.type) {
+    case ColType::I32:  fn(static_cast<const int32_t*>(c.data), kMissI32); break;
+    case ColType::Dict: fn(static_cast<const int32_t*>(c.data), (int32_t)-1); break;
+    case ColType::I64:  fn(static_cast<const int64_t*>(c.data), kMissI64); break;
+    case ColType::F64:  fn(static_cast<const double*>(c.data), std::nan("")); break;
+    }
+}
+
+class Frame {
+public:
+    // Load the CSV text and index rows; no column is parsed yet.
+    bool load(const std::string& path, std::string& err);
+
+    size_t rows() const { return nrows_; }
+    const std::vector<std::string>& names() const { return names_; }
+
+    int index(const std::string& name) const {
+        for (size_t i = 0; i < names_.size(); ++i) if (names_[i] == name) return (int)i;
+        return -1;
+    }
+
+    // Lazily parse column by name; nullptr if unknown.
+    const FrameCol* col(const std::string& name);
+
+    // Attach a computed double column (e.g. from --derive).
+    const FrameCol* add_f64(const std::string& name, double*& data);
+
+private:
+    // Field [b, e) of column c in row r.
+    void field(size_t r, size_t c, const char*& b, const char*& e) const;
+    FrameCol* parse_col(size_t c);
+
+    Arena arena_;
+    char* text_ = nullptr;
+    const char* end_ = nullptr;
+    uint64_t* rows_ = nullptr;
+    size_t nrows_ = 0;
+    std::vector<std::string> names_;
+    std::vector<FrameCol*> cols_;
+    std::vector<std::unique_ptr<FrameCol>> owned_;
+};
+
+// ---- where predicates ----
+enum class CmpOp : uint8_t { Lt, Le, Gt, Ge, Eq, Ne };
+
+struct WherePred {
+    std::string col;
+    CmpOp op = CmpOp::Eq;
+    std::string rhs;
+};
+
+bool parse_where(const std::string& spec, WherePred& w);
+
+// Compacts sel[0..n) to the rows whose value satisfies (v op k); returns the new count.
+template <typename T>
+size_t filter_sel(const T* v, T miss, CmpOp op, double k, uint32_t* sel, size_t n) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t r = sel[i];
+        const T x = v[r];
+        if constexpr (std::is_floating_point_v<T>) { (void)miss; if (std::isnan(x)) continue; }
+        else { if (x == miss) continue; }
+        const double d = (double)x;
+        bool keep = false;
+        switch (op) {
+        case CmpOp::Lt: keep = d <  k; break;
+        case CmpOp::Le: keep = d <= k; break;
+        case CmpOp::Gt: keep = d >  k; break;
+        case CmpOp::Ge: keep = d >= k; break;
+        case CmpOp::Eq: keep = d == k; break;
+        case CmpOp::Ne: keep = d != k; break;
+        }
+        sel[m] = r;
+        m += keep;
+    }
+    return m;
+}
+
+// ---- aggregates ----
+enum class AggFn : uint8_t { Count, Sum, Mean, Min, Max };
+
+struct AggSpec {
+    AggFn fn = AggFn::Count;
+    std::string col;    // empty for bare count
+    std::string label;
+};
+
+bool parse_agg(const std::string& spec, AggSpec& a);
+
+struct AggAcc {
+    long long n = 0;
+    double sum = 0.0, mn = 0.0, mx = 0.0;
+    void add(double v) {
+        if (std::isnan(v)) return;
+        if (n == 0 || v < mn) mn = v;
+        if (n == 0 || v > mx) mx = v;
+        sum += v;
+        n++;
+    }
+    // rows = the group's row count: bare count / count() reports it,
+    // count(col) only the rows where col is present.
+    double result(const AggSpec& a, long long rows) const {
+        switch (a.fn) {
+        case AggFn::Count: return (double)(a.col.empty() ? rows : n);
+        case AggFn::Sum:   return n ? sum : std::nan("");
+        case AggFn::Mean:  return n ? sum / (double)n : std::nan("");
+        case AggFn::Min:   return n ? mn : std::nan("");
+        case AggFn::Max:   return n ? mx : std::nan("");
+        }
+        return std::nan("");
+    }
+};
+
+} // namespace dvfs
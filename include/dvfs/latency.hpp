@@ -0,0 +1,124 @@
+// dvfs/latency.hpp
+// CPU wake-up latency QoS for latency-critical phases: deep idle states
+// (c7 on Orin) are kept out of reach while a phase is held.
+//
+// Requests come from daemon clients; per target the smallest latency wins
+// (as in kernel PM QoS):
+//   no cpus  -> /dev/cpu_dma_latency (global; held open while any request
+//               exists, the value rewritten in place)
+//   cpus     -> cpu<N>/power/pm_qos_resume_latency_us per listed CPU (the
+//               original value is restored on release; 0 us = "n/a", i.e.
+//               no idle state at all)
+//
+// PhaseMeter turns each hold window into one cost line: mean power during
+// the window against the power seen while nothing was held, and the share of
+// CPU time spent in the idle states the hold disables (exit latency above
+// the request), in the window and outside:
+//   start_ns,end_ns,client,label,latency_us,cpus,dur_ms,mean_mw,baseline_mw,
+//   extra_mj,deep_idle_pct,baseline_deep_idle_pct
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dvfs/writer.hpp"
+
+namespace dvfs {
+
+constexpr char kCpuRoot[] = "/sys/devices/system/cpu";
+constexpr char kDmaLatencyDev[] = "/dev/cpu_dma_latency";
+
+// "0-3,5" -> {0,1,2,3,5}; false on junk.
+bool parse_cpu_list(const std::string& s, std::vector<int>& out);
+std::string format_cpu_list(const std::vector<int>& cpus);
+// <cpu_root>/online, else cpu0.
+std::vector<int> online_cpus(const std::string& cpu_root);
+
+struct IdleState {
+    std::string name;
+    int latency_us = 0;
+};
+// cpu<N>/cpuidle/state*, in state order.
+std::vector<IdleState> idle_states(const std::string& cpu_root, int cpu);
+// Residency per state index summed over cpus (us; missing files count 0).
+std::vector<long long> idle_time_us(const std::string& cpu_root, const std::vector<int>& cpus, size_t nstates);
+
+class LatencyQos {
+public:
+    explicit LatencyQos(std::string cpu_root = kCpuRoot, std::string dma_dev = kDmaLatencyDev)
+        : cpu_root_(std::move(cpu_root)), dma_dev_(std::move(dma_dev)) {}
+    ~LatencyQos() { release_all(); }
+    LatencyQos(const LatencyQos&) = delete;
+    LatencyQos& operator=(const LatencyQos&) = delete;
+
+    // Dry-run: aggregate and report, write nothing.
+    void set_dry_run(bool v) { dry_ = v; }
+
+    // Add or replace client's request; cpus empty = global.
+    bool request(const std::string& client, int us, std::vector<int> cpus, std::string& err);
+    // false if client held nothing.
+    bool drop(const std::string& client, std::string& err);
+    void release_all();
+
+    bool held() const { return !reqs_.empty(); }
+    // Effective values: global (-1 = none) and per CPU.
+    int global_us() const { return global_; }
+    const std::map<int, int>& cpu_us() const { return cpu_; }
+    const std::string& cpu_root() const { return cpu_root_; }
+
+private:
+    struct Req {
+        int us;
+        std::vector<int> cpus;
+    };
+    bool apply(std::string& err);
+
+    std::string cpu_root_, dma_dev_;
+    bool dry_ = false;
+    std::map<std::string, Req> reqs_;
+    int dma_fd_ = -1;
+    int global_ = -1;
+    std::map<int, int> cpu_;                // cpu -> effective us
+    std::map<int, std::string> saved_;      // cpu -> original attribute text
+};
+
+class PhaseMeter {
+public:
+    explicit PhaseMeter(std::string cpu_root = kCpuRoot);
+
+    bool open(const std::string& path);
+
+    // Once per daemon tick: power in mW (NaN = no rail), held = any latency
+    // request active. Accumulates open windows and the unheld baseline.
+    void tick(int64_t ts_ns, double mw, bool held);
+    void begin(const std::string& client, const std::string& label, int us, const std::vector<int>& cpus);
+    // Closes client's window; returns its cost line ("" if none open).
+    std::string end(const std::string& client);
+
+private:
+    struct Window {
+        std::string label;
+        int us = 0;
+        std::vector<int> cpus;
+        int64_t t0 = 0;
+        double e_mws = 0.0, p_s = 0.0;  // energy (mW*s) and seconds with power
+        std::vector<long long> idle0;   // residency snapshot at begin (all online cpus)
+    };
+    double deep_share(const std::vector<long long>& d, int us, double wall_us) const;
+
+    std::string root_;
+    std::vector<int> cpus_;
+    std::vector<IdleState> states_;
+    std::map<std::string, Window> open_;
+    int64_t last_ts_ = 0;
+    std::vector<long long> last_idle_;
+    // Unheld baseline, exponentially forgotten over ~30 s.
+    double base_e_ = 0.0, base_p_ = 0.0, base_wall_us_ = 0.0;
+    std::vector<double> base_idle_;
+    BufWriter w_{4096};
+    bool logging_ = false;
+};
+
+} // namespace dvfs
@@ -0,0 +1,53 @@
+// dvfs/linfit.hpp
+// Multiple linear regression for power models, e.g.
+//
+//   vdd_cpu_gpu_cv_mW ~ gpu_hz + gpu_load + gpu_gated_pct
+//
+// fitted by ordinary least squares over the rows where every term is
+// present. Regressors are centred and scaled before solving the normal
+// equations, so Hz-sized and percent-sized columns mix without losing
+// precision; coefficients are reported in the original units.
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+struct LinFit {
+    std::vector<double> coef;   // intercept, then one per regressor
+    std::vector<double> mean;   // per regressor, over the fitted rows
+    double y_mean = 0.0;
+    double r2 = 0.0;
+    double rmse = 0.0;
+    size_t n = 0;
+};
+
+// "y ~ a + b + c" -> y, {a, b, c}; false if malformed.
+bool parse_fit_formula(const std::string& spec, std::string& y, std::vector<std::string>& xs);
+
+// x[j] and y each point at nrows values; NaN rows are skipped. False (with
+// err) when there are too few rows, a constant regressor or collinear terms.
+bool fit_linear(const std::vector<const double*>& x, const double* y, size_t nrows,
+                LinFit& out, std::string& err);
+
+// Meter calibration: ref = gain * x + offset, with ref shifted by the lag
+// (rows, within +-max_lag) that correlates best with x. rms_raw / rms_fit
+// are the errors of ref against x before and after correcting.
+struct GainFit {
+    double gain = 1.0;
+    double offset = 0.0;
+    double r2 = 0.0;
+    double rms_raw = 0.0;
+    double rms_fit = 0.0;
+    size_t n = 0;  // rows used (set even when the fit fails)
+    int lag = 0;   // ref[i + lag] pairs with x[i]
+};
+
+// NaN in either series skips the pair. False (with err) when fewer than 3
+// pairs remain or x does not vary.
+bool fit_gain_offset(const std::vector<double>& x, const std::vector<double>& ref, int max_lag,
+                     GainFit& out, std::string& err);
+
+} // namespace dvfs
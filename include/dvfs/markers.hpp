@@ -0,0 +1,71 @@
+// dvfs/markers.hpp
+// Workload markers next to a log: the application writes one line per event
+// into a FIFO that log owns (--marker_fifo), log stamps it and appends it to
+// <out>.markers:
+//
+//   ts_ns,label
+//
+// A line is "<label>" (stamped with CLOCK_MONOTONIC on arrival) or
+// "<ts_ns> <label>" with the writer's own CLOCK_MONOTONIC stamp. Labels
+// "<name>:begin" / "<name>:end" delimit spans (e.g. infer:begin ...
+// infer:end); reports give per-span latency and energy.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dvfs {
+
+struct Marker {
+    int64_t ts_ns = 0;
+    std::string label;
+};
+
+// Parse one FIFO line; false for blank / junk. now_ns stamps bare labels.
+bool parse_marker_line(const std::string& line, int64_t now_ns, Marker& out);
+
+bool load_markers(const std::string& path, std::vector<Marker>& out, std::string& err);
+
+struct Span {
+    std::string name;
+    int64_t t0 = 0, t1 = 0;
+};
+// Pair "<name>:begin" with the next "<name>:end" (per name, in order); an
+// unmatched begin is dropped.
+std::vector<Span> marker_spans(const std::vector<Marker>& ms);
+
+// Energy (mJ) of a power series (ts_ns ascending, mW; NaN rows skipped) over
+// [t0, t1), each sample holding until the next one.
+double energy_mj(const std::vector<int64_t>& ts, const std::vector<double>& mw, int64_t t0, int64_t t1);
+
+// Creates the FIFO (if missing) and appends stamped markers to out_path from
+// a reader thread until stop().
+class MarkerFifo {
+public:
+    ~MarkerFifo() { stop(); }
+
+    // queue: also keep the markers for take() (live consumers).
+    bool start(const std::string& fifo, const std::string& out_path, std::string& err, bool queue = false);
+    void stop();
+    uint64_t count() const { return n_.load(std::memory_order_relaxed); }
+    // Markers since the last call (queue mode), appended to out.
+    void take(std::vector<Marker>& out);
+
+private:
+    void run();
+
+    int fd_ = -1;
+    int out_ = -1;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> n_{0};
+    std::thread thr_;
+    bool queue_ = false;
+    std::mutex mu_;
+    std::vector<Marker> q_;
+};
+
+} // namespace dvfs
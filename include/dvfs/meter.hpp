@@ -0,0 +1,63 @@
+// dvfs/meter.hpp
+// External reference power meter on a serial port (USB CDC / FTDI, or a pty
+// stand-in from `dvfs_tool fakemeter`).
+//
+// Line protocol: one reading per line, "<number>[ ][W|mW]" (unit defaults
+// to W); anything after the first number/unit is ignored, lines without a
+// leading number are skipped. Each reading is stamped with CLOCK_MONOTONIC
+// when its newline arrives, so it shares ts_ns with the sampler.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dvfs {
+
+// Reading in mW.
+std::optional<double> parse_meter_line(const std::string& line);
+
+// Open a serial device raw at baud (ignored for ptys); -1 + err on failure.
+int open_serial(const std::string& dev, int baud, std::string& err);
+// New pty master in raw mode; slave receives the slave device path.
+int open_pty(std::string& slave, std::string& err);
+
+class SerialMeter {
+public:
+    static constexpr int64_t kStaleNs = 1000000000LL;  // older than this = missing
+
+    // spec: "<device>[@<baud>]", e.g. /dev/ttyUSB0@115200 (default 115200).
+    explicit SerialMeter(std::string spec) : spec_(std::move(spec)) {}
+    ~SerialMeter() { stop(); }
+    SerialMeter(const SerialMeter&) = delete;
+    SerialMeter& operator=(const SerialMeter&) = delete;
+
+    bool start(std::string& err);
+    void stop();
+
+    const std::string& device() const { return dev_; }
+    // mW at ts_ns, interpolated between the bracketing readings (held at the
+    // newest one for ts after it); NaN if nothing within kStaleNs.
+    double at(int64_t ts_ns) const;
+
+private:
+    void run();
+
+    std::string spec_;
+    std::string dev_;
+    int fd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::thread thr_;
+
+    static constexpr size_t kRing = 256;
+    mutable std::mutex mu_;
+    int64_t ts_[kRing] = {};
+    double mw_[kRing] = {};
+    uint64_t n_ = 0;
+};
+
+} // namespace dvfs
@@ -0,0 +1,56 @@
+// dvfs/pacing.hpp
+// Race-to-idle versus pacing for a periodic workload (one span per period,
+// e.g. infer:begin ... infer:end every 33 ms). From the spans seen in a log
+// - busy time and mean power at the CPU clock each ran at - and the power
+// between spans, each OPP f of the table is priced per period T:
+//
+//   busy(f)   = a + b / f          (a = frequency-insensitive time, fitted
+//                                   when spans ran at >= 2 clocks)
+//   P(f)      measured mean power over spans at f, else p0 + p3 (f/fmax)^3
+//   E(f)      = P(f) busy(f) + P_idle (T - busy(f))
+//               + (P(f) - P_idle) t_tr      when slack > t_tr: waking from
+//                                           deep idle and ramping the clock
+//                                           burns active power for t_tr
+//
+// OPPs with busy(f) > T miss the period. Race-to-idle is the top OPP,
+// pacing the slowest one that still fits; the cheapest feasible row wins.
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+struct PacingObs {
+    double khz = 0;        // CPU clock during the span
+    double busy_s = 0;
+    double active_mw = 0;  // mean power over the span
+};
+
+struct PacingInput {
+    double period_s = 0;
+    double idle_mw = 0;        // mean power between spans
+    double transition_s = 0;   // t_tr
+    double mem_frac = -1.0;    // a / busy at the observed clock; < 0 = fit (or 0)
+    std::vector<PacingObs> obs;
+    std::vector<long long> opps_khz;  // ascending
+};
+
+struct PacingRow {
+    long long khz = 0;
+    double busy_s = 0, active_mw = 0;
+    bool measured = false;
+    double busy_mj = 0, idle_mj = 0, trans_mj = 0, total_mj = 0;
+    bool feasible = false;
+};
+
+struct PacingResult {
+    double a_s = 0, b_s_khz = 0;   // busy = a + b / khz
+    double p0_mw = 0, p3_mw = 0;   // P = p0 + p3 (f / fmax)^3
+    std::vector<PacingRow> rows;   // one per OPP, ascending
+    int race = -1, paced = -1, best = -1;  // row indices; -1 = none feasible
+};
+
+bool pacing_analysis(const PacingInput& in, PacingResult& out, std::string& err);
+
+} // namespace dvfs
@@ -0,0 +1,46 @@
+// dvfs/power.hpp
+// tegrastats power reader (VDD_* rails, mW).
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace dvfs {
+
+// parse: find "<key> <num>mW/" in a line, return num (mW)
+std::optional<long long> parse_mw_field(const std::string& line, const std::string& key);
+
+// Runs `tegrastats --interval N` (via sudo when not root) and keeps the latest
+// value of each requested field in a lock-free slot.
+class PowerReader {
+public:
+    explicit PowerReader(std::vector<std::string> keys);
+    ~PowerReader();
+    PowerReader(const PowerReader&) = delete;
+    PowerReader& operator=(const PowerReader&) = delete;
+
+    // Shortest --interval asked of tegrastats; start() clamps to it.
+    static constexpr int kMinIntervalMs = 10;
+
+    bool start(int interval_ms);
+    void stop();
+
+    const std::vector<std::string>& keys() const { return keys_; }
+    // Latest value of keys()[i] in mW; -1 = not seen yet.
+    long long mw(size_t i) const { return mw_[i].load(std::memory_order_relaxed); }
+
+private:
+    std::vector<std::string> keys_;
+    std::unique_ptr<std::atomic<long long>[]> mw_;
+    std::atomic<bool> stop_{false};
+    std::thread thr_;
+    pid_t pid_ = -1;
+};
+
+} // namespace dvfs
@@ -0,0 +1,43 @@
+// dvfs/procmon.hpp
+// Process exec/exit events from the netlink proc connector (needs
+// CAP_NET_ADMIN). Event timestamps are the kernel's CLOCK_MONOTONIC, so
+// now_ns() - ts_ns is the delay from exec to whatever we did about it.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+struct ProcEvent {
+    enum Kind { Exec, Exit } kind = Exec;
+    int pid = 0;   // thread id
+    int tgid = 0;  // process id
+    int64_t ts_ns = 0;
+};
+
+class ProcConnector {
+public:
+    ~ProcConnector() { close(); }
+
+    // Subscribe (PROC_CN_MCAST_LISTEN); the socket is non-blocking.
+    bool open(std::string& err);
+    void close();
+    int fd() const { return fd_; }
+
+    // Drain pending messages; thread exits are skipped (pid != tgid).
+    // Returns false if events were lost (ENOBUFS).
+    bool read(std::vector<ProcEvent>& out);
+
+private:
+    int fd_ = -1;
+};
+
+// Basename of /proc/<pid>/exe, else /proc/<pid>/comm; "" if gone.
+std::string process_name(int pid);
+
+// Pids of every process currently running.
+std::vector<int> list_pids();
+
+} // namespace dvfs
@@ -0,0 +1,92 @@
+// dvfs/profiles.hpp
+// Per-application DVFS profiles applied by the daemon (--profiles): the proc
+// connector (dvfs/procmon.hpp) reports every exec, the executable's basename
+// is looked up in the table and a match is applied on the spot; it is
+// reverted when that process exits. One profile per line, key=value:
+//
+//   exe=ffmpeg      cpu_min_khz=1497600 gpu_min_hz=612000000 prio=5
+//   exe=batch_job   cpu_max_khz=1113600 cap=1 uclamp_max=25%
+//   exe=infer       uclamp_min=512
+//
+//   cpu_min_khz cpu_max_khz gpu_min_hz gpu_max_hz   a request on the daemon
+//                               (client "profile:<exe>:<pid>"), at prio=<n>;
+//                               cap=1 turns the maxes into caps
+//   uclamp_min uclamp_max      every thread of the process (dvfs/uclamp.hpp);
+//                               a side not given keeps its current clamp
+//
+// Apply log (--profile_log), one line per apply / revert:
+//   ts_ns,pid,exe,event,latency_us,note
+// latency_us = from the kernel's exec/exit event to the request being in
+// force (limits written, threads clamped).
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dvfs/daemon.hpp"
+#include "dvfs/procmon.hpp"
+#include "dvfs/uclamp.hpp"
+#include "dvfs/writer.hpp"
+
+namespace dvfs {
+
+struct Profile {
+    std::string exe;
+    long long cpu_min = 0, cpu_max = 0;  // kHz; 0 = none
+    long long gpu_min = 0, gpu_max = 0;  // Hz
+    int priority = 0;
+    bool cap = false;
+    Uclamp uclamp;  // -1 = that side is left as it is (only the given side is set)
+};
+
+bool parse_profiles(const std::string& text, const std::string& origin, std::vector<Profile>& out,
+                    std::string& err);
+
+class ProfileAgent {
+public:
+    ProfileAgent(QosServer& srv, std::vector<Profile> profiles) : srv_(srv), profiles_(std::move(profiles)) {}
+    ~ProfileAgent() { stop(); }
+
+    bool open_log(const std::string& path);
+    // No uclamp writes (the QoS side is dry-run through the server).
+    void set_dry_run(bool on) { dry_ = on; }
+    // Subscribe, hook into srv.poll() and apply to matches already running.
+    bool start(std::string& err);
+    // Revert everything and unsubscribe.
+    void stop();
+
+    // Line per apply / revert for the console.
+    std::function<void(const std::string&)> on_event;
+
+    size_t active() const { return active_.size(); }
+
+private:
+    struct Active {
+        const Profile* prof = nullptr;
+        std::string client;
+        std::unique_ptr<UclampActuator> uc;
+    };
+    void drain();
+    // After lost events: revert the dead, apply to unseen matches.
+    void rescan();
+    const Profile* match(const std::string& exe) const;
+    void apply(int pid, const std::string& exe, const Profile& p, int64_t ts_ns);
+    void revert(int pid, int64_t ts_ns, const char* note);
+    void log(int64_t ts_ns, int pid, const std::string& exe, const char* event, const std::string& note);
+
+    QosServer& srv_;
+    std::vector<Profile> profiles_;
+    ProcConnector pc_;
+    std::map<int, Active> active_;
+    std::vector<ProcEvent> evs_;
+    BufWriter w_{4096};
+    bool logging_ = false;
+    bool dry_ = false;
+    bool started_ = false;
+};
+
+} // namespace dvfs
@@ -0,0 +1,54 @@
+// dvfs/psi.hpp
+// Pressure stall information (PSI): /proc/pressure/{cpu,memory,io} and the
+// cgroup v2 <cg>/{cpu,memory,io}.pressure files, both of the form
+//
+//   some avg10=1.23 avg60=0.80 avg300=0.42 total=123456789
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+//
+// "total" is cumulative stall time in us: "some" = at least one task was
+// stalled on the resource, "full" = all non-idle tasks were. The share of an
+// interval spent stalled is d(total) / d(t); that is what gets logged (avg10
+// is smoothed over 10 s and too slow for a control loop).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dvfs {
+
+struct PsiTotals {
+    int64_t some_us = -1;
+    int64_t full_us = -1;   // -1 when the file has no "full" line (older cpu)
+};
+
+// Parse the "total=" of the some/full lines; false if there is no "some".
+bool parse_psi(const char* buf, size_t n, PsiTotals& out);
+
+// "cpu" / "memory" / "io" -> /proc/pressure/<x>; anything else is a path.
+std::string psi_path(const std::string& s);
+
+// Stall share between successive reads of one pressure file, over a
+// persistent fd.
+class PsiRate {
+public:
+    PsiRate() = default;
+    ~PsiRate() { close(); }
+    PsiRate(const PsiRate&) = delete;
+    PsiRate& operator=(const PsiRate&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+
+    // Percent of the time since the previous read that tasks were stalled;
+    // NaN on the first read or a failed one.
+    bool read(int64_t ts_ns, double& some_pct, double& full_pct);
+
+private:
+    int fd_ = -1;
+    PsiTotals prev_;
+    int64_t prev_ts_ = 0;
+};
+
+} // namespace dvfs
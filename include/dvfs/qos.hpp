@@ -0,0 +1,76 @@
+// dvfs/qos.hpp
+// User-space PM QoS: arbitration of frequency range requests from several
+// clients (capper, latency booster, thermal guard, ...) into the one range
+// that is actually written, per domain.
+//
+// Aggregation follows kernel freq QoS - effective min = max of the mins,
+// effective max = min of the maxes - with two additions:
+//   caps      requests flagged cap only lower the ceiling and bound everyone;
+//             a floor never pushes past a cap (cap wins)
+//   priority  requests are folded in descending priority groups; inside a
+//             group min > max resolves to max (as in the kernel), and a group
+//             that conflicts with the range left by higher groups is clipped
+//             to it and reported
+// The result is then snapped to the domain's OPPs (min rounds up, max down).
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+enum class QosDomain { Cpu = 0, Gpu = 1 };
+constexpr int kQosDomains = 2;
+
+const char* qos_domain_name(QosDomain d);  // "cpu" / "gpu"
+bool parse_qos_domain(const std::string& s, QosDomain& out);
+
+struct QosRequest {
+    std::string client;
+    int priority = 0;
+    bool cap = false;
+    long long min = 0;  // 0 = no floor
+    long long max = 0;  // 0 = no ceiling
+    uint64_t seq = 0;   // arrival order (set by the arbiter)
+};
+
+struct QosRange {
+    long long min = 0, max = 0;
+    bool operator==(const QosRange& o) const { return min == o.min && max == o.max; }
+    bool operator!=(const QosRange& o) const { return !(*this == o); }
+};
+
+struct QosResult {
+    QosRange range;
+    std::vector<std::string> clipped;  // clients not fully honoured
+};
+
+class QosArbiter {
+public:
+    // Hardware range and OPP table (ascending; empty = no snapping).
+    void set_limits(QosDomain d, long long lo, long long hi, std::vector<long long> opps);
+    QosRange limits(QosDomain d) const { return dom_[(int)d].hw; }
+    const std::vector<long long>& opps(QosDomain d) const { return dom_[(int)d].opps; }
+
+    // Add or replace client's request on d.
+    void request(QosDomain d, QosRequest r);
+    // Remove client's request on d; false if it had none.
+    bool drop(QosDomain d, const std::string& client);
+    // Remove everything client holds (disconnect).
+    void drop_client(const std::string& client);
+
+    QosResult aggregate(QosDomain d) const;
+    const std::vector<QosRequest>& requests(QosDomain d) const { return dom_[(int)d].reqs; }
+
+private:
+    struct Domain {
+        QosRange hw;
+        std::vector<long long> opps;
+        std::vector<QosRequest> reqs;
+    };
+    Domain dom_[kQosDomains];
+    uint64_t seq_ = 0;
+};
+
+} // namespace dvfs
@@ -0,0 +1,55 @@
+// dvfs/rpm.hpp
+// Runtime-PM residency of every device under /sys/devices. scan() walks the
+// tree once for <dev>/power/runtime_status and keeps an fd on it and on
+// runtime_{active,suspended}_time (ms counters); devices whose runtime PM is
+// "unsupported" (never enabled by the driver) are left out. Each poll()
+// reports, per device, how long it was active / suspended since the last
+// poll and its status now - a device that stays active while the system
+// idles is what keeps the SoC out of its low-power states.
+//
+// Devices that appear after scan() are not picked up.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+struct RpmDelta {
+    std::string dev;          // path below the scan root, e.g. platform/gpu.0
+    std::string status;       // active / suspended / suspending / resuming / error
+    double active_ms = 0.0;   // since the previous poll
+    double suspended_ms = 0.0;
+};
+
+class RpmScanner {
+public:
+    RpmScanner() = default;
+    ~RpmScanner();
+    RpmScanner(const RpmScanner&) = delete;
+    RpmScanner& operator=(const RpmScanner&) = delete;
+
+    // Number of devices found; the first poll() reports deltas from here.
+    size_t scan(const std::string& root = "/sys/devices");
+    size_t size() const { return devs_.size(); }
+
+    // Every device's delta since the previous poll, busiest (active ms) first,
+    // then the ones active now.
+    void poll(std::vector<RpmDelta>& out);
+
+private:
+    struct Dev {
+        std::string name, dir;
+        int fd_status = -1, fd_active = -1, fd_suspended = -1;
+        long long active = -1, suspended = -1;
+    };
+    std::vector<Dev> devs_;
+};
+
+// CSV report rows "<ts_ns>,<interval_ms>,<dev>,<status>,<active_ms>,<suspended_ms>,<active_pct>"
+// for the devices that were active during the interval or are active now.
+inline constexpr char kRpmCsvHeader[] = "ts_ns,interval_ms,device,status,active_ms,suspended_ms,active_pct\n";
+void append_rpm_rows(std::string& out, int64_t ts_ns, double interval_ms, const std::vector<RpmDelta>& d);
+
+} // namespace dvfs
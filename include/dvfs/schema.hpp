@@ -0,0 +1,245 @@
+// dvfs/schema.hpp
+// Compile-time record schema (production column set).
+//
+// The built-in column set is also described as a typelist. Schema<F...>
+// generates the record type, the CSV header (a constexpr char array), the
+// packed binary layout and the formatters at compile time: each field is
+// emitted by its own inlined to_chars/memcpy, with no per-field dispatch.
+// log uses it whenever the column set is the built-in one (no --sensors,
+// --filter or --derive) and DVFS_STATIC_SCHEMA is enabled (the default).
+#pragma once
+
+#ifndef DVFS_STATIC_SCHEMA
+#define DVFS_STATIC_SCHEMA 1
+#endif
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "dvfs/sensors.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+// Short fixed-capacity text value (governor names).
+template <size_t N>
+struct Token {
+    char s[N] = {};
+    uint8_t len = 0;
+    void assign(const std::string& v) {
+        len = (uint8_t)std::min(v.size(), N);
+        std::memcpy(s, v.data(), len);
+    }
+};
+
+// Field descriptors: value type, CSV name, unit.
+#define DVFS_FIELD(id, T, unit_)                                        \
+    struct id {                                                         \
+        using type = T;                                                 \
+        static constexpr const char* name = #id;                        \
+        static constexpr const char* unit = unit_;                      \
+    }
+
+namespace fields {
+DVFS_FIELD(ts_ns, int64_t, "ns");
+DVFS_FIELD(dt_ns, int64_t, "ns");
+DVFS_FIELD(cpu_khz, int64_t, "kHz");
+DVFS_FIELD(cpu_min_khz, int64_t, "kHz");
+DVFS_FIELD(cpu_max_khz, int64_t, "kHz");
+DVFS_FIELD(cpu_governor, Token<24>, "text");
+DVFS_FIELD(gpu_hz, int64_t, "Hz");
+DVFS_FIELD(gpu_min_hz, int64_t, "Hz");
+DVFS_FIELD(gpu_max_hz, int64_t, "Hz");
+DVFS_FIELD(gpu_governor, Token<24>, "text");
+DVFS_FIELD(gpu_load, int64_t, "permille");
+DVFS_FIELD(gpu_rpm_status, Token<16>, "text");
+DVFS_FIELD(gpu_active_ms, int64_t, "ms");
+DVFS_FIELD(gpu_suspended_ms, int64_t, "ms");
+DVFS_FIELD(fan_cur_state, int64_t, "state");
+DVFS_FIELD(fan_max_state, int64_t, "state");
+DVFS_FIELD(fan_pwm, int64_t, "pwm");
+DVFS_FIELD(temp_cpu_mC, int64_t, "mC");
+DVFS_FIELD(temp_gpu_mC, int64_t, "mC");
+DVFS_FIELD(temp_soc0_mC, int64_t, "mC");
+DVFS_FIELD(temp_soc1_mC, int64_t, "mC");
+DVFS_FIELD(temp_soc2_mC, int64_t, "mC");
+DVFS_FIELD(temp_tj_mC, int64_t, "mC");
+DVFS_FIELD(vdd_in_mW, int64_t, "mW");
+DVFS_FIELD(vdd_cpu_gpu_cv_mW, int64_t, "mW");
+DVFS_FIELD(vdd_soc_mW, int64_t, "mW");
+DVFS_FIELD(psi_cpu_some_pct, double, "%");
+DVFS_FIELD(psi_mem_some_pct, double, "%");
+DVFS_FIELD(psi_mem_full_pct, double, "%");
+DVFS_FIELD(psi_io_some_pct, double, "%");
+DVFS_FIELD(psi_io_full_pct, double, "%");
+DVFS_FIELD(gpu_gated_pct, double, "%");
+} // namespace fields
+#undef DVFS_FIELD
+
+constexpr size_t cstr_len(const char* s) {
+    size_t n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+
+// Per-type CSV text / binary encoding.
+template <typename T> struct FieldCodec;
+
+template <>
+struct FieldCodec<int64_t> {
+    static constexpr size_t max_chars = 20;
+    static void from_sample(int64_t& out, const Sample& s, size_t c) {
+        out = std::isnan(s.num[c]) ? kMissI64 : (int64_t)s.num[c];
+    }
+    static char* csv(char* p, int64_t v) {
+        return (v == kMissI64) ? p : std::to_chars(p, p + max_chars, v).ptr;
+    }
+};
+
+// Real-valued columns (psi, type=derived); NaN is an empty field.
+template <>
+struct FieldCodec<double> {
+    static constexpr size_t max_chars = 24;
+    static void from_sample(double& out, const Sample& s, size_t c) { out = s.num[c]; }
+    static char* csv(char* p, double v) {
+        return std::isfinite(v) ? std::to_chars(p, p + max_chars, v).ptr : p;
+    }
+};
+
+template <size_t N>
+struct FieldCodec<Token<N>> {
+    static constexpr size_t max_chars = N;
+    static void from_sample(Token<N>& out, const Sample& s, size_t c) { out.assign(s.text[c]); }
+    static char* csv(char* p, const Token<N>& v) {
+        std::memcpy(p, v.s, v.len);
+        return p + v.len;
+    }
+};
+
+template <typename... F>
+struct Schema {
+    static constexpr size_t size = sizeof...(F);
+
+    // The generated sample record.
+    using Record = std::tuple<typename F::type...>;
+
+    // "f0,f1,...\n" built at compile time.
+    static constexpr size_t header_len = (cstr_len(F::name) + ...) + size;
+    static constexpr std::array<char, header_len> make_header() {
+        std::array<char, header_len> h{};
+        size_t p = 0;
+        const char* names[] = {F::name...};
+        for (size_t i = 0; i < size; ++i) {
+            for (const char* c = names[i]; *c; ++c) h[p++] = *c;
+            h[p++] = (i + 1 < size) ? ',' : '\n';
+        }
+        return h;
+    }
+    static constexpr std::array<char, header_len> header = make_header();
+
+    // Worst-case CSV row length: lets the formatter skip bounds checks.
+    static constexpr size_t max_row = (FieldCodec<typename F::type>::max_chars + ...) + size;
+
+    // Packed binary layout: fields back to back in schema order (native endianness).
+    static constexpr size_t binary_size = (sizeof(typename F::type) + ...);
+    template <size_t I>
+    static constexpr size_t offset() {
+        constexpr size_t sizes[] = {sizeof(typename F::type)...};
+        size_t o = 0;
+        for (size_t i = 0; i < I; ++i) o += sizes[i];
+        return o;
+    }
+
+    static char* format_csv(char* p, const Record& r) {
+        return format_csv_impl(p, r, std::index_sequence_for<F...>{});
+    }
+    static void write_binary(char* p, const Record& r) {
+        write_binary_impl(p, r, std::index_sequence_for<F...>{});
+    }
+    static void read_binary(const char* p, Record& r) {
+        read_binary_impl(p, r, std::index_sequence_for<F...>{});
+    }
+
+private:
+    template <size_t... I>
+    static char* format_csv_impl(char* p, const Record& r, std::index_sequence<I...>) {
+        ((p = FieldCodec<typename F::type>::csv(p, std::get<I>(r)), *p++ = (I + 1 < size) ? ',' : '\n'), ...);
+        return p;
+    }
+    template <size_t... I>
+    static void write_binary_impl(char* p, const Record& r, std::index_sequence<I...>) {
+        (std::memcpy(p + offset<I>(), &std::get<I>(r), sizeof(typename F::type)), ...);
+    }
+    template <size_t... I>
+    static void read_binary_impl(const char* p, Record& r, std::index_sequence<I...>) {
+        (std::memcpy(&std::get<I>(r), p + offset<I>(), sizeof(typename F::type)), ...);
+    }
+};
+
+using ProdSchema = Schema<
+    fields::ts_ns, fields::dt_ns,
+    fields::cpu_khz, fields::cpu_min_khz, fields::cpu_max_khz, fields::cpu_governor,
+    fields::gpu_hz, fields::gpu_min_hz, fields::gpu_max_hz, fields::gpu_governor,
+    fields::gpu_load, fields::gpu_rpm_status, fields::gpu_active_ms, fields::gpu_suspended_ms,
+    fields::fan_cur_state, fields::fan_max_state, fields::fan_pwm,
+    fields::temp_cpu_mC, fields::temp_gpu_mC, fields::temp_soc0_mC, fields::temp_soc1_mC,
+    fields::temp_soc2_mC, fields::temp_tj_mC,
+    fields::vdd_in_mW, fields::vdd_cpu_gpu_cv_mW, fields::vdd_soc_mW,
+    fields::psi_cpu_some_pct, fields::psi_mem_some_pct, fields::psi_mem_full_pct,
+    fields::psi_io_some_pct, fields::psi_io_full_pct,
+    fields::gpu_gated_pct>;
+
+// Binds a Schema's fields to Sampler columns once (by name), then fills
+// records from samples with one statically-typed assignment per field.
+template <typename S> class SchemaBinder;
+
+template <typename... F>
+class SchemaBinder<Schema<F...>> {
+public:
+    using Record = typename Schema<F...>::Record;
+
+    // False if a schema field has no matching sampler column, or the sampler
+    // has columns the schema does not cover.
+    bool bind(const Sampler& smp) {
+        if (smp.columns().size() + 2 != sizeof...(F)) return false;
+        const char* names[] = {F::name...};
+        for (size_t i = 0; i < sizeof...(F); ++i) {
+            const std::string n = names[i];
+            if (n == "ts_ns" || n == "dt_ns") { idx_[i] = -1; continue; }
+            auto& cols = smp.columns();
+            auto it = std::find(cols.begin(), cols.end(), n);
+            if (it == cols.end()) return false;
+            idx_[i] = (int)(it - cols.begin());
+        }
+        return true;
+    }
+
+    void fill(const Sample& s, Record& r) const { fill_impl(s, r, std::index_sequence_for<F...>{}); }
+
+private:
+    template <size_t... I>
+    void fill_impl(const Sample& s, Record& r, std::index_sequence<I...>) const {
+        (fill_one<I, F>(s, r), ...);
+    }
+    template <size_t I, typename Fd>
+    void fill_one(const Sample& s, Record& r) const {
+        if constexpr (std::is_same_v<Fd, fields::ts_ns>) std::get<I>(r) = s.ts_ns;
+        else if constexpr (std::is_same_v<Fd, fields::dt_ns>) std::get<I>(r) = s.dt_ns;
+        else FieldCodec<typename Fd::type>::from_sample(std::get<I>(r), s, (size_t)idx_[I]);
+    }
+
+    std::array<int, sizeof...(F)> idx_{};
+};
+
+// Binary log files: a text line "DVFSBIN1 <csv header>" then packed records.
+inline constexpr char kBinMagic[] = "DVFSBIN1 ";
+
+} // namespace dvfs
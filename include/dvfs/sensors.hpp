@@ -0,0 +1,219 @@
+// dvfs/sensors.hpp
+// Sensor registry + generic sampler.
+//
+// Each CSV column is a sensor declared in a small config file (one sensor
+// per line, key=value tokens, '#' comments; values may be "quoted"):
+//
+//   name=temp_tj_mC type=thermal path=tj-thermal,TJ,tj unit=mC watch=Temps label=TJ
+//
+// Keys:
+//   name       CSV column name (required)
+//   type       sysfs | thermal | hwmon | tegrastats | perf | serial | psi | derived
+//   path       sysfs:      file path; ${cpufreq} ${gpu} ${fan} expand to the discovered
+//                          cpufreq policy / GPU devfreq / pwm-fan cooling_device dirs,
+//                          and '*' globs (first match wins)
+//              thermal:    comma-separated thermal_zone type keywords ("<zone>/temp")
+//              hwmon:      <hwmon name>/<attribute>, e.g. pwmfan/pwm1
+//              tegrastats: field key, e.g. VDD_IN (value in mW)
+//              perf:       event name (cycles, instructions, cache-misses, ...);
+//                          system-wide count per sample interval
+//              serial:     reference meter, <device>[@<baud>] (see dvfs/meter.hpp); mW
+//              psi:        <pressure file>[,some|full]: cpu, memory, io (/proc/pressure)
+//                          or a cgroup's <dir>/cpu.pressure etc.; % of the sample
+//                          interval stalled (see dvfs/psi.hpp)
+//              derived:    expression over other columns (see --derive)
+//   unit       free text; "text" keeps the raw string, "mC" renders as C in --watch
+//   period_ms  read every period_ms (rounded to ticks); held in between. 0 = every tick
+//   watch      --watch line the value is shown on (e.g. CPUfreq); omitted = hidden
+//   label      label within the watch line (default: name)
+//   filter     online filter chain for a "<name>_f" column (see --filter)
+//   optional   1 = an unresolvable sysfs path is tolerated (column stays empty)
+//   gain       calibration applied to every raw read: value * gain + offset
+//   offset     (rounded for integer sensors; see dvfs_tool calibrate)
+//   oversample K = read K times spread across each tick and report the mean,
+//              plus a "<name>_sd" column with the standard deviation of the
+//              reads (numeric sysfs / thermal / hwmon / tegrastats / serial;
+//              tegrastats then runs K times faster, down to a 10 ms interval)
+//
+// The built-in registry below reproduces the classic column set.
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dvfs/derive.hpp"
+#include "dvfs/filter.hpp"
+#include "dvfs/meter.hpp"
+#include "dvfs/power.hpp"
+#include "dvfs/psi.hpp"
+
+namespace dvfs {
+
+extern const char* const kDefaultSensors;
+
+enum class SensorType : uint8_t { Sysfs, Thermal, Hwmon, Tegrastats, Perf, Serial, Psi, Derived };
+
+struct SensorSpec {
+    std::string name;
+    SensorType type = SensorType::Sysfs;
+    std::string path;
+    std::string unit;
+    int period_ms = 0;
+    std::string watch;
+    std::string label;
+    std::string filter;
+    bool optional = false;
+    double gain = 1.0;
+    double offset = 0.0;
+    int oversample = 1;
+};
+
+constexpr int kMaxOversample = 64;
+
+// Parse registry text; origin prefixes error messages ("file:line: ...").
+bool parse_sensor_config(const std::string& text, const std::string& origin,
+                         std::vector<SensorSpec>& out, std::string& err);
+
+// Calibration file: one "name=<sensor> gain=<g> offset=<o>" line per sensor,
+// same token syntax as the registry. Applying it overrides gain/offset of the
+// named specs; naming an unknown sensor is an error.
+struct SensorCal {
+    std::string name;
+    double gain = 1.0;
+    double offset = 0.0;
+};
+bool parse_calibration(const std::string& text, const std::string& origin,
+                       std::vector<SensorCal>& out, std::string& err);
+bool apply_calibration(std::vector<SensorSpec>& specs, const std::vector<SensorCal>& cals, std::string& err);
+
+enum class SensorFmt : uint8_t { Int, Text, Real };
+
+// Running mean / variance of the reads within one oversampled interval (Welford).
+struct OverAcc {
+    int n = 0;
+    double mean_ = 0.0, m2 = 0.0;
+    void add(double v) {
+        if (std::isnan(v)) return;
+        n++;
+        const double d = v - mean_;
+        mean_ += d / n;
+        m2 += d * (v - mean_);
+    }
+    double mean() const { return n ? mean_ : std::nan(""); }
+    double sd() const { return n ? std::sqrt(m2 / n) : std::nan(""); }
+};
+
+// A resolved sensor: everything the hot path needs, nothing it has to look up.
+struct Sensor {
+    SensorSpec spec;
+    SensorFmt fmt = SensorFmt::Int;
+    std::string source;          // resolved path / field / event, for diagnostics
+    int fd = -1;                 // persistent sysfs fd (pread at offset 0)
+    int every = 1;               // read every N ticks
+    int tstat = -1;              // tegrastats slot
+    int meter = -1;              // serial meter slot
+    bool cal = false;            // gain/offset != identity
+    int over = 1;                // reads per tick (oversample)
+    int sd_col = -1;             // "<name>_sd" column when over > 1
+    OverAcc acc;
+    std::vector<int> perf_fds;
+    uint64_t perf_prev = 0;
+    std::unique_ptr<PsiRate> psi;  // type=psi
+    bool psi_full = false;
+    int col = -1;                // index into Sample::num
+    int64_t cost_ns = 0;         // read time since reset_costs() (profiling only)
+    uint64_t reads = 0;
+};
+
+// One row. num[] holds every numeric column (raw sensors, then "<name>_sd"
+// oversampling spreads, then "<name>_f" filtered columns, then derived) as
+// double; NaN = missing.
+struct Sample {
+    int64_t ts_ns = 0;
+    int64_t dt_ns = 0;
+    std::vector<double> num;
+    std::vector<std::string> text;   // per sensor; only text sensors use it
+};
+
+struct ShardPool;
+
+class Sampler {
+public:
+    Sampler();
+    ~Sampler();
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    // Resolve specs (plus extra filter/derive specs) against the live system
+    // and start the tegrastats reader if any sensor needs it.
+    bool init(std::vector<SensorSpec> specs, const std::vector<std::string>& extra_filters,
+              const std::vector<std::string>& extra_derives, int period_ms, std::string& err);
+    // Built-in registry, no extras.
+    bool init(int period_ms, std::string& err);
+
+    const std::vector<Sensor>& sensors() const { return sensors_; }
+    // All CSV columns after ts_ns,dt_ns, in output order.
+    const std::vector<std::string>& columns() const { return names_; }
+    size_t raw_count() const { return sensors_.size(); }
+    // Column index by name; -1 if absent.
+    int column(const std::string& name) const;
+
+    void prepare(Sample& s) const {
+        s.num.assign(names_.size(), std::nan(""));
+        s.text.assign(sensors_.size(), std::string());
+    }
+
+    // Read all due sensors into s (values of sensors not due this tick are held).
+    void sample(Sample& s);
+
+    // Shard raw sensor reads over n threads: the caller's thread is shard 0
+    // and keeps its affinity; with pin set, worker k (1..n-1) is pinned to
+    // allowed CPU k modulo the allowed count, so CPUs are shared once n
+    // exceeds it and the caller may land on a worker's CPU.
+    // Every sample() hands each shard its contiguous range and waits on a
+    // per-tick barrier; filters and derives run after it. n <= 1 = serial.
+    bool set_threads(int n, bool pin, std::string& err);
+    int threads() const;
+    // Reads of sensors [begin, end) for one tick (a shard's work).
+    void read_range(size_t begin, size_t end, Sample& s, int64_t ts);
+
+    // Oversampling: each tick is split into oversample_slots() slots; slot 0
+    // is sample(), subsample(j) takes the extra reads of slot j. wait_until
+    // sleeps to the next tick doing the slots in between (a plain
+    // sleep_until when nothing is oversampled).
+    int oversample_slots() const { return slots_; }
+    void subsample(int slot);
+    void wait_until(std::chrono::steady_clock::time_point next, int period_ms);
+
+    // Per-sensor read cost accounting into Sensor::cost_ns / reads.
+    void set_profiling(bool on) { profile_ = on; }
+    void reset_costs();
+    // Re-derive each sensor's tick divider for a new base period, so
+    // spec.period_ms stays a wall-time interval; set_every overrides one.
+    void retime(int period_ms);
+    void set_every(size_t i, int every) { sensors_[i].every = every > 1 ? every : 1; }
+
+private:
+    std::vector<Sensor> sensors_;
+    std::vector<SensorSpec> derived_;
+    std::vector<SensorFilter> filters_;
+    std::unique_ptr<DeriveSet> derive_;
+    std::vector<std::string> names_;
+    size_t nbase_ = 0;
+    std::vector<const double*> ptrs_;
+    std::unique_ptr<PowerReader> pwr_;
+    std::vector<std::unique_ptr<SerialMeter>> meters_;
+    uint64_t tick_ = 0;
+    bool profile_ = false;
+    size_t nsd_ = 0;
+    int slots_ = 1;
+    std::unique_ptr<ShardPool> pool_;
+
+    double read_num(Sensor& se, int64_t ts);
+};
+
+} // namespace dvfs
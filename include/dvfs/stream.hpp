@@ -0,0 +1,125 @@
+// dvfs/stream.hpp
+// Compact binary sample stream over TCP (board -> collector).
+//
+// Frames: [u8 type][u32 payload length, LE][payload]
+//
+//   Hello    board -> coll  "DVFSNET1" | str board | varint ncols | str name...
+//   Sync     board -> coll  i64 board_ns
+//   SyncAck  coll -> board  i64 board_ns (echoed) | i64 coll_ns
+//   Clock    board -> coll  i64 offset_ns (board - coll) | i64 rtt_ns
+//   Rows     board -> coll  varint nrows | row...
+//
+// str = varint length + bytes; i64 = 8 bytes LE; all clocks CLOCK_MONOTONIC.
+// A row is varint zigzag(ts_ns - prev ts_ns) followed by one token per
+// column. Sysfs values are integers that rarely move, so a token is
+// zigzag(v - prev integral v) << 1 (usually one byte); 0b01 = missing,
+// 0b11 = a raw 8-byte double follows (filtered / derived columns).
+// Encoder state lives for the connection, so a collector must decode every
+// Rows frame of a stream in order.
+//
+// Clocks: the board runs NTP-style Sync rounds and reports the offset of the
+// round with the smallest RTT (error <= rtt/2) in a Clock frame, before its
+// first Rows frame and again every resync period.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+enum class FrameType : uint8_t { Hello = 1, Sync = 2, SyncAck = 3, Clock = 4, Rows = 5 };
+
+constexpr char kStreamMagic[] = "DVFSNET1";
+constexpr size_t kFrameHeader = 5;
+constexpr uint32_t kMaxFrame = 16u << 20;
+
+// ---- primitives ----
+void put_varint(std::string& out, uint64_t v);
+void put_i64(std::string& out, int64_t v);
+void put_str(std::string& out, const std::string& s);
+// Readers advance p; false on truncation.
+bool get_varint(const char*& p, const char* e, uint64_t& v);
+bool get_i64(const char*& p, const char* e, int64_t& v);
+bool get_str(const char*& p, const char* e, std::string& s);
+
+// Wrap a payload in a frame header.
+void append_frame(std::string& out, FrameType t, const std::string& payload);
+// Complete frame at the front of [p, e)? Returns its total size, 0 if more
+// bytes are needed, or SIZE_MAX for a malformed header.
+size_t frame_size(const char* p, const char* e);
+
+std::string encode_hello(const std::string& board, const std::vector<std::string>& cols);
+bool decode_hello(const char* p, const char* e, std::string& board, std::vector<std::string>& cols);
+
+// ---- row codec ----
+class RowEncoder {
+public:
+    explicit RowEncoder(size_t ncols) : prev_(ncols, 0) {}
+    void add(int64_t ts_ns, const double* v);
+    size_t rows() const { return rows_; }
+    // Append the pending rows as one Rows frame to out and start a new batch.
+    void take(std::string& out);
+
+private:
+    std::vector<int64_t> prev_;
+    int64_t prev_ts_ = 0;
+    std::string body_;
+    size_t rows_ = 0;
+};
+
+class RowDecoder {
+public:
+    explicit RowDecoder(size_t ncols) : prev_(ncols, 0) {}
+    size_t ncols() const { return prev_.size(); }
+    // Decode one Rows payload, appending to ts / vals (ncols per row).
+    bool decode(const char* p, const char* e, std::vector<int64_t>& ts, std::vector<double>& vals);
+
+private:
+    std::vector<int64_t> prev_;
+    int64_t prev_ts_ = 0;
+};
+
+// ---- board side ----
+class StreamClient {
+public:
+    StreamClient() = default;
+    ~StreamClient();
+    StreamClient(const StreamClient&) = delete;
+    StreamClient& operator=(const StreamClient&) = delete;
+
+    // Connect to "host:port", send Hello and run the initial clock sync.
+    bool connect(const std::string& hostport, const std::string& board,
+                 const std::vector<std::string>& cols, std::string& err);
+    // Queue one row; sends a Rows frame every batch_rows rows.
+    bool push(int64_t ts_ns, const double* v);
+    bool flush();
+    void close();
+
+    void set_batch_rows(size_t n) { batch_ = n ? n : 1; }
+    int64_t offset_ns() const { return offset_; }
+    int64_t rtt_ns() const { return rtt_; }
+    uint64_t bytes_sent() const { return sent_; }
+
+private:
+    bool send_all(const std::string& s);
+    bool sync_round(int timeout_ms, int64_t& best_rtt, int64_t& best_off);
+    void poll_acks();
+
+    int fd_ = -1;
+    std::unique_ptr<RowEncoder> enc_;
+    size_t batch_ = 10;
+    std::string out_;
+    std::string in_;
+    int64_t offset_ = 0;
+    int64_t rtt_ = 0;
+    int64_t last_sync_ = 0;
+    int64_t win_rtt_ = INT64_MAX;
+    int64_t win_off_ = 0;
+    int win_n_ = 0;
+    uint64_t sent_ = 0;
+};
+
+} // namespace dvfs
@@ -0,0 +1,27 @@
+// dvfs/sysfs.hpp
+// Low-level sysfs I/O helpers.
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+// Read a small sysfs attribute (retries EAGAIN; trailing whitespace trimmed).
+std::optional<std::string> read_text(const std::string& path);
+
+// read_text parsed as one integer; nullopt if missing or not a number.
+std::optional<long long> read_ll(const std::string& path);
+
+// Write a value (newline appended); false on open/short write.
+bool write_text(const std::string& path, const std::string& val);
+
+// Whole regular file (configs); unlike read_text, no size cap or trimming.
+std::optional<std::string> read_file(const std::string& path);
+
+bool exists(const std::string& p);
+
+std::vector<std::string> list_dirs(const std::string& root);
+
+} // namespace dvfs
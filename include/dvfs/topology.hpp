@@ -0,0 +1,35 @@
+// dvfs/topology.hpp
+// Discovery of the CPU/GPU/thermal/fan sysfs nodes on Jetson boards.
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+// /sys/devices/system/cpu/cpufreq/policy* (falls back to cpu0/cpufreq).
+std::optional<std::string> find_cpu_policy_dir();
+
+// GPU devfreq dir under /sys/class/devfreq (e.g. 17000000.gpu).
+std::optional<std::string> find_gpu_devfreq_dir();
+
+// First thermal_zone whose type contains any keyword.
+std::optional<std::string> find_thermal_zone_by_keywords(const std::vector<std::string>& kws);
+
+// /sys/class/thermal/cooling_device* with type pwm-fan.
+std::optional<std::string> find_pwm_fan_cooling_device_dir();
+
+// "<hwmon name>/<attribute>" -> /sys/class/hwmon/hwmonN/<attribute>.
+std::optional<std::string> find_hwmon_attr(const std::string& spec);
+
+// Sysfs roots referenced by ${...} in sensor paths; discovered once.
+struct Topology {
+    std::optional<std::string> cpufreq;
+    std::optional<std::string> gpu;
+    std::optional<std::string> fan;
+
+    static Topology discover();
+};
+
+} // namespace dvfs
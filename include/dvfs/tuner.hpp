@@ -0,0 +1,54 @@
+// dvfs/tuner.hpp
+// --overhead-budget: keep the logger's own CPU time under a fraction of one
+// core by adjusting the sample period and per-sensor dividers.
+//
+// Once per window (>= 1 s and >= 5 ticks) the tuner compares process CPU
+// time (sampling, filters, formatting, writes, reader threads) with wall
+// time:
+//   over budget:  slow down the single sensor costing >= 25% of a tick
+//                 (double its divider, up to max_ms), else lengthen the period
+//                 in proportion to the overshoot (+10%)
+//   < half budget: undo the other way round - shorten the period towards the
+//                 requested floor first, then restore slowed sensors
+// The tegrastats child is a separate process and keeps its start interval.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dvfs/sensors.hpp"
+
+namespace dvfs {
+
+// CLOCK_PROCESS_CPUTIME_ID in ns.
+int64_t process_cpu_ns();
+
+// "0.5%" -> 0.005; "0.005" -> 0.005. Must be in (0, 1).
+bool parse_budget(const std::string& s, double& out);
+
+class OverheadTuner {
+public:
+    static constexpr int64_t kWindowNs = 1000000000LL;
+
+    // Enables profiling on smp; floor_ms is the requested period.
+    OverheadTuner(Sampler& smp, double budget, int floor_ms, int max_ms);
+
+    // Call after every tick. Returns true and a one-line note when it changed
+    // period_ms or a sensor divider.
+    bool tick(int& period_ms, std::string& note);
+
+    double overhead() const { return last_; }
+    double budget() const { return budget_; }
+
+private:
+    Sampler& smp_;
+    double budget_;
+    int floor_ms_, max_ms_;
+    int64_t win_t0_ = 0, win_cpu0_ = 0;
+    uint64_t win_ticks_ = 0;
+    double last_ = 0.0;
+    std::vector<int> slow_;  // tuner multiplier per sensor on top of its configured divider
+};
+
+} // namespace dvfs
@@ -0,0 +1,56 @@
+// dvfs/uclamp.hpp
+// Utilization clamping: instead of capping the whole CPU domain, tell
+// schedutil how much utilization each task (or cgroup) may claim, so only
+// the tasks that need high clocks get them.
+//
+//   task    sched_setattr(SCHED_FLAG_UTIL_CLAMP_MIN/MAX), 0..1024, applied
+//           to every thread of a process; a side left at -1 is not touched
+//   cgroup  cgroup v2 cpu.uclamp.min / cpu.uclamp.max, percent ("max" = 100)
+//
+// UclampActuator remembers what it changed and restores it on restore()
+// (the daemon calls that when the requesting client goes away).
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dvfs {
+
+constexpr int kUclampScale = 1024;
+
+struct Uclamp {
+    int min = -1;  // -1 = leave that side alone
+    int max = -1;
+};
+
+bool get_task_uclamp(int tid, Uclamp& out, std::string& err);
+bool set_task_uclamp(int tid, const Uclamp& u, std::string& err);
+// Thread ids of pid (/proc/<pid>/task); just pid if that can't be listed.
+std::vector<int> process_threads(int pid);
+
+// pct < 0 leaves that side alone.
+bool set_cgroup_uclamp(const std::string& cgroup, double min_pct, double max_pct, std::string& err);
+
+// "512" -> 512 on the 0..1024 scale; "50%" -> 512. false if out of range.
+bool parse_uclamp_value(const std::string& s, int& out);
+
+class UclampActuator {
+public:
+    ~UclampActuator() { restore(); }
+
+    // Every thread of pid; the first clamp of a thread saves its original
+    // (both sides, which restore() puts back).
+    bool clamp_process(int pid, const Uclamp& u, std::string& err);
+    bool clamp_cgroup(const std::string& cgroup, double min_pct, double max_pct, std::string& err);
+    // Put back everything changed so far (threads that exited are skipped).
+    void restore();
+    bool active() const { return !tasks_.empty() || !cgroups_.empty(); }
+
+private:
+    std::map<int, Uclamp> tasks_;                                      // tid -> original
+    std::map<std::string, std::pair<std::string, std::string>> cgroups_;  // dir -> original min, max
+};
+
+} // namespace dvfs
@@ -0,0 +1,33 @@
+// dvfs/util.hpp
+// Small shared helpers: monotonic time, number <-> text, string splitting.
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dvfs {
+
+// Missing-value sentinels for typed integer columns.
+constexpr int32_t kMissI32 = INT32_MIN;
+constexpr int64_t kMissI64 = INT64_MIN;
+
+// steady_clock (CLOCK_MONOTONIC) in ns.
+int64_t now_ns();
+
+// Numeric view of a CSV field: empty or non-numeric -> NaN.
+double parse_num(const char* b, const char* e);
+
+// Shortest round-trip text for a double; NaN/inf -> nothing (empty CSV field).
+void append_num(std::string& s, double v);
+
+std::string trim(const std::string& s);
+
+// Split "a(b),c" on commas outside parentheses; pieces are trimmed.
+std::vector<std::string> split_top(const std::string& s);
+
+// Split a config line into tokens; "..." groups spaces, '#' starts a comment.
+std::vector<std::string> config_tokens(const std::string& line);
+
+} // namespace dvfs
@@ -0,0 +1,66 @@
+// dvfs/writer.hpp
+// Output writers: buffered file sink, registry-driven CSV rows, watch lines.
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dvfs/sensors.hpp"
+
+namespace dvfs {
+
+// Append-only output file with a large preallocated buffer. Rows are
+// formatted in place (reserve -> format -> commit) and the buffer goes out
+// with a single write() per flush, instead of per-field ostream calls.
+class BufWriter {
+public:
+    explicit BufWriter(size_t cap = 1 << 20) : buf_(new char[cap]), cap_(cap) {}
+    ~BufWriter() { close(); }
+    BufWriter(const BufWriter&) = delete;
+    BufWriter& operator=(const BufWriter&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Room for at least n bytes; flushes first if needed.
+    char* reserve(size_t n) {
+        if (len_ + n > cap_) flush();
+        if (n > cap_) {
+            buf_.reset(new char[n]);
+            cap_ = n;
+        }
+        return buf_.get() + len_;
+    }
+    void commit(const char* end) { len_ = (size_t)(end - buf_.get()); }
+
+    void append(const char* p, size_t n) {
+        char* d = reserve(n);
+        std::memcpy(d, p, n);
+        len_ += n;
+    }
+    void append(const std::string& s) { append(s.data(), s.size()); }
+
+    size_t pending() const { return len_; }
+
+    // One write() for everything buffered (looping only on short writes).
+    bool flush();
+    bool ok() const { return ok_; }
+
+private:
+    std::unique_ptr<char[]> buf_;
+    size_t cap_;
+    size_t len_ = 0;
+    int fd_ = -1;
+    bool ok_ = false;
+};
+
+void append_csv_header(std::string& out, const Sampler& smp);
+void append_csv_row(std::string& out, const Sampler& smp, const Sample& s);
+
+// Watch lines: one per distinct "watch" group, in first-seen order.
+std::vector<std::string> format_watch_lines(const Sampler& smp, const Sample& s);
+
+} // namespace dvfs
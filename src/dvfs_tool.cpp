@@ -1,28 +1,45 @@
 // dvfs_tool.cpp
-// Build (standalone):
-//   g++ -O2 -std=c++17 dvfs_tool.cpp -o dvfs_tool
+// CLI over libdvfs (include/dvfs, src/lib): argument parsing, terminal
+// output and the subcommand drivers. Sampling, actuation, the stream
+// protocol and the numeric kernels (derive / filter / aggregate / fits)
+// live in the library; analyze's CSV scan and the bench harnesses stay here.
+//
+// Build (CMake):
+//   cmake -S . -B build && cmake --build build
 //
-// Build (CMake in your repo):
-//   put this file at src/dvfs_tool.cpp and add executable dvfs_tool to CMakeLists.
+// Build (standalone):
+//   g++ -O2 -std=c++17 -Iinclude src/dvfs_tool.cpp src/lib/*.cpp -o dvfs_tool -pthread
 
-#include <atomic>
-#include <mutex>
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <csignal>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <optional>
+#include <random>
+#include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "dvfs/dvfs.hpp"
+
 namespace fs = std::filesystem;
+using namespace dvfs;
 
 // ============================================================
 // 0) Globals / signals
@@ -31,148 +48,35 @@ static volatile std::sig_atomic_t g_stop = 0;
 static void on_sigint(int) { g_stop = 1; }
 
 // ============================================================
-// 1) Low-level sysfs I/O helpers
+// 1) Tiny CLI parsing
 // ============================================================
-static std::optional<std::string> read_text(const std::string& path) {
-    for (int attempt = 0; attempt < 3; ++attempt) {
-        int fd = ::open(path.c_str(), O_RDONLY);
-        if (fd < 0) {
-            if (errno == EAGAIN) { ::usleep(1000); continue; }
-            return std::nullopt;
-        }
-        char buf[4096];
-        ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
-        int e = errno;
-        ::close(fd);
-
-        if (n < 0) {
-            if (e == EAGAIN) { ::usleep(1000); continue; }
-            return std::nullopt;
-        }
-        buf[n] = '\0';
-        std::string s(buf);
-        while (!s.empty() && (s.back()=='\n' || s.back()=='\r' || s.back()==' ' || s.back()=='\t')) s.pop_back();
-        return s;
+static std::optional<std::string> get_flag(int argc, char** argv, const std::string& flag) {
+    for (int i = 0; i + 1 < argc; ++i) {
+        if (argv[i] == flag) return std::string(argv[i + 1]);
     }
     return std::nullopt;
 }
-
-static bool write_text(const std::string& path, const std::string& val) {
-    int fd = ::open(path.c_str(), O_WRONLY);
-    if (fd < 0) return false;
-    std::string v = val;
-    if (v.empty() || v.back() != '\n') v.push_back('\n');
-    ssize_t n = ::write(fd, v.c_str(), v.size());
-    ::close(fd);
-    return n == (ssize_t)v.size();
-}
-
-static bool exists(const std::string& p) { return fs::exists(p); }
-
-static std::vector<std::string> list_dirs(const std::string& root) {
+// All values of a repeatable flag (e.g. --derive a=... --derive b=...).
+static std::vector<std::string> get_flags(int argc, char** argv, const std::string& flag) {
     std::vector<std::string> out;
-    if (!fs::exists(root)) return out;
-    for (auto const& e : fs::directory_iterator(root)) {
-        if (e.is_directory()) out.push_back(e.path().string());
-    }
-    return out;
-}
-
-// ============================================================
-// 2) Discovery (CPU/GPU/thermal/fan)
-// ============================================================
-static std::optional<std::string> find_cpu_policy_dir() {
-    // /sys/devices/system/cpu/cpufreq/policy*
-    const std::string a = "/sys/devices/system/cpu/cpufreq";
-    if (exists(a)) {
-        for (auto& d : list_dirs(a)) {
-            if (fs::path(d).filename().string().rfind("policy", 0) == 0 &&
-                exists(d + "/scaling_cur_freq")) {
-                return d;
-            }
-        }
-    }
-    // fallback
-    const std::string b = "/sys/devices/system/cpu/cpu0/cpufreq";
-    if (exists(b) && exists(b + "/scaling_cur_freq")) return b;
-    return std::nullopt;
-}
-
-static std::optional<std::string> find_gpu_devfreq_dir() {
-    // Jetson Orin typically: /sys/class/devfreq/17000000.gpu
-    const std::string root = "/sys/class/devfreq";
-    if (!exists(root)) return std::nullopt;
-
-    auto is_blacklisted = [](const std::string& name) {
-        return (name.find("nvjpg") != std::string::npos) ||
-               (name.find("nvenc") != std::string::npos) ||
-               (name.find("nvdec") != std::string::npos) ||
-               (name.find("vic")   != std::string::npos) ||
-               (name.find("se")    != std::string::npos);
-    };
-
-    // Prefer obvious GPU-like names
-    for (auto& d : list_dirs(root)) {
-        std::string name = fs::path(d).filename().string();
-        if (is_blacklisted(name)) continue;
-        if ((name.find("ga10b") != std::string::npos || name.find("gpu") != std::string::npos) &&
-            exists(d + "/cur_freq") && exists(d + "/available_frequencies")) {
-            return d;
-        }
-    }
-    // Fallback: any devfreq that has cur_freq + available_frequencies
-    for (auto& d : list_dirs(root)) {
-        std::string name = fs::path(d).filename().string();
-        if (is_blacklisted(name)) continue;
-        if (exists(d + "/cur_freq") && exists(d + "/available_frequencies")) return d;
-    }
-    return std::nullopt;
-}
-
-static std::optional<std::string> find_thermal_zone_by_keywords(const std::vector<std::string>& kws) {
-    const std::string tzroot = "/sys/class/thermal";
-    if (!exists(tzroot)) return std::nullopt;
-    for (auto const& e : fs::directory_iterator(tzroot)) {
-        if (!e.is_directory()) continue;
-        auto name = e.path().filename().string();
-        if (name.find("thermal_zone") == std::string::npos) continue;
-        auto type = read_text(e.path().string() + "/type");
-        if (!type) continue;
-        for (auto& kw : kws) {
-            if (type->find(kw) != std::string::npos) return e.path().string();
-        }
-    }
-    return std::nullopt;
-}
-
-static std::optional<std::string> find_pwm_fan_cooling_device_dir() {
-    // Find /sys/class/thermal/cooling_device*/type == pwm-fan
-    const std::string root = "/sys/class/thermal";
-    if (!exists(root)) return std::nullopt;
-    for (auto const& e : fs::directory_iterator(root)) {
-        if (!e.is_directory()) continue;
-        auto name = e.path().filename().string();
-        if (name.rfind("cooling_device", 0) != 0) continue;
-        auto type = read_text(e.path().string() + "/type");
-        if (type && type->find("pwm-fan") != std::string::npos) return e.path().string();
-    }
-    return std::nullopt;
-}
-
-// ============================================================
-// 3) Tiny CLI parsing
-// ============================================================
-static std::optional<std::string> get_flag(int argc, char** argv, const std::string& flag) {
     for (int i = 0; i + 1 < argc; ++i) {
-        if (argv[i] == flag) return std::string(argv[i + 1]);
+        if (argv[i] == flag) out.push_back(argv[++i]);
     }
-    return std::nullopt;
+    return out;
 }
 static bool has_flag(int argc, char** argv, const std::string& flag) {
     for (int i = 0; i < argc; ++i) if (argv[i] == flag) return true;
     return false;
 }
 
+// --derive specs -> ds; reports the first bad one.
+static bool add_cli_derives(DeriveSet& ds, int argc, char** argv) {
+    std::string err;
+    if (build_derive_set(ds, get_flags(argc, argv, "--derive"), err)) return true;
+    std::cerr << "Bad --derive " << err << "\n";
+    return false;
+}
+
 static void print_kv(const std::string& k, const std::optional<std::string>& v) {
     std::cout << k << ": " << (v ? *v : "<N/A>") << "\n";
 }
@@ -181,16 +85,167 @@ static void usage() {
     std::cout <<
 R"(Usage:
   dvfs_tool probe
-  dvfs_tool log   --out <csv> --period_ms <ms> [--watch] [--watch_ms <ms>]
+  dvfs_tool sensors [--sensors <cfg>] [--default]
+  dvfs_tool log   --out <csv> --period_ms <ms> [--watch] [--watch_ms <ms>] [--sensors <cfg>]
+                  [--format csv|bin] [--flush_rows <n>] [--anchor_s <s>]
+                  [--overhead-budget <pct>% [--max_period_ms <ms>]] [--oversample <sensor>:<k> ...]
+                  [--sample_threads <n> [--no_pin]] [--marker_fifo <path>] [--rpm_report_s <s>]
+                  [--psi_cgroup <dir> ...]
+                  [--filter '<col>:<stage>[+<stage>...]' ...] [--derive 'name=expr' ...]
+  dvfs_tool bench [--rows <n>] [--out <file>] [--flush_rows <n>]
+  dvfs_tool bench --sampler [--sensors_n 10,100,1000] [--threads 1,2,4] [--ticks <n>]
+                  [--fixture <dir>] [--no_pin]
+  dvfs_tool bench --filter '<stage>[+<stage>...]' [--values <n>]
+  dvfs_tool bench --loopback [--boards <n>] [--rows <n>] [--batch_rows <n>] [--period_us <us>]
+                  [--out <csv>]
+  dvfs_tool analyze --in <csv> [--derive 'name=expr' ...] [--out <csv>]
+                    [--where '<col> <op> <value>' ...] [--group-by <col>[,<col>...]]
+                    [--agg 'mean(col),max(col),count' ...] [--fit '<col> ~ <col> [+ <col> ...]' ...]
+  dvfs_tool report --run [<label>=]<csv> [--run ...] [--power vdd_in_mW]
+  dvfs_tool pacing --in <csv> [--span <name>] [--power vdd_in_mW] [--freq cpu_khz] [--markers <file>]
+                   [--opps <kHz,...> | --cpu_dir <dir>] [--period_ms <ms>] [--idle_mw <mW>]
+                   [--transition_us <us>] [--cpu_root <dir>] [--mem_frac <0..1>]
+  dvfs_tool dump  --in <bin> [--out <csv>]
+  dvfs_tool rpm   [--root /sys/devices] [--period_s <s>] [--count <n>] [--top <n>] [--log <csv>]
+  dvfs_tool timeconv --in <csv> [--clocks <file>] [--col ts_ns] [--from mono] [--to real]
+                     [--as <name>] [--out <csv>]
+  dvfs_tool timeconv --clocks <file> --ts <ns> [--ts ...] [--from mono] [--to real]
+  dvfs_tool calibrate --in <csv> --rail <col>[=<ref col>] ... [--ref <col>] [--max_lag_rows <n>]
+                      [--out <cal>]
+  dvfs_tool fakemeter [--follow <file> [--gain <g>] [--offset_mw <o>]] [--value_mw <mW>]
+                      [--noise_mw <mW>] [--period_ms <ms>] [--unit W|mW]
+  dvfs_tool stream  --to <host:port> [--board <name>] [--period_ms <ms>] [--batch_rows <n>]
+                    [--rows <n>] [--sensors <cfg>] [--filter ...] [--derive ...]
+                    [--overhead-budget <pct>% [--max_period_ms <ms>]] [--sample_threads <n>]
+  dvfs_tool collect [--listen <port>] [--out <csv>] [--threads <n>] [--max_lag_ms <ms>]
+
+  # Derived columns: arithmetic (+ - * /, parentheses) over column names and
+  # numbers, plus diff(x), ewma(x, alpha), clamp(x, lo, hi), min(a,b), max(a,b), abs(x).
+  # Later derives may reference earlier ones.
+  # Columns come from a sensor registry (dvfs_tool sensors --default prints the
+  # built-in one); --sensors <cfg> replaces it with your own file.
+  # Filters (log): median(N), ewma(a), kalman(q,r); each adds a "<col>_f" column.
+  # --oversample <sensor>:K (or oversample=K in the registry) reads a sensor K
+  # times spread across each tick and logs the mean plus a "<sensor>_sd" column.
+  # log / stream / sensors take --calibration <cal> (from calibrate) to apply
+  # per-sensor gain/offset live; a type=serial sensor reads a reference meter.
+  # --overhead-budget 0.5% keeps the logger's CPU time under 0.5% of a core:
+  # --period_ms becomes the floor; slow sensors and then the period are
+  # stretched (up to --max_period_ms, default 1000) and choices go to <out>.tune.
+  # bench --loopback runs N stream clients against an in-process collect on
+  # 127.0.0.1 and checks the merged CSV (every row once, per-board order,
+  # ts_ns monotonic, values intact); exit 1 on any mismatch.
+  # --sample_threads N (log / stream) splits sensor reads across N pinned
+  # threads per tick; bench --sampler shows where that starts paying off.
+  # --marker_fifo <path> (log): the workload writes "<label>" lines (or
+  # "<ts_ns> <label>") into the FIFO; they land in <out>.markers. Pairs
+  # "<name>:begin"/"<name>:end" are spans: report compares energy and span
+  # latency/energy across runs (e.g. with and without uclamp).
+  # pacing takes one periodic span from such a log and prices every CPU OPP
+  # per period - busy at that clock, idle power in the slack, plus the deep
+  # idle exit + clock ramp (cpuidle / cpufreq latencies, or --transition_us)
+  # when it sleeps - then says whether racing to idle or pacing is cheaper.
+  # The built-in registry reads GPU load (permille) and the GPU's runtime PM
+  # status / active / suspended times (/sys/devices/platform/gpu.0); the
+  # derived gpu_gated_pct is the share of each tick the GPU spent suspended
+  # (rail-gated). analyze --fit fits a linear power model over any columns
+  # (least squares) and prints a --derive expression that replays it.
+  # rpm (or log --rpm_report_s, into <out>.rpm) scans /sys/devices once for
+  # runtime-PM devices and reports, each period, which were active and for
+  # how long - the drivers that keep the SoC out of its low-power states.
+  # log also writes <out>.clocks: CLOCK_MONOTONIC/BOOTTIME/REALTIME anchors at
+  # start, every --anchor_s (default 10) and at stop; timeconv maps ts_ns
+  # (monotonic) to boot/real time or back through them.
 
   # Writes are locked by default (dry-run). Add --apply to actually write sysfs:
   sudo dvfs_tool set    --cpu_khz <kHz> --gpu_hz <Hz> [--apply]
   sudo dvfs_tool unlock [--apply]
+  sudo dvfs_tool daemon [--socket <path>] [--trace <csv>] [--cpu_dir <dir> --gpu_dir <dir>] [--apply]
+                       [--phase_log <csv>] [--rail VDD_IN] [--cpu_root <dir>] [--dma_dev <path>]
+                       [--profiles <cfg> [--profile_log <csv>]]
+  dvfs_tool qos [--socket <path>] [--client <name>] [--priority <n>] [--hold_s <s>]
+                [--cpu_min_khz <kHz>] [--cpu_max_khz <kHz>] [--gpu_min_hz <Hz>] [--gpu_max_hz <Hz>]
+                [--latency_us <us> [--cpus <list>] [--label <name>]]
+  dvfs_tool qos --status [--socket <path>]
+  sudo dvfs_tool uclamp --pid <pid> | --cgroup <dir> [--min <0..1024|pct%>] [--max <...>]
+                       [--hold_s <s> | --keep]
+  dvfs_tool uclamp --pid <pid> --show
+  dvfs_tool cap --cap_mw <mW> [--rail VDD_IN] [--period_ms <ms>] [--socket <path>] [--client <name>]
+                [--tenant <cgroup>[:<weight>] ...] [--enforce cpu.max|uclamp] [--idle_mw <mW>]
+                [--tenant_log <csv>] [--psi cpu|<cgroup>/cpu.pressure | --no_psi] [--psi_low <pct>]
+                [--psi_high <pct>] [--log <csv>]
+  dvfs_tool edp --heartbeat_fifo <path> | --perf instructions [--metric edp|ed2p] [--rail VDD_IN]
+                [--window_ms <ms>] [--period_ms <ms>] [--margin <f>] [--phase <f>] [--settle <n>]
+                [--cpu_only | --gpu_only] [--log <csv>] [--socket <path>] [--client <name>] [--priority <n>]
+  dvfs_tool frames --marker_fifo <path> --deadline_ms <ms> [--span frame] [--domain cpu|gpu] [--margin <f>]
+                   [--k_sd <n>] [--rail VDD_IN] [--log <csv>] [--markers_out <file>] [--socket <path>]
+                   [--client <name>] [--priority <n>]
+
+  # The daemon owns the CPU/GPU limits; clients (qos, cap, ...) send min/max
+  # requests over its socket (default /run/dvfs_tool.sock) and only the
+  # aggregate is written: max of mins, min of maxes, higher --priority first,
+  # and cap requests bound everyone. A request lasts as long as its client's
+  # connection; --trace logs every request, release and write.
+  # uclamp clamps the utilization schedutil sees for one process (every
+  # thread) or cgroup, so a capped background job no longer drags the
+  # latency-critical thread's clocks down with it; restored on exit.
+  # cap --tenant shares the budget between cgroups: power above --idle_mw is
+  # attributed by CPU time, the cap's remainder is split by weight (unused
+  # shares go to tenants that want more) and each tenant is held to its
+  # share through cpu.max or cpu.uclamp.max, rebalanced every period.
+  # cap reads CPU pressure (PSI, /proc/pressure/cpu or --psi): with stall
+  # under --psi_low (default 5%) the CPU clock goes down first, since nobody
+  # is waiting for it; over --psi_high (20%) the GPU goes down first and the
+  # CPU comes back up first. --log records power, stall and ceilings per period.
+  # log's psi_* columns are the share of each tick stalled on CPU / memory /
+  # io (some / full); --psi_cgroup <dir> adds one cgroup's cpu/mem/io "some".
+  # --latency_us holds a CPU wake-up latency limit for the phase (whole
+  # system via /dev/cpu_dma_latency, or --cpus via pm_qos_resume_latency_us;
+  # 0 = no idle states); the daemon's --phase_log prices each window: power
+  # vs the unheld baseline (--rail) and residency in the blocked idle states.
+  # edp hill-climbs the CPU/GPU OPP grid toward the lowest energy x delay
+  # (x delay again for ed2p) per unit of progress - one heartbeat line in the
+  # FIFO, or --perf instructions retired - and pins each point through the
+  # daemon; a shift in rate or power (--phase, default 25%) re-explores.
+  # frames runs one OPP per frame of a periodic pipeline: after each
+  # "<span>:end" it predicts the next frame's work from recent ones and pins
+  # the lowest OPP that fits --deadline_ms minus --margin (default 10%);
+  # --log gets busy time, deadline misses and energy per frame.
+  # --profiles applies per-application profiles (exe=<name> plus OPP
+  # min/max, cap, uclamp) the moment a matching program execs and reverts
+  # them when it exits (proc connector, root); --profile_log records the
+  # exec-to-applied latency of each.
 
 Examples:
   dvfs_tool probe
   dvfs_tool log --out logs/run.csv --period_ms 100
   dvfs_tool log --out logs/run.csv --period_ms 100 --watch --watch_ms 200
+  dvfs_tool log --out logs/run.bin --period_ms 10 --format bin && dvfs_tool dump --in logs/run.bin --out logs/run.csv
+  dvfs_tool sensors --default > my_sensors.cfg && dvfs_tool log --out logs/run.csv --sensors my_sensors.cfg
+  dvfs_tool log --out logs/run.csv --period_ms 100 --derive 'p_per_ghz=vdd_in_mW/(cpu_khz/1e6)'
+  dvfs_tool log --out logs/run.csv --period_ms 1000 --oversample vdd_in_mW:10 --oversample temp_tj_mC:4
+  dvfs_tool log --out logs/run.csv --period_ms 100 --filter 'temp_tj_mC:median(5)+kalman(4,400)'
+  dvfs_tool analyze --in logs/run.csv --derive 'dTdt=diff(temp_tj_mC)/diff(ts_ns)*1e9'
+  dvfs_tool timeconv --in logs/run.csv --to real --out logs/run_wall.csv
+  dvfs_tool calibrate --in logs/ref.csv --rail vdd_in_mW=ref_mW --max_lag_rows 5 --out cal.cfg
+  dvfs_tool log --out logs/run.csv --calibration cal.cfg
+  dvfs_tool collect --listen 7070 --out logs/fleet.csv       # on the host
+  dvfs_tool stream --to host:7070 --board orin-03 --period_ms 50   # on each board
+  sudo dvfs_tool daemon --trace logs/qos.csv --apply &
+  sudo dvfs_tool daemon --profiles apps.cfg --profile_log logs/profiles.csv --apply &
+  dvfs_tool cap --cap_mw 15000 &
+  sudo dvfs_tool cap --cap_mw 15000 --idle_mw 4500 --tenant /sys/fs/cgroup/perception:3 --tenant /sys/fs/cgroup/batch:1 &
+  dvfs_tool edp --heartbeat_fifo /tmp/hb --metric ed2p --log logs/edp.csv &   # batch job: echo > /tmp/hb per item
+  dvfs_tool frames --marker_fifo /tmp/frames --deadline_ms 33 --log logs/frames.csv &   # app: frame:begin / frame:end
+  dvfs_tool qos --client booster --priority 10 --cpu_min_khz 1728000   # held until Ctrl+C
+  dvfs_tool log --out logs/base.csv --marker_fifo /tmp/dvfs.markers   # app: echo infer:begin > /tmp/dvfs.markers
+  sudo dvfs_tool uclamp --pid $(pgrep batch_job) --max 30% &
+  dvfs_tool report --run base=logs/base.csv --run clamped=logs/clamped.csv
+  dvfs_tool pacing --in logs/base.csv --span infer
+  dvfs_tool rpm --period_s 30 --log logs/rpm.csv   # on an idle system
+  dvfs_tool analyze --in logs/run.csv --where 'temp_tj_mC > 48700' --group-by cpu_khz --agg 'mean(vdd_in_mW),count'
+  dvfs_tool analyze --in logs/run.csv --derive 'gpu_busy_hz=gpu_hz*gpu_load/1000' \
+                    --fit 'vdd_cpu_gpu_cv_mW ~ gpu_busy_hz + gpu_hz + gpu_gated_pct'
 
   sudo dvfs_tool set --cpu_khz 1344000 --gpu_hz 918000000          # dry-run
   sudo dvfs_tool set --cpu_khz 1344000 --gpu_hz 918000000 --apply  # apply
@@ -201,170 +256,26 @@ Examples:
 }
 
 // ============================================================
-// 4) Watch-like UI helpers (fixed-line refresh)
+// 2) Watch-like UI helpers (fixed-line refresh)
 // ============================================================
-static std::string fmt_temp_C_1dp(const std::optional<std::string>& temp_mC) {
-    if (!temp_mC || temp_mC->empty()) return "NA";
-    try {
-        long long mc = std::stoll(*temp_mC);
-        double c = mc / 1000.0;
-        char buf[32];
-        std::snprintf(buf, sizeof(buf), "%.1f", c);
-        return std::string(buf);
-    } catch (...) {
-        return "NA";
-    }
-}
-
-static void print_watch_block(
-    bool& initialized,
-    const std::optional<std::string>& cpu_cur_khz,
-    const std::optional<std::string>& cpu_min_khz,
-    const std::optional<std::string>& cpu_max_khz,
-    const std::optional<std::string>& cpu_gov,
-    const std::optional<std::string>& gpu_cur_hz,
-    const std::optional<std::string>& gpu_min_hz,
-    const std::optional<std::string>& gpu_max_hz,
-    const std::optional<std::string>& gpu_gov,
-    const std::optional<std::string>& fan_cur_state,
-    const std::optional<std::string>& fan_max_state,
-    const std::optional<std::string>& fan_pwm,
-    const std::optional<std::string>& t_cpu,
-    const std::optional<std::string>& t_gpu,
-    const std::optional<std::string>& t_soc0,
-    const std::optional<std::string>& t_soc1,
-    const std::optional<std::string>& t_soc2,
-    const std::optional<std::string>& t_tj,
-    long long vdd_in_mW,
-    long long vdd_cpu_gpu_cv_mW,
-    long long vdd_soc_mW
-) {
-    // Reserve 5 lines on first call; then move cursor up 5 lines each update.
+// Reserve lines.size() lines on first call; then move the cursor back up and
+// redraw them in place on each update.
+static void print_watch_block(bool& initialized, const std::vector<std::string>& lines) {
     if (!initialized) {
-        std::cerr << "\n\n\n\n\n";
+        for (size_t i = 0; i < lines.size(); ++i) std::cerr << "\n";
         initialized = true;
-    } else {
-        std::cerr << "\033[5A";
-    }
-
-    auto v = [](const std::optional<std::string>& x) { return x ? *x : std::string("NA"); };
-    auto fmt_mW = [](long long x) { return (x >= 0) ? std::to_string(x) : std::string("NA"); };
-
-    // Line 1: CPU
-    std::cerr << "\033[2K\r"
-              << "CPUfreq: cur=" << v(cpu_cur_khz)
-              << " min=" << v(cpu_min_khz)
-              << " max=" << v(cpu_max_khz)
-              << " gov=" << v(cpu_gov)
-              << "\n";
-
-    // Line 2: GPU
-    std::cerr << "\033[2K\r"
-              << "GPUfreq: cur=" << v(gpu_cur_hz)
-              << " min=" << v(gpu_min_hz)
-              << " max=" << v(gpu_max_hz)
-              << " gov=" << v(gpu_gov)
-              << "\n";
-
-    // Line 3: FAN
-    std::cerr << "\033[2K\r"
-              << "FAN: cur_state=" << v(fan_cur_state)
-              << "/" << v(fan_max_state)
-              << " pwm=" << v(fan_pwm)
-              << "\n";
-
-    // Line 4: Temps
-    std::cerr << "\033[2K\r"
-              << "Temps: CPU " << fmt_temp_C_1dp(t_cpu) << "C"
-              << " | GPU "  << fmt_temp_C_1dp(t_gpu)  << "C"
-              << " | SOC0 " << fmt_temp_C_1dp(t_soc0) << "C"
-              << " | SOC1 " << fmt_temp_C_1dp(t_soc1) << "C"
-              << " | SOC2 " << fmt_temp_C_1dp(t_soc2) << "C"
-              << " | TJ "   << fmt_temp_C_1dp(t_tj)   << "C"
-              << "\n";
-
-    // Line 5: Power
-    std::cerr << "\033[2K\r"
-              << "Power: VDD_IN " << fmt_mW(vdd_in_mW) << "mW"
-              << " | VDD_CPU_GPU_CV " << fmt_mW(vdd_cpu_gpu_cv_mW) << "mW"
-              << " | VDD_SOC " << fmt_mW(vdd_soc_mW) << "mW"
-              << "\n";
-
-    std::cerr << std::flush;
-}
-
-// ============================================================
-// 5) Time helper
-// ============================================================
-static int64_t now_ns() {
-    using namespace std::chrono;
-    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
-}
-
-// ============================================================
-// 5.1 tegrastats power reader (VDD_* mW)
-// ============================================================
-
-struct PowerCache {
-    std::atomic<long long> vdd_in_mw{-1};
-    std::atomic<long long> vdd_cpu_gpu_cv_mw{-1};
-    std::atomic<long long> vdd_soc_mw{-1};
-};
-
-// parse: find "<key> <num>mW/" in a line, return num (mW)
-static std::optional<long long> parse_mw_field(const std::string& line, const std::string& key) {
-    // Example: " ... VDD_IN 21954mW/21896mW ..."
-    auto pos = line.find(key);
-    if (pos == std::string::npos) return std::nullopt;
-    pos += key.size();
-
-    // skip spaces
-    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
-
-    // parse digits
-    long long val = 0;
-    bool any = false;
-    while (pos < line.size() && (line[pos] >= '0' && line[pos] <= '9')) {
-        any = true;
-        val = val * 10 + (line[pos] - '0');
-        pos++;
     }
-    if (!any) return std::nullopt;
-
-    // expect "mW"
-    if (pos + 1 >= line.size() || line[pos] != 'm' || line[pos+1] != 'W') return std::nullopt;
-    return val;
-}
+    if (!lines.empty()) std::cerr << "\033[" << lines.size() << "A";
 
-static std::thread start_tegrastats_thread(int interval_ms, PowerCache* cache) {
-    // If dvfs_tool is run with sudo already, no need for "sudo" here.
-    // Otherwise tegrastats may require root on your system.
-    std::string cmd;
-    if (::geteuid() == 0) cmd = "tegrastats --interval " + std::to_string(interval_ms);
-    else                  cmd = "sudo tegrastats --interval " + std::to_string(interval_ms);
-
-    return std::thread([interval_ms, cache, cmd]() {
-        FILE* fp = ::popen(cmd.c_str(), "r");
-        if (!fp) return;
-
-        char buf[8192];
-        while (!g_stop && std::fgets(buf, sizeof(buf), fp)) {
-            std::string line(buf);
-
-            if (auto v = parse_mw_field(line, "VDD_IN"); v) cache->vdd_in_mw.store(*v, std::memory_order_relaxed);
-            if (auto v = parse_mw_field(line, "VDD_CPU_GPU_CV"); v) cache->vdd_cpu_gpu_cv_mw.store(*v, std::memory_order_relaxed);
-            if (auto v = parse_mw_field(line, "VDD_SOC"); v) cache->vdd_soc_mw.store(*v, std::memory_order_relaxed);
-        }
-
-        ::pclose(fp);
-    });
+    for (auto& l : lines) std::cerr << "\033[2K\r" << l << "\n";
+    std::cerr << std::flush;
 }
 
 // ============================================================
-// 6) Subcommands
+// 3) Subcommands
 // ============================================================
 
-// ---- 6.1 probe ----
+// ---- 3.1 probe ----
 static int cmd_probe() {
     std::cout << "=== dvfs_tool probe ===\n";
 
@@ -432,7 +343,19 @@ static int cmd_probe() {
     return 0;
 }
 
-// ---- 6.2 set ----
+// Print a write plan the way set/unlock always have.
+static void print_plan(const Controller& ctl, const std::vector<SysfsWrite>& plan) {
+    std::cout << "CPU dir: " << ctl.cpu_dir() << "\n";
+    std::cout << "GPU dir: " << ctl.gpu_dir() << "\n";
+    std::cout << "Will write:\n";
+    for (auto& w : plan) {
+        std::cout << "  " << w.path << " = " << (w.value.empty() ? "<skip>" : w.value);
+        if (!w.note.empty()) std::cout << " (" << w.note << ")";
+        std::cout << "\n";
+    }
+}
+
+// ---- 3.2 set ----
 static int cmd_set(int argc, char** argv) {
     auto cpu_khz = get_flag(argc, argv, "--cpu_khz");
     auto gpu_hz  = get_flag(argc, argv, "--gpu_hz");
@@ -443,119 +366,151 @@ static int cmd_set(int argc, char** argv) {
         return 2;
     }
 
-    auto cpu_dir = find_cpu_policy_dir();
-    auto gpu_dir = find_gpu_devfreq_dir();
-    if (!cpu_dir || !gpu_dir) {
+    auto ctl = Controller::discover();
+    if (!ctl) {
         std::cerr << "Failed to discover cpu/gpu sysfs dirs. Run: dvfs_tool probe\n";
         return 3;
     }
 
-    const std::string cpu_min_p = *cpu_dir + "/scaling_min_freq";
-    const std::string cpu_max_p = *cpu_dir + "/scaling_max_freq";
-    const std::string gpu_min_p = *gpu_dir + "/min_freq";
-    const std::string gpu_max_p = *gpu_dir + "/max_freq";
-
-    std::cout << "CPU dir: " << *cpu_dir << "\n";
-    std::cout << "GPU dir: " << *gpu_dir << "\n";
-    std::cout << "Will write:\n";
-    std::cout << "  " << cpu_min_p << " = " << *cpu_khz << "\n";
-    std::cout << "  " << cpu_max_p << " = " << *cpu_khz << "\n";
-    std::cout << "  " << gpu_min_p << " = " << *gpu_hz  << "\n";
-    std::cout << "  " << gpu_max_p << " = " << *gpu_hz  << "\n";
+    const auto plan = ctl->plan_lock(*cpu_khz, *gpu_hz);
+    print_plan(*ctl, plan);
 
     if (!apply) {
         std::cout << "Dry-run (no sysfs writes). Add --apply to actually write.\n";
         return 0;
     }
 
-    bool ok_cpu1 = write_text(cpu_min_p, *cpu_khz);
-    bool ok_cpu2 = write_text(cpu_max_p, *cpu_khz);
-    bool ok_gpu1 = write_text(gpu_min_p, *gpu_hz);
-    bool ok_gpu2 = write_text(gpu_max_p, *gpu_hz);
+    const auto ok = Controller::apply(plan);
 
     std::cout << "Applied.\n";
-    std::cout << "CPU write min/max: " << ok_cpu1 << "," << ok_cpu2 << "\n";
-    std::cout << "GPU write min/max: " << ok_gpu1 << "," << ok_gpu2 << "\n";
-
-    print_kv("CPU cur(kHz)", read_text(*cpu_dir + "/scaling_cur_freq"));
-    print_kv("GPU cur(Hz)",  read_text(*gpu_dir + "/cur_freq"));
-    print_kv("GPU min/max",  read_text(*gpu_dir + "/min_freq").value_or("<N/A>") + std::string("/") +
-                             read_text(*gpu_dir + "/max_freq").value_or("<N/A>"));
-    return (ok_cpu1 && ok_cpu2 && ok_gpu1 && ok_gpu2) ? 0 : 4;
+    std::cout << "CPU write min/max: " << ok[0] << "," << ok[1] << "\n";
+    std::cout << "GPU write min/max: " << ok[2] << "," << ok[3] << "\n";
+
+    const std::string& gpu_dir = ctl->gpu_dir();
+    print_kv("CPU cur(kHz)", read_text(ctl->cpu_dir() + "/scaling_cur_freq"));
+    print_kv("GPU cur(Hz)",  read_text(gpu_dir + "/cur_freq"));
+    print_kv("GPU min/max",  read_text(gpu_dir + "/min_freq").value_or("<N/A>") + std::string("/") +
+                             read_text(gpu_dir + "/max_freq").value_or("<N/A>"));
+    return (ok[0] && ok[1] && ok[2] && ok[3]) ? 0 : 4;
 }
 
-// ---- 6.3 unlock ----
+// ---- 3.3 unlock ----
 static int cmd_unlock(int argc, char** argv) {
     bool apply = has_flag(argc, argv, "--apply");
 
-    auto cpu_dir = find_cpu_policy_dir();
-    auto gpu_dir = find_gpu_devfreq_dir();
-    if (!cpu_dir || !gpu_dir) {
+    auto ctl = Controller::discover();
+    if (!ctl) {
         std::cerr << "Failed to discover cpu/gpu sysfs dirs. Run: dvfs_tool probe\n";
         return 3;
     }
 
-    auto cmin = read_text(*cpu_dir + "/cpuinfo_min_freq");
-    auto cmax = read_text(*cpu_dir + "/cpuinfo_max_freq");
-
-    const std::string cpu_min_p = *cpu_dir + "/scaling_min_freq";
-    const std::string cpu_max_p = *cpu_dir + "/scaling_max_freq";
-    const std::string gpu_min_p = *gpu_dir + "/min_freq";
-    const std::string gpu_max_p = *gpu_dir + "/max_freq";
-    const std::string gov_p     = *gpu_dir + "/governor";
-
-    // Pick GPU min/max defaults from available_frequencies (first/last token).
-    std::string gpu_min_default;
-    std::string gpu_max_default;
-    if (auto af = read_text(*gpu_dir + "/available_frequencies"); af && !af->empty()) {
-        std::string s = *af;
-        while (!s.empty() && (s.back()==' ' || s.back()=='\t' || s.back()=='\n' || s.back()=='\r')) s.pop_back();
-
-        size_t first_end = s.find_first_of(" \t");
-        gpu_min_default = (first_end == std::string::npos) ? s : s.substr(0, first_end);
-
-        size_t last_sep = s.find_last_of(" \t");
-        gpu_max_default = (last_sep == std::string::npos) ? s : s.substr(last_sep + 1);
-    }
-    if (gpu_min_default.empty()) gpu_min_default = read_text(*gpu_dir + "/min_freq").value_or("306000000");
-    if (gpu_max_default.empty()) gpu_max_default = read_text(*gpu_dir + "/max_freq").value_or("1020000000");
-
-    std::cout << "CPU dir: " << *cpu_dir << "\n";
-    std::cout << "GPU dir: " << *gpu_dir << "\n";
-    std::cout << "Will write:\n";
-    if (cmin) std::cout << "  " << cpu_min_p << " = " << *cmin << " (cpuinfo_min_freq)\n";
-    else      std::cout << "  " << cpu_min_p << " = <skip> (cpuinfo_min_freq missing)\n";
-    if (cmax) std::cout << "  " << cpu_max_p << " = " << *cmax << " (cpuinfo_max_freq)\n";
-    else      std::cout << "  " << cpu_max_p << " = <skip> (cpuinfo_max_freq missing)\n";
-
-    std::cout << "  " << gpu_min_p << " = " << gpu_min_default
-              << " (from available_frequencies if present)\n";
-    std::cout << "  " << gpu_max_p << " = " << gpu_max_default
-              << " (from available_frequencies if present)\n";
-    if (exists(gov_p)) std::cout << "  " << gov_p << " = nvhost_podgov\n";
-    else               std::cout << "  " << gov_p << " = <skip> (no governor file)\n";
+    const auto plan = ctl->plan_unlock();
+    print_plan(*ctl, plan);
 
     if (!apply) {
         std::cout << "Dry-run (no sysfs writes). Add --apply to actually write.\n";
         return 0;
     }
 
-    bool ok_cpu1 = cmin ? write_text(cpu_min_p, *cmin) : true;
-    bool ok_cpu2 = cmax ? write_text(cpu_max_p, *cmax) : true;
+    const auto ok = Controller::apply(plan);
 
-    bool ok_gpu1 = write_text(gpu_min_p, gpu_min_default);
-    bool ok_gpu2 = write_text(gpu_max_p, gpu_max_default);
+    std::cout << "Applied.\n";
+    std::cout << "CPU unlock ok: " << ok[0] << "," << ok[1] << "\n";
+    std::cout << "GPU unlock ok: " << ok[2] << "," << ok[3] << " governor_ok=" << ok[4] << "\n";
+    return (ok[0] && ok[1] && ok[2] && ok[3] && ok[4]) ? 0 : 4;
+}
 
-    bool ok_gov  = true;
-    if (exists(gov_p)) ok_gov = write_text(gov_p, "nvhost_podgov");
+// Registry from --sensors <file>, or the built-in one.
+static bool load_sensor_specs(int argc, char** argv, std::vector<SensorSpec>& specs) {
+    std::string err;
+    if (auto path = get_flag(argc, argv, "--sensors")) {
+        auto text = read_file(*path);
+        if (!text) {
+            std::cerr << "Failed to open: " << *path << "\n";
+            return false;
+        }
+        if (!parse_sensor_config(*text, *path, specs, err)) {
+            std::cerr << err << "\n";
+            return false;
+        }
+    } else if (!parse_sensor_config(kDefaultSensors, "<builtin>", specs, err)) {
+        std::cerr << err << "\n";
+        return false;
+    }
+    // Per-cgroup pressure: psi_<cgroup>_{cpu,mem,io}_some_pct.
+    for (auto& cg : get_flags(argc, argv, "--psi_cgroup")) {
+        std::string dir = cg;
+        while (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+        const std::string base = dir.substr(dir.rfind('/') + 1);
+        for (auto [res, tag] : {std::pair<const char*, const char*>{"cpu", "cpu"}, {"memory", "mem"}, {"io", "io"}}) {
+            SensorSpec sp;
+            sp.name = "psi_" + base + "_" + tag + "_some_pct";
+            sp.type = SensorType::Psi;
+            sp.path = dir + "/" + res + ".pressure,some";
+            sp.unit = "%";
+            sp.watch = "PSI";
+            sp.label = base + ":" + tag;
+            if (std::any_of(specs.begin(), specs.end(), [&](const SensorSpec& o) { return o.name == sp.name; })) {
+                std::cerr << "Bad --psi_cgroup '" << cg << "': duplicate column " << sp.name << "\n";
+                return false;
+            }
+            specs.push_back(std::move(sp));
+        }
+    }
+    for (auto& o : get_flags(argc, argv, "--oversample")) {
+        const auto colon = o.rfind(':');
+        const std::string name = o.substr(0, colon);
+        auto it = std::find_if(specs.begin(), specs.end(), [&](const SensorSpec& sp) { return sp.name == name; });
+        const int k = (colon == std::string::npos) ? 0 : std::atoi(o.c_str() + colon + 1);
+        if (it == specs.end() || k < 1 || k > kMaxOversample) {
+            std::cerr << "Bad --oversample '" << o << "' (expected <sensor>:<1.." << kMaxOversample << ">)\n";
+            return false;
+        }
+        it->oversample = k;
+    }
+    if (auto path = get_flag(argc, argv, "--calibration")) {
+        auto text = read_file(*path);
+        std::vector<SensorCal> cals;
+        if (!text) {
+            std::cerr << "Failed to open: " << *path << "\n";
+            return false;
+        }
+        if (!parse_calibration(*text, *path, cals, err) || !apply_calibration(specs, cals, err)) {
+            std::cerr << err << "\n";
+            return false;
+        }
+    }
+    return true;
+}
 
-    std::cout << "Applied.\n";
-    std::cout << "CPU unlock ok: " << ok_cpu1 << "," << ok_cpu2 << "\n";
-    std::cout << "GPU unlock ok: " << ok_gpu1 << "," << ok_gpu2 << " governor_ok=" << ok_gov << "\n";
-    return (ok_cpu1 && ok_cpu2 && ok_gpu1 && ok_gpu2 && ok_gov) ? 0 : 4;
+// --overhead-budget / --max_period_ms -> tuner (null when not requested).
+static bool make_tuner(int argc, char** argv, Sampler& smp, int period_ms, std::unique_ptr<OverheadTuner>& out) {
+    auto b = get_flag(argc, argv, "--overhead-budget");
+    if (!b) return true;
+    double budget;
+    if (!parse_budget(*b, budget)) {
+        std::cerr << "Bad --overhead-budget: " << *b << " (e.g. 0.5%)\n";
+        return false;
+    }
+    int max_ms = 1000;
+    if (auto m = get_flag(argc, argv, "--max_period_ms")) max_ms = std::stoi(*m);
+    out = std::make_unique<OverheadTuner>(smp, budget, period_ms, max_ms);
+    return true;
 }
 
-// ---- 6.4 log ----
+// --sample_threads N [--no_pin] -> shard sensor reads (see Sampler::set_threads).
+static bool set_sample_threads(int argc, char** argv, Sampler& smp) {
+    auto t = get_flag(argc, argv, "--sample_threads");
+    if (!t) return true;
+    std::string err;
+    if (!smp.set_threads(std::stoi(*t), !has_flag(argc, argv, "--no_pin"), err)) {
+        std::cerr << err << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ---- 3.4 log ----
 static int cmd_log(int argc, char** argv) {
     std::signal(SIGINT, on_sigint);
 
@@ -569,59 +524,118 @@ static int cmd_log(int argc, char** argv) {
     if (auto w = get_flag(argc, argv, "--watch_ms")) watch_ms = std::stoi(*w);
     if (watch_ms <= 0) watch_ms = 200;
 
-    auto cpu_dir = find_cpu_policy_dir();
-    auto gpu_dir = find_gpu_devfreq_dir();
-    if (!cpu_dir || !gpu_dir) {
-        std::cerr << "Failed to discover cpu/gpu sysfs dirs. Run: dvfs_tool probe\n";
-        return 3;
+    const std::string format = get_flag(argc, argv, "--format").value_or("csv");
+    if (format != "csv" && format != "bin") {
+        std::cerr << "--format must be csv or bin\n";
+        return 2;
     }
-
-    // Fan discovery
-    auto fan_cd = find_pwm_fan_cooling_device_dir();
-    const std::string fan_cur_p = fan_cd ? (*fan_cd + "/cur_state") : "";
-    const std::string fan_max_p = fan_cd ? (*fan_cd + "/max_state") : "";
-    const std::string fan_pwm_p = "/sys/devices/platform/pwm-fan/hwmon/hwmon1/pwm1";
-    const bool has_fan_pwm = exists(fan_pwm_p);
-
-    // CPU governor path
-    const std::string cpu_gov_p = *cpu_dir + "/scaling_governor";
-
-    // Temperatures: match common Jetson names.
-    auto tz_cpu  = find_thermal_zone_by_keywords({"cpu-thermal","CPU-therm","cpu","CPU"});
-    auto tz_gpu  = find_thermal_zone_by_keywords({"gpu-thermal","GPU-therm","gpu","ga10b","GPU"});
-    auto tz_soc0 = find_thermal_zone_by_keywords({"soc0-thermal","SOC0","soc0"});
-    auto tz_soc1 = find_thermal_zone_by_keywords({"soc1-thermal","SOC1","soc1"});
-    auto tz_soc2 = find_thermal_zone_by_keywords({"soc2-thermal","SOC2","soc2"});
-    auto tz_tj   = find_thermal_zone_by_keywords({"tj-thermal","TJ","tj"});
-
-    std::ofstream ofs(out);
-    if (!ofs) {
+    const bool binary = (format == "bin");
+
+    std::vector<SensorSpec> specs;
+    if (!load_sensor_specs(argc, argv, specs)) return 2;
+    const auto filter_specs = get_flags(argc, argv, "--filter");
+    const auto derive_specs = get_flags(argc, argv, "--derive");
+
+    int flush_rows = 10;
+    if (auto f = get_flag(argc, argv, "--flush_rows")) flush_rows = std::stoi(*f);
+    if (flush_rows <= 0) flush_rows = 10;
+    int anchor_s = 10;
+    if (auto a = get_flag(argc, argv, "--anchor_s")) anchor_s = std::stoi(*a);
+    if (anchor_s <= 0) anchor_s = 10;
+
+    BufWriter w;
+    if (!w.open(out)) {
         std::cerr << "Failed to open: " << out << "\n";
         return 1;
     }
-    PowerCache pwr;
-    std::thread pwr_thr = start_tegrastats_thread(period_ms, &pwr);
+    // Clock anchors sidecar (see dvfs/clocks.hpp); written straight through.
+    const std::string clocks_out = out + ".clocks";
+    BufWriter cw(4096);
+    if (!cw.open(clocks_out)) {
+        std::cerr << "Failed to open: " << clocks_out << "\n";
+        return 1;
+    }
+    std::string anchor_line;
+    append_anchor_header(anchor_line);
+    auto write_anchor = [&]() {
+        append_anchor(anchor_line, read_anchor());
+        cw.append(anchor_line);
+        cw.flush();
+        anchor_line.clear();
+    };
+    write_anchor();
+
+    // Workload markers -> <out>.markers (see dvfs/markers.hpp).
+    MarkerFifo markers;
+    std::string err;
+    if (auto f = get_flag(argc, argv, "--marker_fifo"); f && !markers.start(*f, out + ".markers", err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
 
-    // CSV header (expanded)
-    ofs << "ts_ns,dt_ns,"
-       "cpu_khz,cpu_min_khz,cpu_max_khz,cpu_governor,"
-       "gpu_hz,gpu_min_hz,gpu_max_hz,gpu_governor,"
-       "fan_cur_state,fan_max_state,fan_pwm,"
-       "temp_cpu_mC,temp_gpu_mC,temp_soc0_mC,temp_soc1_mC,temp_soc2_mC,temp_tj_mC,"
-       "vdd_in_mW,vdd_cpu_gpu_cv_mW,vdd_soc_mW\n";
-    ofs.flush();
+    // Runtime-PM residency of all devices -> <out>.rpm every --rpm_report_s.
+    RpmScanner rpm;
+    BufWriter rw(4096);
+    int64_t rpm_ns = 0;
+    if (auto r = get_flag(argc, argv, "--rpm_report_s")) {
+        rpm_ns = (int64_t)(std::stod(*r) * 1e9);
+        if (rpm_ns <= 0 || rpm.scan() == 0) {
+            std::cerr << (rpm_ns <= 0 ? "--rpm_report_s must be > 0" : "No runtime-PM devices under /sys/devices")
+                      << "\n";
+            return 2;
+        }
+        if (!rw.open(out + ".rpm")) {
+            std::cerr << "Failed to open: " << out << ".rpm\n";
+            return 1;
+        }
+        rw.append(kRpmCsvHeader, sizeof(kRpmCsvHeader) - 1);
+        rw.flush();
+    }
+
+    Sampler smp;
+    if (!smp.init(specs, filter_specs, derive_specs, period_ms, err)) {
+        std::cerr << err << "\n";
+        return 3;
+    }
+    if (!set_sample_threads(argc, argv, smp)) return 3;
+    std::unique_ptr<OverheadTuner> tuner;
+    if (!make_tuner(argc, argv, smp, period_ms, tuner)) return 2;
+    // Tuner decisions: <out>.tune (ts_ns,period_ms,overhead_pct,note).
+    BufWriter tw(4096);
+    if (tuner) {
+        if (!tw.open(out + ".tune")) {
+            std::cerr << "Failed to open: " << out << ".tune\n";
+            return 1;
+        }
+        tw.append(std::string("ts_ns,period_ms,overhead_pct,note\n"));
+        tw.flush();
+    }
+    std::string tune_note = tuner ? "starting at " + std::to_string(period_ms) + " ms" : "";
+
+    // Built-in column set -> compile-time schema; anything else -> generic writer.
+    SchemaBinder<ProdSchema> binder;
+    const bool use_schema = DVFS_STATIC_SCHEMA && !has_flag(argc, argv, "--sensors") &&
+                            filter_specs.empty() && derive_specs.empty() && binder.bind(smp);
+    if (binary && !use_schema) {
+        std::cerr << "--format bin needs the built-in column set (no --sensors/--filter/--derive/--oversample)\n";
+        return 2;
+    }
+
+    std::string line;
+    if (use_schema) {
+        if (binary) w.append(kBinMagic, sizeof(kBinMagic) - 1);
+        w.append(ProdSchema::header.data(), ProdSchema::header.size());
+    } else {
+        append_csv_header(line, smp);
+        w.append(line);
+    }
+    w.flush();
 
     if (!watch_mode) {
         std::cerr << "Logging to " << out << " period=" << period_ms << "ms\n";
-        std::cerr << "cpu_dir=" << *cpu_dir << "\n";
-        std::cerr << "gpu_dir=" << *gpu_dir << "\n";
-        std::cerr << "fan_cd=" << (fan_cd ? *fan_cd : "NOT_FOUND") << "\n";
-        std::cerr << "tz_cpu="  << (tz_cpu  ? *tz_cpu  : "NOT_FOUND") << "\n";
-        std::cerr << "tz_gpu="  << (tz_gpu  ? *tz_gpu  : "NOT_FOUND") << "\n";
-        std::cerr << "tz_soc0=" << (tz_soc0 ? *tz_soc0 : "NOT_FOUND") << "\n";
-        std::cerr << "tz_soc1=" << (tz_soc1 ? *tz_soc1 : "NOT_FOUND") << "\n";
-        std::cerr << "tz_soc2=" << (tz_soc2 ? *tz_soc2 : "NOT_FOUND") << "\n";
-        std::cerr << "tz_tj="   << (tz_tj   ? *tz_tj   : "NOT_FOUND") << "\n";
+        for (auto& se : smp.sensors()) {
+            std::cerr << se.spec.name << "=" << (se.source.empty() ? "NOT_FOUND" : se.source) << "\n";
+        }
     } else {
         std::cerr << "Logging to " << out << " period=" << period_ms
                   << "ms (watch=" << watch_ms << "ms)\n";
@@ -630,89 +644,2244 @@ static int cmd_log(int argc, char** argv) {
     using clock = std::chrono::steady_clock;
     auto next = clock::now();
     int line_cnt = 0;
-    int64_t prev_ts = 0;
     int64_t last_watch_ns = 0;
     bool watch_initialized = false;
+    Sample sample;
+    smp.prepare(sample);
+    ProdSchema::Record rec{};
+    const int64_t anchor_ns = (int64_t)anchor_s * 1000000000LL;
+    int64_t last_anchor_ns = now_ns();
+    int64_t last_rpm_ns = last_anchor_ns;
+    std::vector<RpmDelta> rpm_d;
 
     while (!g_stop) {
-        next += std::chrono::milliseconds(period_ms);
-
-        const int64_t ts = now_ns();
-        const int64_t dt = (prev_ts == 0) ? 0 : (ts - prev_ts);
-        prev_ts = ts;
-
-        // CPU
-        auto cpu_khz = read_text(*cpu_dir + "/scaling_cur_freq");
-        auto cpu_min = read_text(*cpu_dir + "/scaling_min_freq");
-        auto cpu_max = read_text(*cpu_dir + "/scaling_max_freq");
-        auto cpu_gov = read_text(cpu_gov_p);
-
-        // GPU
-        auto gpu_hz  = read_text(*gpu_dir + "/cur_freq");
-        auto gpu_min = read_text(*gpu_dir + "/min_freq");
-        auto gpu_max = read_text(*gpu_dir + "/max_freq");
-        auto gpu_gov = read_text(*gpu_dir + "/governor");
-
-        // Fan
-        auto fan_cur = fan_cd ? read_text(fan_cur_p) : std::nullopt;
-        auto fan_max = fan_cd ? read_text(fan_max_p) : std::nullopt;
-        auto fan_pwm = has_fan_pwm ? read_text(fan_pwm_p) : std::nullopt;
-
-        // Temps
-        auto t_cpu  = tz_cpu  ? read_text(*tz_cpu  + "/temp") : std::nullopt;
-        auto t_gpu  = tz_gpu  ? read_text(*tz_gpu  + "/temp") : std::nullopt;
-        auto t_soc0 = tz_soc0 ? read_text(*tz_soc0 + "/temp") : std::nullopt;
-        auto t_soc1 = tz_soc1 ? read_text(*tz_soc1 + "/temp") : std::nullopt;
-        auto t_soc2 = tz_soc2 ? read_text(*tz_soc2 + "/temp") : std::nullopt;
-        auto t_tj   = tz_tj   ? read_text(*tz_tj   + "/temp") : std::nullopt;
-
-        long long vdd_in   = pwr.vdd_in_mw.load(std::memory_order_relaxed);
-        long long vdd_cgcv = pwr.vdd_cpu_gpu_cv_mw.load(std::memory_order_relaxed);
-        long long vdd_soc  = pwr.vdd_soc_mw.load(std::memory_order_relaxed);
-
-        // CSV row
-        ofs << ts << "," << dt << ","
-            << (cpu_khz ? *cpu_khz : "") << "," << (cpu_min ? *cpu_min : "") << "," << (cpu_max ? *cpu_max : "") << ","
-            << (cpu_gov ? *cpu_gov : "") << ","
-            << (gpu_hz  ? *gpu_hz  : "") << "," << (gpu_min ? *gpu_min : "") << "," << (gpu_max ? *gpu_max : "") << ","
-            << (gpu_gov ? *gpu_gov : "") << ","
-            << (fan_cur ? *fan_cur : "") << "," << (fan_max ? *fan_max : "") << "," << (fan_pwm ? *fan_pwm : "") << ","
-            << (t_cpu  ? *t_cpu  : "") << "," << (t_gpu  ? *t_gpu  : "") << ","
-            << (t_soc0 ? *t_soc0 : "") << "," << (t_soc1 ? *t_soc1 : "") << "," << (t_soc2 ? *t_soc2 : "") << ","
-            << (t_tj   ? *t_tj   : "") << ","
-            << (vdd_in   >= 0 ? std::to_string(vdd_in)   : "") << ","
-            << (vdd_cgcv >= 0 ? std::to_string(vdd_cgcv) : "") << ","
-            << (vdd_soc  >= 0 ? std::to_string(vdd_soc)  : "")
-            << "\n";
+        const int tick_ms = period_ms;  // the tuner may change period_ms mid-tick
+        next += std::chrono::milliseconds(tick_ms);
+
+        smp.sample(sample);
+
+        if (use_schema) {
+            binder.fill(sample, rec);
+            if (binary) {
+                char* p = w.reserve(ProdSchema::binary_size);
+                ProdSchema::write_binary(p, rec);
+                w.commit(p + ProdSchema::binary_size);
+            } else {
+                w.commit(ProdSchema::format_csv(w.reserve(ProdSchema::max_row), rec));
+            }
+        } else {
+            line.clear();
+            append_csv_row(line, smp, sample);
+            w.append(line);
+        }
 
         // watch-like refresh (throttled)
         if (watch_mode) {
+            const int64_t ts = sample.ts_ns;
             if (last_watch_ns == 0 || (ts - last_watch_ns) >= (int64_t)watch_ms * 1000000LL) {
                 last_watch_ns = ts;
-                print_watch_block(
-                    watch_initialized,
-                    cpu_khz, cpu_min, cpu_max, cpu_gov,
-                    gpu_hz, gpu_min, gpu_max, gpu_gov,
-                    fan_cur, fan_max, fan_pwm,
-                    t_cpu, t_gpu, t_soc0, t_soc1, t_soc2, t_tj,
-                    vdd_in, vdd_cgcv, vdd_soc
-                );
+                auto lines = format_watch_lines(smp, sample);
+                if (tuner) {
+                    char tb[96];
+                    std::snprintf(tb, sizeof(tb), "Tune: period=%dms overhead=%.2f%% budget=%.2f%% |",
+                                  period_ms, tuner->overhead() * 100, tuner->budget() * 100);
+                    lines.push_back(tb + (" " + tune_note));
+                }
+                print_watch_block(watch_initialized, lines);
             }
         }
 
-        if (++line_cnt % 10 == 0) ofs.flush();
-        std::this_thread::sleep_until(next);
+        if (++line_cnt % flush_rows == 0 && !w.flush()) {
+            std::cerr << "Write failed: " << out << "\n";
+            break;
+        }
+        if (sample.ts_ns - last_anchor_ns >= anchor_ns) {
+            write_anchor();
+            last_anchor_ns = sample.ts_ns;
+        }
+        if (rpm_ns && sample.ts_ns - last_rpm_ns >= rpm_ns) {
+            rpm.poll(rpm_d);
+            line.clear();
+            append_rpm_rows(line, sample.ts_ns, (double)(sample.ts_ns - last_rpm_ns) / 1e6, rpm_d);
+            rw.append(line);
+            rw.flush();
+            last_rpm_ns = sample.ts_ns;
+        }
+        if (tuner && tuner->tick(period_ms, tune_note)) {
+            if (!watch_mode) std::cerr << "[tune] " << tune_note << "\n";
+            char tb[64];
+            std::snprintf(tb, sizeof(tb), ",%d,%.3f,", period_ms, tuner->overhead() * 100);
+            tw.append(std::to_string(sample.ts_ns) + tb + "\"" + tune_note + "\"\n");
+            tw.flush();
+        }
+        smp.wait_until(next, tick_ms);
     }
 
-    ofs.flush();
+    w.flush();
+    write_anchor();
+    markers.stop();
     if (watch_mode) std::cerr << "\n";
-    if (pwr_thr.joinable()) pwr_thr.join();
-    std::cerr << "Stopped.\n";
+    std::cerr << "Stopped.";
+    if (markers.count()) std::cerr << " markers=" << markers.count();
+    std::cerr << "\n";
+    return 0;
+}
+
+// ---- 3.5 sensors ----
+// Show how the registry resolves on this board (or dump the built-in config).
+static int cmd_sensors(int argc, char** argv) {
+    if (has_flag(argc, argv, "--default")) {
+        std::cout << kDefaultSensors;
+        return 0;
+    }
+    std::vector<SensorSpec> specs;
+    if (!load_sensor_specs(argc, argv, specs)) return 2;
+
+    Sampler smp;
+    std::string err;
+    if (!smp.init(specs, get_flags(argc, argv, "--filter"), get_flags(argc, argv, "--derive"), 100, err)) {
+        std::cerr << err << "\n";
+        return 3;
+    }
+    Sample s;
+    smp.prepare(s);
+    smp.sample(s);
+    const auto& sens = smp.sensors();
+    for (size_t i = 0; i < smp.columns().size(); ++i) {
+        std::cout << smp.columns()[i] << "  ";
+        if (i < sens.size()) {
+            std::cout << "src=" << (sens[i].source.empty() ? "NOT_FOUND" : sens[i].source)
+                      << "  unit=" << (sens[i].spec.unit.empty() ? "-" : sens[i].spec.unit)
+                      << "  every=" << sens[i].every << "  value="
+                      << (sens[i].fmt == SensorFmt::Text ? s.text[i]
+                          : std::isnan(s.num[i]) ? std::string("NA") : std::to_string((long long)s.num[i]));
+        } else {
+            std::cout << "computed";
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+// ---- 3.6 analyze ----
+// Default mode streams a CSV in kDeriveBatch-row column batches: evaluates
+// --derive programs, optionally writes the augmented CSV, and prints
+// per-column stats. --where / --group-by / --agg / --fit switch to query
+// mode over an in-memory columnar frame.
+static void split_csv(const std::string& line, std::vector<std::pair<const char*, const char*>>& f) {
+    f.clear();
+    const char* b = line.data();
+    const char* e = b + line.size();
+    const char* p = b;
+    for (const char* q = b; q <= e; ++q) {
+        if (q == e || *q == ',') { f.emplace_back(p, q); p = q + 1; }
+    }
+}
+
+struct ColStats {
+    long long n = 0;
+    double sum = 0.0, mn = 0.0, mx = 0.0;
+    void add(double v) {
+        if (std::isnan(v)) return;
+        if (n == 0 || v < mn) mn = v;
+        if (n == 0 || v > mx) mx = v;
+        sum += v;
+        n++;
+    }
+};
+
+// Query mode: load a columnar frame, filter with --where, aggregate per --group-by.
+static int analyze_query(int argc, char** argv, const std::string& in) {
+    Frame fr;
+    std::string err;
+    if (!fr.load(in, err)) {
+        std::cerr << "analyze: " << err << "\n";
+        return 1;
+    }
+    const size_t nrows = fr.rows();
+
+    // Derived columns: only the base columns they reference are parsed.
+    const std::vector<std::string> base_names = fr.names();
+    DeriveSet derive(base_names);
+    if (!add_cli_derives(derive, argc, argv)) return 2;
+    if (!derive.empty()) {
+        const auto used = derive.base_refs();
+        std::vector<double*> outs(derive.size());
+        for (size_t d = 0; d < derive.size(); ++d) fr.add_f64(derive.name(d), outs[d]);
+
+        std::vector<const FrameCol*> src(base_names.size(), nullptr);
+        for (size_t c = 0; c < base_names.size(); ++c) if (used[c]) src[c] = fr.col(base_names[c]);
+        std::vector<std::vector<double>> batch(base_names.size());
+        std::vector<double> nan_batch(kDeriveBatch, std::nan(""));
+        std::vector<const double*> ptrs(base_names.size(), nan_batch.data());
+        for (size_t c = 0; c < base_names.size(); ++c) {
+            if (!src[c]) continue;
+            batch[c].resize(kDeriveBatch);
+            ptrs[c] = batch[c].data();
+        }
+        for (size_t r0 = 0; r0 < nrows; r0 += kDeriveBatch) {
+            const size_t n = std::min(kDeriveBatch, nrows - r0);
+            for (size_t c = 0; c < base_names.size(); ++c) {
+                if (!src[c]) continue;
+                // Dictionary codes are not numbers.
+                for (size_t i = 0; i < n; ++i)
+                    batch[c][i] = src[c]->type == ColType::Dict ? std::nan("") : src[c]->get(r0 + i);
+            }
+            derive.eval(ptrs.data(), n);
+            for (size_t d = 0; d < derive.size(); ++d)
+                std::memcpy(outs[d] + r0, derive.out(d), n * sizeof(double));
+        }
+    }
+
+    // Selection vector, narrowed by each predicate in turn (AND).
+    std::vector<uint32_t> sel(nrows);
+    for (size_t i = 0; i < nrows; ++i) sel[i] = (uint32_t)i;
+    size_t nsel = nrows;
+    for (auto& spec : get_flags(argc, argv, "--where")) {
+        WherePred w;
+        if (!parse_where(spec, w)) {
+            std::cerr << "Bad --where '" << spec << "' (expected: <col> <op> <value>)\n";
+            return 2;
+        }
+        const FrameCol* c = fr.col(w.col);
+        if (!c) {
+            std::cerr << "Bad --where '" << spec << "': unknown column '" << w.col << "'\n";
+            return 2;
+        }
+        double k;
+        if (c->type == ColType::Dict) {
+            if (w.op != CmpOp::Eq && w.op != CmpOp::Ne) {
+                std::cerr << "Bad --where '" << spec << "': text columns only support == and !=\n";
+                return 2;
+            }
+            auto it = std::find(c->dict.begin(), c->dict.end(), w.rhs);
+            k = (it == c->dict.end()) ? -2.0 : (double)(it - c->dict.begin());
+        } else {
+            k = parse_num(w.rhs.data(), w.rhs.data() + w.rhs.size());
+            if (std::isnan(k)) {
+                std::cerr << "Bad --where '" << spec << "': '" << w.rhs << "' is not a number\n";
+                return 2;
+            }
+        }
+        visit_col(*c, [&](auto* v, auto miss) { nsel = filter_sel(v, miss, w.op, k, sel.data(), nsel); });
+    }
+
+    // Linear models over the selected rows instead of a grouped table.
+    const auto fits = get_flags(argc, argv, "--fit");
+    for (auto& spec : fits) {
+        std::string yname;
+        std::vector<std::string> xnames;
+        if (!parse_fit_formula(spec, yname, xnames)) {
+            std::cerr << "Bad --fit '" << spec << "' (expected: <col> ~ <col> [+ <col> ...])\n";
+            return 2;
+        }
+        std::vector<std::vector<double>> cols;
+        for (size_t j = 0; j <= xnames.size(); ++j) {
+            const std::string& name = j ? xnames[j - 1] : yname;
+            const FrameCol* c = fr.col(name);
+            if (!c || c->type == ColType::Dict) {
+                std::cerr << "Bad --fit '" << spec << "': " << (c ? "text" : "unknown") << " column '" << name << "'\n";
+                return 2;
+            }
+            std::vector<double> v(nsel);
+            for (size_t i = 0; i < nsel; ++i) v[i] = c->get(sel[i]);
+            cols.push_back(std::move(v));
+        }
+        std::vector<const double*> xs;
+        for (size_t j = 1; j < cols.size(); ++j) xs.push_back(cols[j].data());
+        LinFit lf;
+        if (!fit_linear(xs, cols[0].data(), nsel, lf, err)) {
+            std::cerr << "--fit '" << spec << "': " << err << "\n";
+            return 3;
+        }
+        std::printf("fit: %s (n=%zu r2=%.4f rmse=%.4g)\n", spec.c_str(), lf.n, lf.r2, lf.rmse);
+        std::printf("%-24s %14s %14s %14s\n", "term", "coef", "mean", "contrib");
+        std::printf("%-24s %14.6g %14s %14.6g\n", "(intercept)", lf.coef[0], "", lf.coef[0]);
+        // Derive expression that reproduces the model on another log.
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.9g", lf.coef[0]);
+        std::string expr = yname + "_fit=" + buf;
+        for (size_t j = 0; j < xnames.size(); ++j) {
+            const double b = lf.coef[j + 1];
+            std::printf("%-24s %14.6g %14.6g %14.6g\n", xnames[j].c_str(), b, lf.mean[j], b * lf.mean[j]);
+            std::snprintf(buf, sizeof(buf), " %c %.9g * ", b < 0 ? '-' : '+', std::fabs(b));
+            expr += buf + xnames[j];
+        }
+        std::printf("derive: %s\n\n", expr.c_str());
+    }
+    if (!fits.empty()) {
+        std::cerr << "rows: " << nrows << " selected: " << nsel << "\n";
+        return 0;
+    }
+
+    // Group keys
+    std::vector<const FrameCol*> keys;
+    for (auto& spec : get_flags(argc, argv, "--group-by")) {
+        for (auto& name : split_top(spec)) {
+            const FrameCol* c = fr.col(name);
+            if (!c) {
+                std::cerr << "Bad --group-by: unknown column '" << name << "'\n";
+                return 2;
+            }
+            keys.push_back(c);
+        }
+    }
+
+    // Aggregates (default: count)
+    std::vector<AggSpec> aggs;
+    std::vector<const FrameCol*> agg_cols;
+    for (auto& spec : get_flags(argc, argv, "--agg")) {
+        for (auto& one : split_top(spec)) {
+            AggSpec a;
+            if (!parse_agg(one, a)) {
+                std::cerr << "Bad --agg '" << one << "' (count, sum(c), mean(c), min(c), max(c))\n";
+                return 2;
+            }
+            const FrameCol* c = nullptr;
+            if (!a.col.empty() && !(c = fr.col(a.col))) {
+                std::cerr << "Bad --agg '" << one << "': unknown column '" << a.col << "'\n";
+                return 2;
+            }
+            if (c && c->type == ColType::Dict && a.fn != AggFn::Count) {
+                std::cerr << "Bad --agg '" << one << "': text column '" << a.col << "' (only count)\n";
+                return 2;
+            }
+            aggs.push_back(a);
+            agg_cols.push_back(c);
+        }
+    }
+    if (aggs.empty()) {
+        AggSpec a;
+        a.label = "count";
+        aggs.push_back(a);
+        agg_cols.push_back(nullptr);
+    }
+
+    // Group rows. Rows with a missing key are dropped.
+    std::map<std::vector<double>, size_t> groups;
+    std::vector<long long> grows;
+    std::vector<AggAcc> accs;
+    std::vector<double> key(keys.size());
+    std::vector<uint32_t> gid(nsel);
+    size_t nkept = 0;
+    for (size_t i = 0; i < nsel; ++i) {
+        const uint32_t r = sel[i];
+        bool ok = true;
+        for (size_t k = 0; k < keys.size() && ok; ++k) {
+            key[k] = keys[k]->get(r);
+            ok = !std::isnan(key[k]);
+        }
+        if (!ok) continue;
+        auto [it, fresh] = groups.emplace(key, grows.size());
+        if (fresh) {
+            grows.push_back(0);
+            accs.resize(accs.size() + aggs.size());
+        }
+        grows[it->second]++;
+        sel[nkept] = r;
+        gid[nkept++] = (uint32_t)it->second;
+    }
+    // Column-at-a-time accumulation over the surviving rows.
+    for (size_t a = 0; a < aggs.size(); ++a) {
+        if (!agg_cols[a]) continue;
+        visit_col(*agg_cols[a], [&](auto* v, auto miss) {
+            for (size_t i = 0; i < nkept; ++i) {
+                const auto x = v[sel[i]];
+                if constexpr (std::is_floating_point_v<decltype(x)>) { (void)miss; accs[gid[i] * aggs.size() + a].add(x); }
+                else if (x != miss) accs[gid[i] * aggs.size() + a].add((double)x);
+            }
+        });
+    }
+
+    // Output: one CSV-ish table sorted by key.
+    std::string line;
+    for (auto* k : keys) { line += k->name; line.push_back(','); }
+    for (size_t a = 0; a < aggs.size(); ++a) { line += aggs[a].label; line.push_back(a + 1 < aggs.size() ? ',' : '\n'); }
+    std::cout << line;
+    for (auto& [kv, g] : groups) {
+        line.clear();
+        for (size_t k = 0; k < keys.size(); ++k) {
+            if (keys[k]->type == ColType::Dict) line += keys[k]->dict[(size_t)kv[k]];
+            else append_num(line, kv[k]);
+            line.push_back(',');
+        }
+        for (size_t a = 0; a < aggs.size(); ++a) {
+            append_num(line, accs[g * aggs.size() + a].result(aggs[a], grows[g]));
+            line.push_back(a + 1 < aggs.size() ? ',' : '\n');
+        }
+        std::cout << line;
+    }
+    std::cerr << "rows: " << nrows << " selected: " << nkept << " groups: " << groups.size() << "\n";
+    return 0;
+}
+
+static int cmd_analyze(int argc, char** argv) {
+    auto in = get_flag(argc, argv, "--in");
+    if (!in) {
+        std::cerr << "analyze requires --in <csv>\n";
+        return 2;
+    }
+    if (has_flag(argc, argv, "--where") || has_flag(argc, argv, "--group-by") || has_flag(argc, argv, "--agg") ||
+        has_flag(argc, argv, "--fit"))
+        return analyze_query(argc, argv, *in);
+
+    auto out = get_flag(argc, argv, "--out");
+
+    std::ifstream ifs(*in);
+    if (!ifs) {
+        std::cerr << "Failed to open: " << *in << "\n";
+        return 1;
+    }
+    std::string header;
+    if (!std::getline(ifs, header)) {
+        std::cerr << "Empty CSV: " << *in << "\n";
+        return 1;
+    }
+    if (!header.empty() && header.back() == '\r') header.pop_back();
+
+    std::vector<std::string> names;
+    {
+        std::vector<std::pair<const char*, const char*>> f;
+        split_csv(header, f);
+        for (auto& x : f) names.emplace_back(x.first, x.second);
+    }
+    const size_t ncol = names.size();
+
+    DeriveSet derive(names);
+    if (!add_cli_derives(derive, argc, argv)) return 2;
+
+    std::ofstream ofs;
+    if (out) {
+        ofs.open(*out);
+        if (!ofs) {
+            std::cerr << "Failed to open: " << *out << "\n";
+            return 1;
+        }
+        ofs << header;
+        for (size_t i = 0; i < derive.size(); ++i) ofs << "," << derive.name(i);
+        ofs << "\n";
+    }
+
+    // Column-major batch buffers.
+    std::vector<std::vector<double>> batch(ncol, std::vector<double>(kDeriveBatch));
+    std::vector<const double*> ptrs(ncol);
+    for (size_t c = 0; c < ncol; ++c) ptrs[c] = batch[c].data();
+    std::vector<std::string> lines(kDeriveBatch);
+    std::vector<ColStats> stats(ncol + derive.size());
+    std::vector<std::pair<const char*, const char*>> f;
+    std::string outbuf;
+    long long rows = 0;
+
+    auto flush_batch = [&](size_t n) {
+        derive.eval(ptrs.data(), n);
+        for (size_t c = 0; c < ncol; ++c)
+            for (size_t i = 0; i < n; ++i) stats[c].add(batch[c][i]);
+        for (size_t d = 0; d < derive.size(); ++d)
+            for (size_t i = 0; i < n; ++i) stats[ncol + d].add(derive.out(d)[i]);
+        if (out) {
+            outbuf.clear();
+            for (size_t i = 0; i < n; ++i) {
+                outbuf += lines[i];
+                for (size_t d = 0; d < derive.size(); ++d) {
+                    outbuf.push_back(',');
+                    append_num(outbuf, derive.out(d)[i]);
+                }
+                outbuf.push_back('\n');
+            }
+            ofs.write(outbuf.data(), (std::streamsize)outbuf.size());
+        }
+    };
+
+    size_t n = 0;
+    while (std::getline(ifs, lines[n])) {
+        std::string& line = lines[n];
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        split_csv(line, f);
+        for (size_t c = 0; c < ncol; ++c) {
+            batch[c][n] = (c < f.size()) ? parse_num(f[c].first, f[c].second) : std::nan("");
+        }
+        rows++;
+        if (++n == kDeriveBatch) { flush_batch(n); n = 0; }
+    }
+    if (n) flush_batch(n);
+
+    std::cout << "rows: " << rows << "\n";
+    std::printf("%-24s %10s %16s %16s %16s\n", "column", "n", "mean", "min", "max");
+    for (size_t c = 0; c < stats.size(); ++c) {
+        const auto& st = stats[c];
+        if (st.n == 0) continue;
+        const std::string& nm = (c < ncol) ? names[c] : derive.name(c - ncol);
+        std::printf("%-24s %10lld %16.6g %16.6g %16.6g\n", nm.c_str(), st.n, st.sum / st.n, st.mn, st.mx);
+    }
+    return 0;
+}
+
+// ---- 3.7 dump ----
+// Convert a --format bin log back to CSV using the compile-time schema.
+static int cmd_dump(int argc, char** argv) {
+    auto in = get_flag(argc, argv, "--in");
+    if (!in) {
+        std::cerr << "dump requires --in <bin>\n";
+        return 2;
+    }
+    std::ifstream ifs(*in, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Failed to open: " << *in << "\n";
+        return 1;
+    }
+    std::string hdr;
+    std::getline(ifs, hdr);
+    const std::string want = std::string(kBinMagic) +
+        std::string(ProdSchema::header.data(), ProdSchema::header.size() - 1);
+    if (hdr != want) {
+        std::cerr << "Not a dvfs_tool binary log with this build's schema: " << *in << "\n";
+        return 1;
+    }
+
+    std::ofstream ofs;
+    if (auto out = get_flag(argc, argv, "--out")) {
+        ofs.open(*out);
+        if (!ofs) {
+            std::cerr << "Failed to open: " << *out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& os = ofs.is_open() ? static_cast<std::ostream&>(ofs) : std::cout;
+
+    os.write(ProdSchema::header.data(), (std::streamsize)ProdSchema::header.size());
+    char bin[ProdSchema::binary_size];
+    char txt[ProdSchema::max_row];
+    ProdSchema::Record rec{};
+    while (ifs.read(bin, sizeof(bin))) {
+        ProdSchema::read_binary(bin, rec);
+        char* end = ProdSchema::format_csv(txt, rec);
+        os.write(txt, end - txt);
+    }
+    return 0;
+}
+
+// ---- 3.8 bench ----
+// Output-path microbenchmark on synthetic built-in rows: the legacy
+// ofstream/operator<< formatting vs the buffered to_chars writer with the
+// compile-time schema. Reports rows/s and CPU ns per row; run it on the target.
+static double cpu_seconds() {
+    timespec t{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// bench --sampler: sampler scaling on a generated fake sysfs tree (one
+// value file per sensor under --fixture) for each sensor count x thread count;
+// back-to-back ticks, reports mean / p50 / p99 wall time per tick.
+static std::vector<int> parse_int_list(const std::string& s) {
+    std::vector<int> out;
+    for (const auto& f : split_top(s)) if (!f.empty()) out.push_back(std::stoi(f));
+    return out;
+}
+
+static int cmd_bench_sampler(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    const fs::path dir = get_flag(argc, argv, "--fixture").value_or("/tmp/dvfs_fake_sysfs");
+    auto counts = parse_int_list(get_flag(argc, argv, "--sensors_n").value_or("10,30,100,300,1000"));
+    auto threads = parse_int_list(get_flag(argc, argv, "--threads").value_or("1,2,4"));
+    long long ticks = 2000;
+    if (auto t = get_flag(argc, argv, "--ticks")) ticks = std::stoll(*t);
+    if (ticks <= 0) ticks = 2000;
+    const bool pin = !has_flag(argc, argv, "--no_pin");
+
+    int max_n = 0;
+    for (int n : counts) max_n = std::max(max_n, n);
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    for (int i = 0; i < max_n; ++i) {
+        const fs::path zone = dir / ("zone" + std::to_string(i));
+        fs::create_directories(zone, ec);
+        std::ofstream(zone / "temp") << 40000 + (i * 37) % 10000 << "\n";
+    }
+    if (ec) {
+        std::cerr << "Failed to create fixture: " << dir.string() << ": " << ec.message() << "\n";
+        return 1;
+    }
+    std::printf("fixture %s, %lld ticks, %u CPUs\n", dir.c_str(), ticks, std::thread::hardware_concurrency());
+    std::printf("%8s %7s %12s %12s %12s %8s\n", "sensors", "threads", "mean_us", "p50_us", "p99_us", "speedup");
+
+    for (int n : counts) {
+        std::string cfg;
+        for (int i = 0; i < n; ++i) {
+            cfg += "name=s" + std::to_string(i) + " type=sysfs path=" + (dir / ("zone" + std::to_string(i)) / "temp").string() +
+                   " unit=mC\n";
+        }
+        double base_mean = 0.0;
+        for (int t : threads) {
+            std::vector<SensorSpec> specs;
+            std::string err;
+            Sampler smp;
+            if (!parse_sensor_config(cfg, "<bench>", specs, err) || !smp.init(std::move(specs), {}, {}, 1, err) ||
+                !smp.set_threads(t, pin, err)) {
+                std::cerr << err << "\n";
+                return 3;
+            }
+            Sample s;
+            smp.prepare(s);
+            for (int i = 0; i < 50; ++i) smp.sample(s);  // warm page cache and wake the pool
+            std::vector<int64_t> dt((size_t)ticks);
+            for (auto& d : dt) {
+                const int64_t t0 = now_ns();
+                smp.sample(s);
+                d = now_ns() - t0;
+            }
+            double sum = 0.0;
+            for (int64_t d : dt) sum += (double)d;
+            const double mean = sum / (double)ticks;
+            std::sort(dt.begin(), dt.end());
+            const double p50 = (double)dt[dt.size() / 2], p99 = (double)dt[(dt.size() * 99) / 100];
+            if (t == threads.front()) base_mean = mean;
+            std::printf("%8d %7d %12.1f %12.1f %12.1f %7.2fx\n", n, smp.threads(), mean / 1e3, p50 / 1e3, p99 / 1e3,
+                        base_mean / mean);
+        }
+    }
+    return 0;
+}
+
+// Per-value cost of one filter chain over a noisy synthetic signal.
+static int cmd_bench_filter(int argc, char** argv, const std::string& chain) {
+    SensorFilter f;
+    std::string err;
+    if (!parse_filter("x:" + chain, {"x"}, f, err)) {
+        std::cerr << "Bad --filter '" << chain << "': " << err << "\n";
+        return 2;
+    }
+    long long values = 10000000;
+    if (auto v = get_flag(argc, argv, "--values")) values = std::max(1LL, std::stoll(*v));
+    // Level steps plus noise and the odd glitch, like a rail reading.
+    std::vector<double> in(4096);
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < in.size(); ++i) {
+        rng = rng * 1664525u + 1013904223u;
+        in[i] = 5000.0 + ((i / 512) % 2) * 1500.0 + (double)(rng >> 24) - 128.0 + ((rng & 0xff) == 0 ? 4000.0 : 0.0);
+    }
+    double sink = 0.0;
+    const double c0 = cpu_seconds();
+    const int64_t w0 = now_ns();
+    for (long long i = 0; i < values; ++i) sink += f.step(in[(size_t)i & 4095]);
+    const double wall = (now_ns() - w0) * 1e-9, cpu = cpu_seconds() - c0;
+    std::printf("%-30s %10.1f ns/value (wall) %10.1f ns/value (CPU)  [%g]\n", chain.c_str(), wall * 1e9 / values,
+                cpu * 1e9 / values, sink / values);
+    return 0;
+}
+
+// N in-process stream clients -> collect over 127.0.0.1, then check the
+// merged CSV: every row arrives once, per-board order holds, ts_ns never
+// goes backwards and values (integral, fractional, missing) survive.
+static int cmd_bench_loopback(int argc, char** argv) {
+    int boards = 4;
+    if (auto b = get_flag(argc, argv, "--boards")) boards = std::max(1, std::stoi(*b));
+    long long rows = 2000;
+    if (auto r = get_flag(argc, argv, "--rows")) rows = std::max(1LL, std::stoll(*r));
+    int batch_rows = 10;
+    if (auto b = get_flag(argc, argv, "--batch_rows")) batch_rows = std::max(1, std::stoi(*b));
+    int period_us = 500;
+    if (auto p = get_flag(argc, argv, "--period_us")) period_us = std::max(0, std::stoi(*p));
+    const std::string out = get_flag(argc, argv, "--out").value_or("/tmp/dvfs_loopback.csv");
+
+    MergeStore store;
+    if (!store.open(out)) {
+        std::cerr << "Failed to open: " << out << "\n";
+        return 1;
+    }
+    Collector col(store);
+    std::string err;
+    if (!col.start(0, 0, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const std::string to = "127.0.0.1:" + std::to_string(col.port());
+    const std::vector<std::string> cols = {"seq", "board_id", "x"};
+    auto value_x = [](int b, long long i) { return (i % 10 == 9) ? std::nan("") : b + 0.25 * (double)i; };
+
+    const int64_t w0 = now_ns();
+    std::vector<std::thread> th;
+    std::vector<std::string> errs((size_t)boards);
+    for (int b = 0; b < boards; ++b) {
+        th.emplace_back([&, b] {
+            StreamClient cli;
+            cli.set_batch_rows((size_t)batch_rows);
+            std::string e;
+            if (!cli.connect(to, "b" + std::to_string(b), cols, e)) {
+                errs[(size_t)b] = e;
+                return;
+            }
+            for (long long i = 0; i < rows; ++i) {
+                const double v[3] = {(double)i, (double)b, value_x(b, i)};
+                if (!cli.push(now_ns(), v)) {
+                    errs[(size_t)b] = "push failed";
+                    return;
+                }
+                if (period_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(period_us));
+            }
+            cli.close();
+        });
+    }
+    for (auto& t : th) t.join();
+    for (int b = 0; b < boards; ++b) {
+        if (!errs[(size_t)b].empty()) {
+            std::cerr << "board b" << b << ": " << errs[(size_t)b] << "\n";
+            return 1;
+        }
+    }
+    const uint64_t want = (uint64_t)boards * (uint64_t)rows;
+    for (int i = 0; i < 500 && store.rows_written() < want; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    col.stop();
+    store.close();
+    const double wall = (now_ns() - w0) * 1e-9;
+
+    // board,ts_ns,src_ts_ns,seq,board_id,x
+    std::ifstream ifs(out);
+    std::string line;
+    std::getline(ifs, line);
+    std::vector<long long> next((size_t)boards, 0);
+    long long n = 0, bad = 0;
+    int64_t prev_ts = INT64_MIN;
+    auto fail = [&](const std::string& why) {
+        if (bad++ < 5) std::cerr << "row " << n << ": " << why << ": " << line << "\n";
+    };
+    while (std::getline(ifs, line)) {
+        ++n;
+        if (line.empty()) { fail("empty line"); continue; }
+        std::vector<std::string> f;
+        std::istringstream ls(line);
+        for (std::string t; std::getline(ls, t, ',');) f.push_back(t);
+        if (line.back() == ',') f.emplace_back();
+        if (f.size() != 6 || f[0].size() < 2 || f[0][0] != 'b') { fail("bad shape"); continue; }
+        const int b = std::atoi(f[0].c_str() + 1);
+        if (b < 0 || b >= boards) { fail("unknown board"); continue; }
+        const int64_t ts = std::stoll(f[1]);
+        if (ts < prev_ts) fail("ts_ns went backwards");
+        prev_ts = ts;
+        const long long seq = std::stoll(f[3]);
+        if (seq != next[(size_t)b]) fail("expected seq " + std::to_string(next[(size_t)b]));
+        next[(size_t)b] = seq + 1;
+        if (std::stoi(f[4]) != b) fail("board_id mismatch");
+        const double x = value_x(b, seq);
+        if (std::isnan(x) ? !f[5].empty() : (f[5].empty() || std::stod(f[5]) != x)) fail("x mismatch");
+    }
+    for (int b = 0; b < boards; ++b) {
+        if (next[(size_t)b] != rows) {
+            ++bad;
+            std::cerr << "board b" << b << ": " << next[(size_t)b] << " of " << rows << " rows\n";
+        }
+    }
+    std::printf("%d boards x %lld rows via %s -> %s: %lld rows merged in %.2f s, %s\n", boards, rows, to.c_str(),
+                out.c_str(), n, wall, bad ? "FAIL" : "ok");
+    return bad ? 1 : 0;
+}
+
+static int cmd_bench(int argc, char** argv) {
+    if (has_flag(argc, argv, "--sampler")) return cmd_bench_sampler(argc, argv);
+    if (has_flag(argc, argv, "--loopback")) return cmd_bench_loopback(argc, argv);
+    if (auto f = get_flag(argc, argv, "--filter")) return cmd_bench_filter(argc, argv, *f);
+    long long rows = 200000;
+    if (auto r = get_flag(argc, argv, "--rows")) rows = std::stoll(*r);
+    if (rows <= 0) rows = 200000;
+    const std::string out = get_flag(argc, argv, "--out").value_or("/dev/null");
+    // Same flush cadence as log (--flush_rows) so the comparison is like for like.
+    long long flush_rows = 10;
+    if (auto f = get_flag(argc, argv, "--flush_rows")) flush_rows = std::stoll(*f);
+    if (flush_rows <= 0) flush_rows = 10;
+
+    // A plausible row; the values vary a little so nothing folds away.
+    auto text_val = [](size_t c) -> const std::string& {
+        static const std::string v[] = {"schedutil", "nvhost_podgov", "active"};
+        return v[c == 5 ? 0 : c == 9 ? 1 : 2];
+    };
+    auto row_val = [](long long i, size_t c) -> long long {
+        static const long long base[] = {0, 0, 1190400, 115200, 1728000, 0, 306000000, 306000000, 1020000000, 0,
+                                         412, 0, 1843200, 611500, 0, 3, 73, 47812, 48781, 48500, 48218, 47906,
+                                         48781, 5658, 1231, 1472};
+        return base[c] + (i & 7);
+    };
+    // Real columns: psi_* (26..30), then gpu_gated_pct.
+    auto real_val = [](long long i, size_t c) { return (c < 31 ? 0.5 * (double)(c - 25) : 12.5) + 0.125 * (double)(i & 7); };
+
+    auto report = [&](const char* name, double wall, double cpu) {
+        std::printf("%-22s %12.0f rows/s  %8.1f ns CPU/row\n", name, rows / wall, cpu * 1e9 / rows);
+    };
+
+    // 1) legacy: ofstream, operator<< per field, std::to_string for power
+    {
+        std::ofstream ofs(out);
+        const double c0 = cpu_seconds();
+        const int64_t w0 = now_ns();
+        for (long long i = 0; i < rows; ++i) {
+            std::optional<std::string> s[32];
+            for (size_t c = 2; c < 23; ++c) s[c] = std::to_string(row_val(i, c));
+            s[5] = text_val(5);
+            s[9] = text_val(9);
+            s[11] = text_val(11);
+            ofs << i << "," << (i ? 100000000 : 0) << ",";
+            for (size_t c = 2; c < 23; ++c) ofs << (s[c] ? *s[c] : "") << ",";
+            ofs << std::to_string(row_val(i, 23)) << "," << std::to_string(row_val(i, 24)) << ","
+                << std::to_string(row_val(i, 25));
+            for (size_t c = 26; c < 32; ++c) ofs << "," << std::to_string(real_val(i, c));
+            ofs << "\n";
+            if (i % flush_rows == flush_rows - 1) ofs.flush();
+        }
+        ofs.flush();
+        report("ofstream (legacy)", (now_ns() - w0) * 1e-9, cpu_seconds() - c0);
+    }
+
+    // 2) buffered writer + compile-time schema
+    {
+        BufWriter w;
+        if (!w.open(out)) {
+            std::cerr << "Failed to open: " << out << "\n";
+            return 1;
+        }
+        ProdSchema::Record rec{};
+        const double c0 = cpu_seconds();
+        const int64_t w0 = now_ns();
+        for (long long i = 0; i < rows; ++i) {
+            size_t c = 0;
+            auto set = [&](auto& x) {
+                using T = std::decay_t<decltype(x)>;
+                if constexpr (std::is_same_v<T, int64_t>) x = row_val(i, c);
+                else if constexpr (std::is_same_v<T, double>) x = real_val(i, c);
+                else x.assign(text_val(c));
+                c++;
+            };
+            std::apply([&](auto&... f) { (set(f), ...); }, rec);
+            std::get<0>(rec) = i;
+            w.commit(ProdSchema::format_csv(w.reserve(ProdSchema::max_row), rec));
+            if (i % flush_rows == flush_rows - 1) w.flush();
+        }
+        w.flush();
+        report("bufwriter + schema", (now_ns() - w0) * 1e-9, cpu_seconds() - c0);
+    }
+    return 0;
+}
+
+// ---- 3.9 stream ----
+// Sample like log, but ship rows to a collector instead of a file.
+static int cmd_stream(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+
+    auto to = get_flag(argc, argv, "--to");
+    if (!to) {
+        std::cerr << "stream needs --to <host:port>\n";
+        return 2;
+    }
+    int period_ms = 100;
+    if (auto p = get_flag(argc, argv, "--period_ms")) period_ms = std::stoi(*p);
+    if (period_ms <= 0) period_ms = 100;
+    int batch_rows = 10;
+    if (auto b = get_flag(argc, argv, "--batch_rows")) batch_rows = std::stoi(*b);
+    long long max_rows = 0;  // 0 = until Ctrl+C
+    if (auto r = get_flag(argc, argv, "--rows")) max_rows = std::stoll(*r);
+    std::string board;
+    if (auto b = get_flag(argc, argv, "--board")) {
+        board = *b;
+    } else {
+        char host[256] = {};
+        board = (::gethostname(host, sizeof(host) - 1) == 0) ? host : "board";
+    }
+
+    std::vector<SensorSpec> specs;
+    if (!load_sensor_specs(argc, argv, specs)) return 2;
+    Sampler smp;
+    std::string err;
+    if (!smp.init(specs, get_flags(argc, argv, "--filter"), get_flags(argc, argv, "--derive"), period_ms, err)) {
+        std::cerr << err << "\n";
+        return 3;
+    }
+    if (!set_sample_threads(argc, argv, smp)) return 3;
+
+    std::unique_ptr<OverheadTuner> tuner;
+    if (!make_tuner(argc, argv, smp, period_ms, tuner)) return 2;
+
+    StreamClient cli;
+    cli.set_batch_rows((size_t)std::max(1, batch_rows));
+    if (!cli.connect(*to, board, smp.columns(), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::cerr << "Streaming " << board << " -> " << *to << " period=" << period_ms
+              << "ms offset=" << cli.offset_ns() << "ns rtt=" << cli.rtt_ns() << "ns\n";
+
+    using clock = std::chrono::steady_clock;
+    auto next = clock::now();
+    Sample sample;
+    smp.prepare(sample);
+    long long rows = 0;
+    int rc = 0;
+    while (!g_stop && (max_rows == 0 || rows < max_rows)) {
+        const int tick_ms = period_ms;
+        next += std::chrono::milliseconds(tick_ms);
+        smp.sample(sample);
+        if (!cli.push(sample.ts_ns, sample.num.data())) {
+            std::cerr << "Stream write failed: " << *to << "\n";
+            rc = 4;
+            break;
+        }
+        rows++;
+        std::string note;
+        if (tuner && tuner->tick(period_ms, note)) std::cerr << "[tune] " << note << "\n";
+        smp.wait_until(next, tick_ms);
+    }
+    cli.close();
+    std::cerr << "Stopped. rows=" << rows << " bytes=" << cli.bytes_sent() << "\n";
+    return rc;
+}
+
+// ---- 3.10 collect ----
+// Merge many board streams into one time-ordered CSV until Ctrl+C.
+static int cmd_collect(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+
+    const std::string out = get_flag(argc, argv, "--out").value_or("fleet.csv");
+    int port = 7070;
+    if (auto p = get_flag(argc, argv, "--listen")) port = std::stoi(*p);
+    int threads = 0;
+    if (auto t = get_flag(argc, argv, "--threads")) threads = std::stoi(*t);
+    int64_t max_lag_ms = 2000;
+    if (auto l = get_flag(argc, argv, "--max_lag_ms")) max_lag_ms = std::stoll(*l);
+
+    MergeStore store(max_lag_ms * 1000000LL);
+    if (!store.open(out)) {
+        std::cerr << "Failed to open: " << out << "\n";
+        return 1;
+    }
+    Collector col(store);
+    col.on_event = [](const std::string& m) { std::cerr << m << "\n"; };
+    std::string err;
+    if (!col.start(port, threads, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::cerr << "Collecting on port " << col.port() << " -> " << out << "\n";
+    while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    col.stop();
+    store.close();
+    std::cerr << "Stopped. rows=" << store.rows_written() << "\n";
+    return store.ok() ? 0 : 4;
+}
+
+// ---- 3.11 timeconv ----
+// Map timestamps between clock domains through a log's .clocks anchors:
+// single values (--ts) or a whole CSV column (--in), added as a new column.
+static int cmd_timeconv(int argc, char** argv) {
+    ClockDomain from = ClockDomain::Monotonic, to = ClockDomain::Realtime;
+    if (auto f = get_flag(argc, argv, "--from"); f && !parse_clock_domain(*f, from)) {
+        std::cerr << "Bad --from: " << *f << " (mono|boot|real)\n";
+        return 2;
+    }
+    if (auto t = get_flag(argc, argv, "--to"); t && !parse_clock_domain(*t, to)) {
+        std::cerr << "Bad --to: " << *t << " (mono|boot|real)\n";
+        return 2;
+    }
+    auto in = get_flag(argc, argv, "--in");
+    const auto ts_vals = get_flags(argc, argv, "--ts");
+    if (!in && ts_vals.empty()) {
+        std::cerr << "timeconv needs --in <csv> or --ts <ns>\n";
+        return 2;
+    }
+    auto clocks = get_flag(argc, argv, "--clocks");
+    if (!clocks && in) clocks = *in + ".clocks";
+    if (!clocks) {
+        std::cerr << "timeconv --ts needs --clocks <file>\n";
+        return 2;
+    }
+    std::vector<ClockAnchor> anchors;
+    std::string err;
+    if (!load_anchors(*clocks, anchors, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    const ClockMap map(std::move(anchors));
+
+    if (!in) {
+        for (auto& v : ts_vals) {
+            int64_t unc = 0;
+            const int64_t r = map.convert(std::stoll(v), from, to, &unc);
+            std::cout << r << " +-" << unc << "ns";
+            if (to == ClockDomain::Realtime) {
+                const time_t sec = (time_t)(r / 1000000000LL);
+                tm utc{};
+                gmtime_r(&sec, &utc);
+                char buf[64];
+                std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+                char frac[16];
+                std::snprintf(frac, sizeof(frac), ".%09lldZ", (long long)(r % 1000000000LL));
+                std::cout << "  " << buf << frac;
+            }
+            std::cout << "\n";
+        }
+        return 0;
+    }
+
+    const std::string col = get_flag(argc, argv, "--col").value_or("ts_ns");
+    const std::string as = get_flag(argc, argv, "--as").value_or(col + "_" + clock_domain_name(to));
+    std::ifstream ifs(*in);
+    if (!ifs) {
+        std::cerr << "Failed to open: " << *in << "\n";
+        return 1;
+    }
+    std::string line;
+    if (!std::getline(ifs, line)) {
+        std::cerr << "Empty CSV: " << *in << "\n";
+        return 1;
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::vector<std::pair<const char*, const char*>> f;
+    split_csv(line, f);
+    size_t ci = f.size();
+    for (size_t i = 0; i < f.size(); ++i) if (std::string(f[i].first, f[i].second) == col) ci = i;
+    if (ci == f.size()) {
+        std::cerr << "No column '" << col << "' in " << *in << "\n";
+        return 2;
+    }
+
+    const std::string out = get_flag(argc, argv, "--out").value_or("/dev/stdout");
+    BufWriter w;
+    if (!w.open(out)) {
+        std::cerr << "Failed to open: " << out << "\n";
+        return 1;
+    }
+    line += "," + as + "\n";
+    w.append(line);
+    char buf[24];
+    long long rows = 0;
+    while (std::getline(ifs, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        split_csv(line, f);
+        line.push_back(',');
+        int64_t ts;
+        if (ci < f.size() && std::from_chars(f[ci].first, f[ci].second, ts).ec == std::errc())
+            line.append(buf, std::to_chars(buf, buf + sizeof(buf), map.convert(ts, from, to)).ptr);
+        line.push_back('\n');
+        w.append(line);
+        rows++;
+    }
+    w.close();
+    std::cerr << "rows: " << rows << " anchors: " << map.size() << " " << clock_domain_name(from)
+              << " -> " << clock_domain_name(to) << "\n";
+    return w.ok() ? 0 : 4;
+}
+
+// ---- 3.12 calibrate ----
+// Least-squares fit ref = gain * rail + offset (fit_gain_offset in
+// dvfs/linfit.hpp) over a log that has both the on-board rail and a reference
+// meter column (type=serial sensor). Emits a --calibration file that log /
+// stream / sensors apply live.
+static int cmd_calibrate(int argc, char** argv) {
+    auto in = get_flag(argc, argv, "--in");
+    const auto rails = get_flags(argc, argv, "--rail");
+    const auto ref_default = get_flag(argc, argv, "--ref");
+    if (!in || rails.empty()) {
+        std::cerr << "calibrate needs --in <csv> and --rail <col>[=<ref col>] (default ref: --ref)\n";
+        return 2;
+    }
+    int max_lag = 0;
+    if (auto l = get_flag(argc, argv, "--max_lag_rows")) max_lag = std::max(0, std::stoi(*l));
+
+    std::ifstream ifs(*in);
+    std::string line;
+    if (!ifs || !std::getline(ifs, line)) {
+        std::cerr << "Failed to open: " << *in << "\n";
+        return 1;
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::vector<std::pair<const char*, const char*>> f;
+    split_csv(line, f);
+    std::vector<std::string> names;
+    for (auto& x : f) names.emplace_back(x.first, x.second);
+    auto col_of = [&](const std::string& n) -> int {
+        auto it = std::find(names.begin(), names.end(), n);
+        return (it == names.end()) ? -1 : (int)(it - names.begin());
+    };
+
+    struct Fit { std::string rail, ref; int rc, fc; std::vector<double> x, y; };
+    std::vector<Fit> fits;
+    for (auto& r : rails) {
+        Fit ft;
+        const auto eq = r.find('=');
+        ft.rail = r.substr(0, eq);
+        ft.ref = (eq != std::string::npos) ? r.substr(eq + 1) : ref_default.value_or("");
+        ft.rc = col_of(ft.rail);
+        ft.fc = col_of(ft.ref);
+        if (ft.rc < 0 || ft.fc < 0) {
+            std::cerr << "No column '" << (ft.rc < 0 ? ft.rail : ft.ref) << "' in " << *in << "\n";
+            return 2;
+        }
+        fits.push_back(std::move(ft));
+    }
+    while (std::getline(ifs, line)) {
+        split_csv(line, f);
+        for (auto& ft : fits) {
+            const bool ok = (size_t)std::max(ft.rc, ft.fc) < f.size();
+            ft.x.push_back(ok ? parse_num(f[ft.rc].first, f[ft.rc].second) : std::nan(""));
+            ft.y.push_back(ok ? parse_num(f[ft.fc].first, f[ft.fc].second) : std::nan(""));
+        }
+    }
+
+    std::string out;
+    char buf[256];
+    for (auto& ft : fits) {
+        GainFit g;
+        std::string err;
+        if (!fit_gain_offset(ft.x, ft.y, max_lag, g, err)) {
+            std::cerr << ft.rail << ": " << err << " against " << ft.ref << " (n=" << g.n << ")\n";
+            return 3;
+        }
+        std::snprintf(buf, sizeof(buf), "name=%s gain=%.6f offset=%.3f ref=%s n=%zu lag_rows=%d r2=%.5f\n",
+                      ft.rail.c_str(), g.gain, g.offset, ft.ref.c_str(), g.n, g.lag, g.r2);
+        out += buf;
+        std::cerr << ft.rail << " vs " << ft.ref << ": rms error " << g.rms_raw << " -> " << g.rms_fit
+                  << " (n=" << g.n << ", lag " << g.lag << " rows)\n";
+    }
+
+    if (auto o = get_flag(argc, argv, "--out")) {
+        std::ofstream ofs(*o);
+        if (!ofs) {
+            std::cerr << "Failed to open: " << *o << "\n";
+            return 1;
+        }
+        ofs << out;
+    } else {
+        std::cout << out;
+    }
+    return 0;
+}
+
+// ---- 3.13 fakemeter ----
+// Reference-meter stand-in on a new pty (prints the slave path): emits the
+// meter line protocol, following a file (gain/offset/noise applied) or a
+// fixed value, for exercising type=serial sensors and calibrate without a
+// bench meter.
+static int cmd_fakemeter(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+
+    int period_ms = 20;
+    if (auto p = get_flag(argc, argv, "--period_ms")) period_ms = std::max(1, std::stoi(*p));
+    const auto follow = get_flag(argc, argv, "--follow");
+    double value = 5000, gain = 1, offset = 0, noise = 0;
+    if (auto v = get_flag(argc, argv, "--value_mw")) value = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--gain")) gain = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--offset_mw")) offset = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--noise_mw")) noise = std::stod(*v);
+    const bool watts = get_flag(argc, argv, "--unit").value_or("W") != "mW";
+
+    std::string slave, err;
+    const int fd = open_pty(slave, err);
+    if (fd < 0) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    // Nobody may be reading yet; drop lines rather than block on a full pty.
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    std::cout << slave << std::endl;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(-noise, noise);
+    auto next = std::chrono::steady_clock::now();
+    char buf[64];
+    while (!g_stop) {
+        next += std::chrono::milliseconds(period_ms);
+        double mw = value;
+        if (follow) {
+            auto t = read_text(*follow);
+            mw = t ? parse_num(t->data(), t->data() + t->size()) : std::nan("");
+        }
+        if (!std::isnan(mw)) {
+            mw = mw * gain + offset + (noise > 0 ? jitter(rng) : 0.0);
+            const int n = watts ? std::snprintf(buf, sizeof(buf), "%.4f W\n", mw / 1000.0)
+                                : std::snprintf(buf, sizeof(buf), "%.1f mW\n", mw);
+            if (::write(fd, buf, (size_t)n) < 0 && errno != EAGAIN && errno != EIO) break;
+        }
+        std::this_thread::sleep_until(next);
+    }
+    ::close(fd);
+    return 0;
+}
+
+// ---- 3.14 daemon ----
+// Owns the CPU/GPU limits and arbitrates client requests (dvfs/qos.hpp,
+// dvfs/daemon.hpp). Dry-run unless --apply, like set/unlock.
+static int cmd_daemon(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    const bool apply = has_flag(argc, argv, "--apply");
+    const std::string sock = get_flag(argc, argv, "--socket").value_or(kDaemonSocket);
+
+    // --cpu_dir/--gpu_dir point at other (e.g. fake) cpufreq/devfreq dirs.
+    std::optional<Controller> ctl;
+    auto cpu_dir = get_flag(argc, argv, "--cpu_dir"), gpu_dir = get_flag(argc, argv, "--gpu_dir");
+    if (cpu_dir && gpu_dir) ctl.emplace(*cpu_dir, *gpu_dir);
+    else ctl = Controller::discover();
+    if (!ctl) {
+        std::cerr << "Failed to discover cpu/gpu sysfs dirs. Run: dvfs_tool probe\n";
+        return 3;
+    }
+
+    QosArbiter arb;
+    auto cpu_opps = ctl->cpu_opps_khz(), gpu_opps = ctl->gpu_opps_hz();
+    arb.set_limits(QosDomain::Cpu,
+                   cpu_opps.empty() ? read_ll(ctl->cpu_dir() + "/cpuinfo_min_freq").value_or(0) : cpu_opps.front(),
+                   cpu_opps.empty() ? read_ll(ctl->cpu_dir() + "/cpuinfo_max_freq").value_or(0) : cpu_opps.back(),
+                   cpu_opps);
+    arb.set_limits(QosDomain::Gpu,
+                   gpu_opps.empty() ? read_ll(ctl->gpu_dir() + "/min_freq").value_or(0) : gpu_opps.front(),
+                   gpu_opps.empty() ? read_ll(ctl->gpu_dir() + "/max_freq").value_or(0) : gpu_opps.back(),
+                   gpu_opps);
+    for (QosDomain d : {QosDomain::Cpu, QosDomain::Gpu}) {
+        if (arb.limits(d).max <= 0) {
+            std::cerr << "No " << qos_domain_name(d) << " frequency range under "
+                      << (d == QosDomain::Cpu ? ctl->cpu_dir() : ctl->gpu_dir()) << "\n";
+            return 3;
+        }
+    }
+
+    // Latency holds (dvfs/latency.hpp); --rail prices each window.
+    const std::string cpu_root = get_flag(argc, argv, "--cpu_root").value_or(kCpuRoot);
+    LatencyQos lat(cpu_root, get_flag(argc, argv, "--dma_dev").value_or(kDmaLatencyDev));
+    lat.set_dry_run(!apply);
+    PhaseMeter meter(cpu_root);
+    if (auto p = get_flag(argc, argv, "--phase_log"); p && !meter.open(*p)) {
+        std::cerr << "Failed to open: " << *p << "\n";
+        return 1;
+    }
+    std::unique_ptr<PowerReader> pr;
+    if (auto rail = get_flag(argc, argv, "--rail")) {
+        pr = std::make_unique<PowerReader>(std::vector<std::string>{*rail});
+        if (!pr->start(200)) {
+            std::cerr << "Failed to start tegrastats\n";
+            return 3;
+        }
+    }
+
+    QosServer srv(arb);
+    srv.set_latency(&lat, &meter);
+    std::string err;
+    if (!srv.listen(sock, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    if (auto t = get_flag(argc, argv, "--trace"); t && !srv.open_trace(*t)) {
+        std::cerr << "Failed to open: " << *t << "\n";
+        return 1;
+    }
+    srv.on_event = [](const std::string& m) { std::cout << m << std::endl; };
+    srv.on_apply = [&](QosDomain d, const QosRange& r) {
+        if (!apply) return true;
+        return d == QosDomain::Cpu ? ctl->set_cpu_range_khz(r.min, r.max) : ctl->set_gpu_range_hz(r.min, r.max);
+    };
+    std::cout << "Listening on " << sock << (apply ? "" : " (dry-run: no sysfs writes, add --apply)") << "\n"
+              << "cpu " << arb.limits(QosDomain::Cpu).min << ":" << arb.limits(QosDomain::Cpu).max << " kHz, gpu "
+              << arb.limits(QosDomain::Gpu).min << ":" << arb.limits(QosDomain::Gpu).max << " Hz" << std::endl;
+    srv.apply_all();
+
+    // Per-application profiles (dvfs/profiles.hpp), applied on exec.
+    std::vector<Profile> profiles;
+    if (auto p = get_flag(argc, argv, "--profiles")) {
+        auto text = read_file(*p);
+        if (!text) {
+            std::cerr << "Failed to open: " << *p << "\n";
+            return 1;
+        }
+        if (!parse_profiles(*text, *p, profiles, err)) {
+            std::cerr << err << "\n";
+            return 2;
+        }
+    }
+    ProfileAgent agent(srv, std::move(profiles));
+    agent.set_dry_run(!apply);
+    agent.on_event = srv.on_event;
+    if (auto p = get_flag(argc, argv, "--profile_log"); p && !agent.open_log(*p)) {
+        std::cerr << "Failed to open: " << *p << "\n";
+        return 1;
+    }
+    if (has_flag(argc, argv, "--profiles") && !agent.start(err)) {
+        std::cerr << err << "\n";
+        return 3;
+    }
+
+    while (!g_stop) {
+        srv.poll(200);
+        const long long mw = pr ? pr->mw(0) : -1;
+        meter.tick(now_ns(), mw >= 0 ? (double)mw : std::nan(""), lat.held());
+    }
+    agent.stop();
+    srv.close();
+    lat.release_all();
+    return 0;
+}
+
+// ---- 3.15 qos ----
+// Hold a request on the daemon until Ctrl+C (or --hold_s), or print status.
+static int cmd_qos(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    const std::string sock = get_flag(argc, argv, "--socket").value_or(kDaemonSocket);
+    QosClient cli;
+    std::string err, reply;
+    if (!cli.connect(sock, get_flag(argc, argv, "--client").value_or(""), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    if (has_flag(argc, argv, "--status")) {
+        std::vector<std::string> lines;
+        if (!cli.call("status", reply, err, &lines)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        for (auto& l : lines) std::cout << l << "\n";
+        std::cout << "effective " << reply << "\n";
+        return 0;
+    }
+
+    const std::string prio = get_flag(argc, argv, "--priority").value_or("0");
+    const struct { const char* dom; const char* min; const char* max; } doms[] = {
+        {"cpu", "--cpu_min_khz", "--cpu_max_khz"}, {"gpu", "--gpu_min_hz", "--gpu_max_hz"}};
+    bool any = false;
+    for (auto& d : doms) {
+        auto mn = get_flag(argc, argv, d.min), mx = get_flag(argc, argv, d.max);
+        if (!mn && !mx) continue;
+        std::string cmd = std::string("set ") + d.dom + " prio=" + prio;
+        if (mn) cmd += " min=" + *mn;
+        if (mx) cmd += " max=" + *mx;
+        if (!cli.call(cmd, reply, err)) {
+            std::cerr << err << "\n";
+            return 2;
+        }
+        any = true;
+    }
+    if (auto us = get_flag(argc, argv, "--latency_us")) {
+        std::string cmd = "latency " + *us;
+        if (auto c = get_flag(argc, argv, "--cpus")) cmd += " cpus=" + *c;
+        if (auto l = get_flag(argc, argv, "--label")) cmd += " label=" + *l;
+        if (!cli.call(cmd, reply, err)) {
+            std::cerr << err << "\n";
+            return 2;
+        }
+        reply.clear();
+        cli.call("get", reply, err);
+        any = true;
+    }
+    if (!any) {
+        std::cerr << "qos needs --status, --latency_us or one of --cpu_min_khz/--cpu_max_khz/--gpu_min_hz/--gpu_max_hz\n";
+        return 2;
+    }
+    std::cout << "Holding; effective " << reply << std::endl;
+    double hold_s = 0;  // 0 = until Ctrl+C
+    if (auto h = get_flag(argc, argv, "--hold_s")) hold_s = std::stod(*h);
+    const int64_t end = now_ns() + (int64_t)(hold_s * 1e9);
+    while (!g_stop && (hold_s <= 0 || now_ns() < end)) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return 0;
+}
+
+// ---- 3.16 cap ----
+// Power capper client: keeps --rail under --cap_mw through cap requests on
+// the daemon (a cap bounds every other client's range). With --tenant the
+// budget is first shared between cgroups by weight (dvfs/budget.hpp); the
+// OPP ceilings stay as the backstop.
+static int cmd_cap(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    auto cap = get_flag(argc, argv, "--cap_mw");
+    if (!cap) {
+        std::cerr << "cap needs --cap_mw <mW>\n";
+        return 2;
+    }
+    int period_ms = 500;
+    if (auto p = get_flag(argc, argv, "--period_ms")) period_ms = std::stoi(*p);
+    if (period_ms <= 0) period_ms = 500;
+    const std::string rail = get_flag(argc, argv, "--rail").value_or("VDD_IN");
+    const std::string sock = get_flag(argc, argv, "--socket").value_or(kDaemonSocket);
+
+    QosClient cli;
+    std::string err, reply;
+    if (!cli.connect(sock, get_flag(argc, argv, "--client").value_or("capper"), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::vector<long long> opps[kQosDomains];
+    for (int d = 0; d < kQosDomains; ++d) {
+        if (!cli.call(std::string("opps ") + qos_domain_name((QosDomain)d), reply, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        std::istringstream is(reply);
+        for (long long v; is >> v;) opps[d].push_back(v);
+    }
+    PowerCapper capper(opps[0], opps[1], std::stod(*cap));
+
+    // CPU pressure steers which domain moves (see dvfs/capper.hpp).
+    PsiRate psi;
+    const std::string psi_file = psi_path(get_flag(argc, argv, "--psi").value_or("cpu"));
+    if (!has_flag(argc, argv, "--no_psi") && !psi.open(psi_file))
+        std::cerr << "No CPU pressure (" << psi_file << "); capping by OPP level only\n";
+    capper.set_pressure_band(std::stod(get_flag(argc, argv, "--psi_low").value_or("5")),
+                             std::stod(get_flag(argc, argv, "--psi_high").value_or("20")));
+    BufWriter lw(4096);
+    const auto clog = get_flag(argc, argv, "--log");
+    if (clog) {
+        if (!lw.open(*clog)) {
+            std::cerr << "Failed to open: " << *clog << "\n";
+            return 1;
+        }
+        lw.append(std::string("ts_ns,mw,filtered_mw,cpu_some_pct,cpu_full_pct,cpu_max_khz,gpu_max_hz,action\n"));
+    }
+    if (psi.is_open()) {
+        double some, full;
+        psi.read(now_ns(), some, full);
+    }
+
+    PowerReader pr({rail});
+    if (!pr.start(period_ms)) {
+        std::cerr << "Failed to start tegrastats\n";
+        return 3;
+    }
+    std::vector<Tenant> tenants;
+    for (auto& t : get_flags(argc, argv, "--tenant")) {
+        Tenant x;
+        if (!parse_tenant(t, x)) {
+            std::cerr << "Bad --tenant " << t << " (<cgroup dir>[:<weight>])\n";
+            return 2;
+        }
+        tenants.push_back(x);
+    }
+    const std::string enf = get_flag(argc, argv, "--enforce").value_or("cpu.max");
+    if (enf != "cpu.max" && enf != "uclamp") {
+        std::cerr << "Bad --enforce " << enf << " (cpu.max or uclamp)\n";
+        return 2;
+    }
+    const double idle_mw = std::stod(get_flag(argc, argv, "--idle_mw").value_or("0"));
+    BudgetSharer sharer(tenants, enf == "uclamp" ? BudgetEnforce::Uclamp : BudgetEnforce::CpuMax);
+    if (!tenants.empty() && !sharer.start(err)) {
+        std::cerr << err << "\n";
+        return 4;
+    }
+    BufWriter tw(4096);
+    const auto tlog = get_flag(argc, argv, "--tenant_log");
+    if (tlog) {
+        if (!tw.open(*tlog)) {
+            std::cerr << "Failed to open: " << *tlog << "\n";
+            return 1;
+        }
+        tw.append(std::string("ts_ns,cgroup,weight,usage_pct,attr_mw,alloc_mw,level,energy_mj\n"));
+    }
+
+    std::cout << "Capping " << rail << " at " << capper.cap_mw() << " mW via " << sock;
+    if (!tenants.empty()) std::cout << ", " << tenants.size() << " tenants by " << enf;
+    std::cout << std::endl;
+    auto next = std::chrono::steady_clock::now();
+    long long sent[kQosDomains] = {};
+    int rc = 0;
+    while (!g_stop) {
+        next += std::chrono::milliseconds(period_ms);
+        std::this_thread::sleep_until(next);
+        const long long mw = pr.mw(0);
+        const int64_t ts_ns = now_ns();
+        double some = std::nan(""), full = std::nan("");
+        if (psi.is_open()) psi.read(ts_ns, some, full);
+        std::string note;
+        if (mw < 0) continue;
+        capper.set_cpu_pressure(some);
+        const bool moved = capper.step((double)mw, note);
+        if (clog) {
+            std::string line = std::to_string(ts_ns) + "," + std::to_string(mw) + ",";
+            for (double v : {capper.filtered_mw(), some, full}) {
+                append_num(line, std::round(v * 100.0) / 100.0);
+                line.push_back(',');
+            }
+            line += std::to_string(capper.cpu_max()) + "," + std::to_string(capper.gpu_max()) + ",";
+            line += moved ? note.substr(0, note.find(':')) : "";
+            line.push_back('\n');
+            lw.append(line);
+            lw.flush();
+        }
+        if (!tenants.empty()) {
+            sharer.step(capper.filtered_mw(), idle_mw, capper.cap_mw());
+            const std::string ts = std::to_string(ts_ns);
+            for (size_t i = 0; tlog && i < tenants.size(); ++i) {
+                const auto& st = sharer.state()[i];
+                std::string line = ts + "," + tenants[i].cgroup + ",";
+                for (double v : {tenants[i].weight, st.usage_pct, st.attr_mw, st.alloc_mw, st.level, st.energy_mj}) {
+                    append_num(line, std::round(v * 1000.0) / 1000.0);
+                    line.push_back(',');
+                }
+                line.back() = '\n';
+                tw.append(line);
+            }
+            if (tlog) tw.flush();
+        }
+        if (!moved) continue;
+        std::cout << note << std::endl;
+        const long long ceil[kQosDomains] = {capper.cpu_max(), capper.gpu_max()};
+        for (int d = 0; d < kQosDomains; ++d) {
+            if (ceil[d] <= 0 || ceil[d] == sent[d]) continue;
+            sent[d] = ceil[d];
+            if (!cli.call(std::string("set ") + qos_domain_name((QosDomain)d) + " cap=1 max=" + std::to_string(ceil[d]),
+                          reply, err)) {
+                std::cerr << err << "\n";
+                rc = 4;
+                g_stop = 1;
+                break;
+            }
+        }
+    }
+    pr.stop();
+    if (!tenants.empty()) {
+        sharer.restore();
+        for (size_t i = 0; i < tenants.size(); ++i) {
+            std::printf("%s: weight %g, %.1f J attributed\n", tenants[i].cgroup.c_str(), tenants[i].weight,
+                        sharer.state()[i].energy_mj / 1e3);
+        }
+    }
+    return rc;
+}
+
+// ---- 3.17 uclamp ----
+// Clamp a process (all threads, sched_setattr) or a cgroup (cpu.uclamp.*)
+// and hold it until Ctrl+C / --hold_s, then restore; --keep leaves it set.
+static int cmd_uclamp(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    auto pid = get_flag(argc, argv, "--pid");
+    auto cg = get_flag(argc, argv, "--cgroup");
+    if (!pid == !cg) {
+        std::cerr << "uclamp needs one of --pid <pid> / --cgroup <dir>\n";
+        return 2;
+    }
+    std::string err;
+    if (pid && has_flag(argc, argv, "--show")) {
+        for (int tid : process_threads(std::stoi(*pid))) {
+            Uclamp u;
+            if (!get_task_uclamp(tid, u, err)) {
+                std::cerr << err << "\n";
+                return 1;
+            }
+            std::cout << tid << " util_min=" << u.min << " util_max=" << u.max << "\n";
+        }
+        return 0;
+    }
+    Uclamp u;
+    for (auto [flag, dst] : {std::pair<const char*, int*>{"--min", &u.min}, {"--max", &u.max}}) {
+        auto v = get_flag(argc, argv, flag);
+        if (v && !parse_uclamp_value(*v, *dst)) {
+            std::cerr << "Bad " << flag << " " << *v << " (0.." << kUclampScale << " or 0..100%)\n";
+            return 2;
+        }
+    }
+    if (u.min < 0 && u.max < 0) {
+        std::cerr << "uclamp needs --min and/or --max\n";
+        return 2;
+    }
+    if (u.min >= 0 && u.max >= 0 && u.min > u.max) {
+        std::cerr << "--min above --max\n";
+        return 2;
+    }
+
+    UclampActuator act;
+    const bool ok = pid ? act.clamp_process(std::stoi(*pid), u, err)
+                        : act.clamp_cgroup(*cg, u.min < 0 ? -1 : u.min * 100.0 / kUclampScale,
+                                           u.max < 0 ? -1 : u.max * 100.0 / kUclampScale, err);
+    if (!ok) {
+        std::cerr << err << "\n";
+        return 4;
+    }
+    std::cout << "Clamped " << (pid ? "pid " + *pid : *cg) << " util_min=" << u.min << " util_max=" << u.max
+              << std::endl;
+    if (has_flag(argc, argv, "--keep")) return 0;
+    double hold_s = 0;  // 0 = until Ctrl+C
+    if (auto h = get_flag(argc, argv, "--hold_s")) hold_s = std::stod(*h);
+    const int64_t end = now_ns() + (int64_t)(hold_s * 1e9);
+    while (!g_stop && (hold_s <= 0 || now_ns() < end)) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    act.restore();
+    std::cout << "Restored.\n";
+    return 0;
+}
+
+// ---- 3.18 report ----
+// Compare runs (log CSV + optional <csv>.markers): energy and mean power,
+// and per span name (markers "<name>:begin"/"<name>:end") latency and
+// energy, each against the first run.
+static int cmd_report(int argc, char** argv) {
+    const auto runs = get_flags(argc, argv, "--run");
+    if (runs.empty()) {
+        std::cerr << "report needs --run [<label>=]<csv> (repeatable)\n";
+        return 2;
+    }
+    const std::string pcol = get_flag(argc, argv, "--power").value_or("vdd_in_mW");
+
+    struct SpanStats {
+        std::vector<double> ms;
+        double mj = 0.0;
+    };
+    struct Run {
+        std::string label;
+        double dur_s = 0, energy_j = 0;
+        std::map<std::string, SpanStats> spans;
+    };
+    std::vector<Run> res;
+    for (const auto& r : runs) {
+        const auto eq = r.find('=');
+        const std::string path = eq == std::string::npos ? r : r.substr(eq + 1);
+        Run run;
+        run.label = eq == std::string::npos ? std::filesystem::path(path).stem().string() : r.substr(0, eq);
+        Frame fr;
+        std::string err;
+        if (!fr.load(path, err)) {
+            std::cerr << "report: " << err << "\n";
+            return 1;
+        }
+        const FrameCol* tsc = fr.col("ts_ns");
+        const FrameCol* pc = fr.col(pcol);
+        if (!tsc || !pc) {
+            std::cerr << "report: " << path << " has no ts_ns / " << pcol << " column (--power)\n";
+            return 2;
+        }
+        std::vector<int64_t> ts(fr.rows());
+        std::vector<double> mw(fr.rows());
+        for (size_t i = 0; i < fr.rows(); ++i) {
+            ts[i] = (int64_t)tsc->get(i);
+            mw[i] = pc->get(i);
+        }
+        if (ts.size() >= 2) {
+            run.dur_s = (double)(ts.back() - ts.front()) * 1e-9;
+            run.energy_j = energy_mj(ts, mw, ts.front(), ts.back()) / 1e3;
+        }
+        std::vector<Marker> ms;
+        if (exists(path + ".markers") && load_markers(path + ".markers", ms, err)) {
+            for (auto& sp : marker_spans(ms)) {
+                auto& st = run.spans[sp.name];
+                st.ms.push_back((double)(sp.t1 - sp.t0) * 1e-6);
+                st.mj += energy_mj(ts, mw, sp.t0, sp.t1);
+            }
+        }
+        res.push_back(std::move(run));
+    }
+
+    auto pct = [](double v, double base) {
+        char b[24];
+        if (!(base > 0) || std::isnan(v)) return std::string("");
+        std::snprintf(b, sizeof(b), "%+.1f%%", (v / base - 1.0) * 100.0);
+        return std::string(b);
+    };
+    auto quant = [](std::vector<double> v, double q) {
+        std::sort(v.begin(), v.end());
+        return v.empty() ? std::nan("") : v[std::min(v.size() - 1, (size_t)(q * (double)v.size()))];
+    };
+    std::printf("%-16s %9s %10s %9s %9s\n", "run", "dur_s", "energy_J", "mean_mW", "vs_first");
+    for (auto& r : res) {
+        const double mean = r.dur_s > 0 ? r.energy_j * 1e3 / r.dur_s : std::nan("");
+        std::printf("%-16s %9.2f %10.3f %9.0f %9s\n", r.label.c_str(), r.dur_s, r.energy_j, mean,
+                    &r == &res.front() ? "" : pct(r.energy_j, res.front().energy_j).c_str());
+    }
+    std::set<std::string> names;
+    for (auto& r : res) for (auto& [n, st] : r.spans) names.insert(n);
+    for (auto& n : names) {
+        std::printf("\nspan %s\n%-16s %7s %9s %9s %9s %10s %9s %9s\n", n.c_str(), "run", "n", "mean_ms", "p50_ms",
+                    "p99_ms", "mJ/span", "d_p99", "d_mJ");
+        const SpanStats* base = nullptr;
+        for (auto& r : res) {
+            auto it = r.spans.find(n);
+            if (it == r.spans.end()) continue;
+            const auto& st = it->second;
+            double sum = 0;
+            for (double v : st.ms) sum += v;
+            const double per = st.mj / (double)st.ms.size();
+            const double p99 = quant(st.ms, 0.99);
+            std::printf("%-16s %7zu %9.2f %9.2f %9.2f %10.2f %9s %9s\n", r.label.c_str(), st.ms.size(),
+                        sum / (double)st.ms.size(), quant(st.ms, 0.5), p99, per,
+                        base ? pct(p99, quant(base->ms, 0.99)).c_str() : "",
+                        base ? pct(per, base->mj / (double)base->ms.size()).c_str() : "");
+            if (!base) base = &st;
+        }
+    }
+    return 0;
+}
+
+// ---- 3.19 edp ----
+// EDP minimizer client (dvfs/edp.hpp): measures energy and progress per
+// window and pins the CPU/GPU point the climber picks through the daemon.
+static int cmd_edp(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    auto fifo = get_flag(argc, argv, "--heartbeat_fifo");
+    auto perf = get_flag(argc, argv, "--perf");
+    if (!fifo == !perf) {
+        std::cerr << "edp needs one progress source: --heartbeat_fifo <path> or --perf instructions\n";
+        return 2;
+    }
+    EdpParams prm;
+    if (auto m = get_flag(argc, argv, "--metric"); m && !parse_edp_metric(*m, prm.exponent)) {
+        std::cerr << "Bad --metric: " << *m << " (edp or ed2p)\n";
+        return 2;
+    }
+    if (auto v = get_flag(argc, argv, "--margin")) prm.margin = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--phase")) prm.phase = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--settle")) prm.settle = std::stoi(*v);
+    int window_ms = 1000, period_ms = 100;
+    if (auto v = get_flag(argc, argv, "--window_ms")) window_ms = std::stoi(*v);
+    if (auto v = get_flag(argc, argv, "--period_ms")) period_ms = std::stoi(*v);
+    if (period_ms <= 0 || window_ms < period_ms) {
+        std::cerr << "Need 0 < --period_ms <= --window_ms\n";
+        return 2;
+    }
+    const std::string sock = get_flag(argc, argv, "--socket").value_or(kDaemonSocket);
+    const std::string prio = get_flag(argc, argv, "--priority").value_or("0");
+
+    QosClient cli;
+    std::string err, reply;
+    if (!cli.connect(sock, get_flag(argc, argv, "--client").value_or("edp"), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::vector<long long> opps[kQosDomains];
+    for (int d = 0; d < kQosDomains; ++d) {
+        if (!cli.call(std::string("opps ") + qos_domain_name((QosDomain)d), reply, err)) {
+            std::cerr << err << "\n";
+            return 1;
+        }
+        std::istringstream is(reply);
+        for (long long v; is >> v;) opps[d].push_back(v);
+    }
+    // --cpu_only / --gpu_only keep the other domain out of the search.
+    if (has_flag(argc, argv, "--cpu_only")) opps[1].clear();
+    if (has_flag(argc, argv, "--gpu_only")) opps[0].clear();
+    EdpClimber climber(opps[0], opps[1], prm);
+
+    // Power (tegrastats rail) and, with --perf, a system-wide counter.
+    std::vector<SensorSpec> specs(1);
+    specs[0].name = "mw";
+    specs[0].type = SensorType::Tegrastats;
+    specs[0].path = get_flag(argc, argv, "--rail").value_or("VDD_IN");
+    if (perf) {
+        specs.emplace_back();
+        specs[1].name = "work";
+        specs[1].type = SensorType::Perf;
+        specs[1].path = *perf;
+    }
+    Sampler smp;
+    if (!smp.init(specs, {}, {}, period_ms, err)) {
+        std::cerr << err << "\n";
+        return 3;
+    }
+    if (perf && smp.sensors()[1].source.empty()) {
+        std::cerr << "perf event '" << *perf << "' unavailable (perf_event_paranoid / PMU access?)\n";
+        return 3;
+    }
+    MarkerFifo hb;
+    if (fifo && !hb.start(*fifo, get_flag(argc, argv, "--heartbeat_out").value_or("/dev/null"), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    BufWriter w(4096);
+    const auto log_path = get_flag(argc, argv, "--log");
+    if (log_path) {
+        if (!w.open(*log_path)) {
+            std::cerr << "Failed to open: " << *log_path << "\n";
+            return 1;
+        }
+        w.append(std::string("ts_ns,cpu_khz,gpu_hz,state,window_s,mean_mw,work,cost,note\n"));
+    }
+
+    // eff: the clocks the daemon's effective range (caps, higher-priority
+    // clients) leaves of the climber's point; set = false only checks.
+    auto pin = [&](bool set, long long (&eff)[kQosDomains], bool& clipped) {
+        const long long v[kQosDomains] = {climber.cpu_khz(), climber.gpu_hz()};
+        clipped = false;
+        for (int d = 0; d < kQosDomains; ++d) {
+            if (v[d] <= 0) continue;
+            if (!cli.call(set ? std::string("set ") + qos_domain_name((QosDomain)d) + " min=" + std::to_string(v[d]) +
+                                    " max=" + std::to_string(v[d]) + " prio=" + prio
+                              : std::string("get"),
+                          reply, err)) {
+                std::cerr << err << "\n";
+                return false;
+            }
+            QosRange r;
+            eff[d] = parse_qos_reply(reply, (QosDomain)d, r) ? qos_in_force(v[d], r) : v[d];
+            clipped |= eff[d] != v[d];
+        }
+        return true;
+    };
+    // Pin, moving off points the daemon clips until one holds.
+    auto pin_reachable = [&]() {
+        for (;;) {
+            long long eff[kQosDomains] = {0, 0};
+            bool clipped = false;
+            if (!pin(true, eff, clipped)) return false;
+            std::string note;
+            if (!clipped || !climber.clipped(eff[0], eff[1], note)) return true;
+            std::cout << note << std::endl;
+        }
+    };
+    if (!pin_reachable()) return 4;
+    std::cout << "Minimizing " << (prm.exponent == 1 ? "EDP" : "ED2P") << " over " << opps[0].size() << "x"
+              << opps[1].size() << " OPPs, progress from " << (fifo ? "heartbeats" : *perf) << ", " << window_ms
+              << " ms windows" << std::endl;
+
+    Sample s;
+    smp.prepare(s);
+    double mj = 0.0, work = 0.0;
+    uint64_t hb0 = hb.count();
+    int64_t t0 = now_ns(), last = t0;
+    auto next = std::chrono::steady_clock::now();
+    int rc = 0;
+    while (!g_stop) {
+        next += std::chrono::milliseconds(period_ms);
+        std::this_thread::sleep_until(next);
+        smp.sample(s);
+        const int64_t now = now_ns();
+        if (!std::isnan(s.num[0])) mj += s.num[0] * (double)(now - last) * 1e-9;
+        if (perf && !std::isnan(s.num[1])) work += s.num[1];
+        last = now;
+        if (now - t0 < (int64_t)window_ms * 1000000) continue;
+
+        const double win_s = (double)(now - t0) * 1e-9;
+        if (fifo) work = (double)(hb.count() - hb0);
+        std::string note;
+        const long long ck = climber.cpu_khz(), gh = climber.gpu_hz();
+        // A range change by another client since the pin: this window ran
+        // somewhere else, so it is not charged to the point.
+        long long eff[kQosDomains] = {0, 0};
+        bool clipped = false;
+        if (!pin(false, eff, clipped)) {
+            rc = 4;
+            break;
+        }
+        const std::string state = clipped ? "clipped" : climber.state();
+        const bool moved = clipped ? climber.clipped(eff[0], eff[1], note) : climber.step(mj, win_s, work, note);
+        if (log_path) {
+            std::string line = std::to_string(now) + "," + std::to_string(ck) + "," + std::to_string(gh) + "," + state + ",";
+            append_num(line, std::round(win_s * 1e3) / 1e3);
+            line.push_back(',');
+            append_num(line, std::round(mj / win_s * 10.0) / 10.0);
+            line.push_back(',');
+            append_num(line, work);
+            line.push_back(',');
+            append_num(line, climber.last_cost());
+            std::replace(note.begin(), note.end(), ',', ';');
+            line += "," + note + "\n";
+            w.append(line);
+            w.flush();
+        }
+        if (moved) {
+            std::cout << note << std::endl;
+            if (!pin_reachable()) {
+                rc = 4;
+                break;
+            }
+        }
+        mj = work = 0.0;
+        hb0 = hb.count();
+        t0 = now;
+    }
+    hb.stop();
+    return rc;
+}
+
+// ---- 3.20 pacing ----
+// Race-to-idle vs pacing (dvfs/pacing.hpp) for a periodic span in a log
+// with markers: busy time / power per span, idle power between spans.
+static int cmd_pacing(int argc, char** argv) {
+    auto in = get_flag(argc, argv, "--in");
+    if (!in) {
+        std::cerr << "pacing needs --in <csv> (with <csv>.markers)\n";
+        return 2;
+    }
+    const std::string pcol = get_flag(argc, argv, "--power").value_or("vdd_in_mW");
+    const std::string fcol = get_flag(argc, argv, "--freq").value_or("cpu_khz");
+    const std::string mpath = get_flag(argc, argv, "--markers").value_or(*in + ".markers");
+
+    Frame fr;
+    std::string err;
+    std::vector<Marker> ms;
+    if (!fr.load(*in, err) || !load_markers(mpath, ms, err)) {
+        std::cerr << "pacing: " << err << "\n";
+        return 1;
+    }
+    const FrameCol* tsc = fr.col("ts_ns");
+    const FrameCol* pc = fr.col(pcol);
+    const FrameCol* fc = fr.col(fcol);
+    if (!tsc || !pc || !fc) {
+        std::cerr << "pacing: " << *in << " needs ts_ns, " << pcol << " (--power) and " << fcol << " (--freq)\n";
+        return 2;
+    }
+    std::vector<int64_t> ts(fr.rows());
+    std::vector<double> mw(fr.rows()), khz(fr.rows());
+    for (size_t i = 0; i < fr.rows(); ++i) {
+        ts[i] = (int64_t)tsc->get(i);
+        mw[i] = pc->get(i);
+        khz[i] = fc->get(i);
+    }
+
+    // The periodic span: --span, else the most frequent one.
+    auto spans = marker_spans(ms);
+    std::string name = get_flag(argc, argv, "--span").value_or("");
+    if (name.empty()) {
+        std::map<std::string, size_t> n;
+        for (auto& sp : spans) n[sp.name]++;
+        for (auto& [k, v] : n) if (name.empty() || v > n[name]) name = k;
+    }
+    spans.erase(std::remove_if(spans.begin(), spans.end(), [&](const Span& sp) { return sp.name != name; }),
+                spans.end());
+    if (spans.empty()) {
+        std::cerr << "pacing: no complete '" << (name.empty() ? "<name>" : name) << ":begin/end' spans in " << mpath
+                  << "\n";
+        return 2;
+    }
+
+    PacingInput pin;
+    double busy_mj = 0, busy_s = 0;
+    for (auto& sp : spans) {
+        PacingObs o;
+        o.busy_s = (double)(sp.t1 - sp.t0) * 1e-9;
+        if (!(o.busy_s > 0)) continue;
+        o.active_mw = energy_mj(ts, mw, sp.t0, sp.t1) / o.busy_s;
+        // Clock: mean of the samples inside, else the one in force at t0.
+        size_t i = (size_t)(std::upper_bound(ts.begin(), ts.end(), sp.t0) - ts.begin());
+        double f = 0;
+        int n = 0;
+        for (size_t j = i; j < ts.size() && ts[j] <= sp.t1; ++j) {
+            if (!std::isnan(khz[j])) f += khz[j], n++;
+        }
+        if (n == 0 && i > 0 && !std::isnan(khz[i - 1])) f = khz[i - 1], n = 1;
+        if (n == 0) continue;
+        o.khz = f / n;
+        busy_mj += o.active_mw * o.busy_s;
+        busy_s += o.busy_s;
+        pin.obs.push_back(o);
+    }
+    const int64_t t0 = spans.front().t0, t1 = spans.back().t1;
+    const double idle_s = (double)(t1 - t0) * 1e-9 - busy_s;
+    pin.idle_mw = idle_s > 0 ? (energy_mj(ts, mw, t0, t1) - busy_mj) / idle_s : std::nan("");
+    if (auto v = get_flag(argc, argv, "--idle_mw")) pin.idle_mw = std::stod(*v);
+    if (std::isnan(pin.idle_mw)) {
+        std::cerr << "pacing: no time between spans to measure idle power; pass --idle_mw\n";
+        return 2;
+    }
+    if (auto v = get_flag(argc, argv, "--period_ms")) {
+        pin.period_s = std::stod(*v) / 1e3;
+    } else if (spans.size() >= 2) {
+        std::vector<double> d;
+        for (size_t k = 1; k < spans.size(); ++k) d.push_back((double)(spans[k].t0 - spans[k - 1].t0) * 1e-9);
+        std::nth_element(d.begin(), d.begin() + (long)d.size() / 2, d.end());
+        pin.period_s = d[d.size() / 2];
+    }
+    if (auto v = get_flag(argc, argv, "--mem_frac")) pin.mem_frac = std::stod(*v);
+
+    // OPPs and transition cost: flags, else this board's cpufreq / cpuidle.
+    std::optional<Controller> ctl;
+    if (auto d = get_flag(argc, argv, "--cpu_dir")) ctl.emplace(*d, "");
+    else ctl = Controller::discover();
+    if (auto v = get_flag(argc, argv, "--opps")) {
+        for (auto& x : split_top(*v)) pin.opps_khz.push_back(std::stoll(x));
+        std::sort(pin.opps_khz.begin(), pin.opps_khz.end());
+    } else if (ctl) {
+        pin.opps_khz = ctl->cpu_opps_khz();
+    }
+    std::string tr_src = "--transition_us";
+    if (auto v = get_flag(argc, argv, "--transition_us")) {
+        pin.transition_s = std::stod(*v) * 1e-6;
+    } else {
+        // Deepest idle state's exit latency + one cpufreq switch.
+        const std::string root = get_flag(argc, argv, "--cpu_root").value_or(kCpuRoot);
+        int lat = 0;
+        for (auto& st : idle_states(root, online_cpus(root).front())) lat = std::max(lat, st.latency_us);
+        const long long sw_ns = ctl ? read_ll(ctl->cpu_dir() + "/cpuinfo_transition_latency").value_or(0) : 0;
+        pin.transition_s = lat * 1e-6 + (double)sw_ns * 1e-9;
+        tr_src = "cpuidle + cpufreq";
+    }
+
+    PacingResult res;
+    if (!pacing_analysis(pin, res, err)) {
+        std::cerr << "pacing: " << err << "\n";
+        return 2;
+    }
+    std::printf("Span %s: %zu periods of %.2f ms, idle %.0f mW, transition %.0f us (%s)\n", name.c_str(),
+                pin.obs.size(), pin.period_s * 1e3, pin.idle_mw, pin.transition_s * 1e6, tr_src.c_str());
+    std::printf("busy = %.3f + %.4g / f_khz ms;  P = %.0f + %.0f (f/fmax)^3 mW\n\n", res.a_s * 1e3, res.b_s_khz * 1e3,
+                res.p0_mw, res.p3_mw);
+    std::printf("%10s %9s %9s %10s %6s %9s %9s %9s %10s\n", "opp_khz", "busy_ms", "slack_ms", "active_mW", "src",
+                "busy_mJ", "idle_mJ", "trans_mJ", "period_mJ");
+    for (int i = 0; i < (int)res.rows.size(); ++i) {
+        const auto& r = res.rows[i];
+        std::printf("%10lld %9.2f %9.2f %10.0f %6s %9.2f %9.2f %9.2f %10.2f%s\n", r.khz, r.busy_s * 1e3,
+                    (pin.period_s - r.busy_s) * 1e3, r.active_mw, r.measured ? "meas" : "model", r.busy_mj,
+                    r.idle_mj, r.trans_mj, r.total_mj,
+                    !r.feasible ? "  misses period" : i == res.best ? "  <- best" : "");
+    }
+    if (res.best < 0) {
+        std::printf("\nNo OPP fits the period.\n");
+        return 0;
+    }
+    const auto& race = res.rows[res.race];
+    const auto& paced = res.rows[res.paced];
+    const auto& best = res.rows[res.best];
+    std::printf("\nrace-to-idle @ %lld kHz: %.2f mJ/period; paced @ %lld kHz: %.2f mJ/period\n", race.khz,
+                race.total_mj, paced.khz, paced.total_mj);
+    if (res.best == res.race) std::printf("Recommend: race-to-idle (%.1f%% below pacing)\n",
+                                          (1.0 - race.total_mj / paced.total_mj) * 100.0);
+    else if (res.best == res.paced) std::printf("Recommend: pace at %lld kHz (%.1f%% below racing)\n", paced.khz,
+                                                (1.0 - paced.total_mj / race.total_mj) * 100.0);
+    else std::printf("Recommend: run at %lld kHz, then idle (%.1f%% below racing, %.1f%% below pacing)\n", best.khz,
+                     (1.0 - best.total_mj / race.total_mj) * 100.0, (1.0 - best.total_mj / paced.total_mj) * 100.0);
+    return 0;
+}
+
+// ---- 3.21 frames ----
+// Per-frame deadline governor (dvfs/deadline.hpp): frame markers in from a
+// FIFO, one OPP per frame pinned through the daemon, misses and energy per
+// frame out.
+static int cmd_frames(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    std::signal(SIGTERM, on_sigint);
+    auto fifo = get_flag(argc, argv, "--marker_fifo");
+    auto dl = get_flag(argc, argv, "--deadline_ms");
+    if (!fifo || !dl) {
+        std::cerr << "frames needs --marker_fifo <path> and --deadline_ms <ms>\n";
+        return 2;
+    }
+    FrameGovParams prm;
+    prm.deadline_s = std::stod(*dl) / 1e3;
+    if (auto v = get_flag(argc, argv, "--margin")) prm.margin = std::stod(*v);
+    if (auto v = get_flag(argc, argv, "--k_sd")) prm.k_sd = std::stod(*v);
+    if (!(prm.deadline_s > 0) || prm.margin < 0 || prm.margin >= 1) {
+        std::cerr << "Need --deadline_ms > 0 and 0 <= --margin < 1\n";
+        return 2;
+    }
+    QosDomain dom = QosDomain::Cpu;
+    if (auto d = get_flag(argc, argv, "--domain"); d && !parse_qos_domain(*d, dom)) {
+        std::cerr << "Bad --domain: " << *d << " (cpu or gpu)\n";
+        return 2;
+    }
+    const std::string span = get_flag(argc, argv, "--span").value_or("frame");
+    const std::string sock = get_flag(argc, argv, "--socket").value_or(kDaemonSocket);
+    const std::string prio = get_flag(argc, argv, "--priority").value_or("0");
+
+    QosClient cli;
+    std::string err, reply;
+    if (!cli.connect(sock, get_flag(argc, argv, "--client").value_or("frames"), err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    if (!cli.call(std::string("opps ") + qos_domain_name(dom), reply, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    std::vector<long long> opps;
+    std::istringstream is(reply);
+    for (long long v; is >> v;) opps.push_back(v);
+    if (opps.empty()) {
+        std::cerr << "Daemon has no " << qos_domain_name(dom) << " OPP table\n";
+        return 3;
+    }
+    FrameGovernor gov(opps, prm);
+
+    PowerReader pr({get_flag(argc, argv, "--rail").value_or("VDD_IN")});
+    if (!pr.start(50)) {
+        std::cerr << "Failed to start tegrastats\n";
+        return 3;
+    }
+    MarkerFifo mf;
+    if (!mf.start(*fifo, get_flag(argc, argv, "--markers_out").value_or("/dev/null"), err, true)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    BufWriter w(4096);
+    const auto log_path = get_flag(argc, argv, "--log");
+    if (log_path) {
+        if (!w.open(*log_path)) {
+            std::cerr << "Failed to open: " << *log_path << "\n";
+            return 1;
+        }
+        w.append(std::string("frame,begin_ns,end_ns,opp,busy_ms,deadline_ms,miss,energy_mj,next_opp,pred_ms\n"));
+    }
+
+    // pinned = what we asked for; in_force = what the daemon's effective
+    // range (caps, higher priorities) leaves of it. An unchanged pin still
+    // re-reads the range, since other clients move it.
+    long long pinned = 0, in_force = 0;
+    auto pin = [&](long long v) {
+        const bool same = (v == pinned);
+        pinned = v;
+        if (!cli.call(same ? std::string("get")
+                           : std::string("set ") + qos_domain_name(dom) + " min=" + std::to_string(v) +
+                                 " max=" + std::to_string(v) + " prio=" + prio,
+                      reply, err)) {
+            return false;
+        }
+        QosRange r;
+        in_force = parse_qos_reply(reply, dom, r) ? qos_in_force(v, r) : v;
+        return true;
+    };
+    if (!pin(gov.opp())) {
+        std::cerr << err << "\n";
+        return 4;
+    }
+    std::cout << "Frames '" << span << "' with a " << *dl << " ms deadline on " << qos_domain_name(dom) << " ("
+              << opps.size() << " OPPs)" << std::endl;
+
+    struct Done {
+        int64_t t0 = 0, t1 = 0;
+        long long opp = 0, next = 0;
+        double busy_ms = 0, pred_ms = 0;
+        bool miss = false;
+    };
+    std::optional<Done> pending;  // ended, energy counted up to the next begin
+    std::vector<int64_t> pts;
+    std::vector<double> pmw;
+    std::vector<Marker> ms;
+    int64_t begin = -1;
+    long long begin_opp = 0;
+    uint64_t frames = 0, misses = 0;
+    double total_mj = 0;
+    auto finish = [&](const Done& d, int64_t until) {
+        const double mj = energy_mj(pts, pmw, d.t0, until);
+        frames++;
+        misses += d.miss;
+        if (!std::isnan(mj)) total_mj += mj;
+        if (!log_path) return;
+        std::string line = std::to_string(frames) + "," + std::to_string(d.t0) + "," + std::to_string(d.t1) + "," +
+                           std::to_string(d.opp) + ",";
+        append_num(line, std::round(d.busy_ms * 1e3) / 1e3);
+        line += "," + *dl + "," + (d.miss ? "1" : "0") + ",";
+        append_num(line, std::round(mj * 1e3) / 1e3);
+        line += "," + std::to_string(d.next) + ",";
+        append_num(line, std::round(d.pred_ms * 1e3) / 1e3);
+        line.push_back('\n');
+        w.append(line);
+        w.flush();
+    };
+
+    const std::string b_lbl = span + ":begin", e_lbl = span + ":end";
+    int rc = 0;
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        const int64_t now = now_ns();
+        const long long mw = pr.mw(0);
+        pts.push_back(now);
+        pmw.push_back(mw >= 0 ? (double)mw : std::nan(""));
+        ms.clear();
+        mf.take(ms);
+        for (auto& m : ms) {
+            if (m.label == b_lbl) {
+                if (pending) finish(*pending, m.ts_ns);
+                pending.reset();
+                begin = m.ts_ns;
+                begin_opp = in_force;
+            } else if (m.label == e_lbl && begin >= 0) {
+                Done d;
+                d.t0 = begin;
+                d.t1 = m.ts_ns;
+                d.opp = begin_opp;
+                d.busy_ms = (double)(d.t1 - d.t0) * 1e-6;
+                d.miss = d.busy_ms > prm.deadline_s * 1e3;
+                d.next = gov.frame(begin_opp, d.busy_ms * 1e-3);
+                d.pred_ms = gov.predicted_s() * 1e3;
+                if (d.miss) std::cout << "miss: frame " << frames + 1 << " took " << d.busy_ms << " ms at " << d.opp
+                                      << std::endl;
+                if (!pin(d.next)) {
+                    std::cerr << err << "\n";
+                    rc = 4;
+                    g_stop = 1;
+                }
+                pending = d;
+                begin = -1;
+            }
+        }
+        // Keep ~10 s of power history.
+        if (pts.size() > 4000) {
+            pts.erase(pts.begin(), pts.begin() + 2000);
+            pmw.erase(pmw.begin(), pmw.begin() + 2000);
+        }
+    }
+    if (pending) finish(*pending, now_ns());
+    mf.stop();
+    pr.stop();
+    std::printf("%llu frames, %llu misses (%.2f%%), %.2f mJ/frame\n", (unsigned long long)frames,
+                (unsigned long long)misses, frames ? 100.0 * (double)misses / (double)frames : 0.0,
+                frames ? total_mj / (double)frames : 0.0);
+    return rc;
+}
+
+// ---- 3.22 rpm ----
+// Periodic runtime-PM residency of every device: which ones were active
+// during each period, and for how long.
+static int cmd_rpm(int argc, char** argv) {
+    std::signal(SIGINT, on_sigint);
+    const std::string root = get_flag(argc, argv, "--root").value_or("/sys/devices");
+    double period_s = 10.0;
+    if (auto p = get_flag(argc, argv, "--period_s")) period_s = std::stod(*p);
+    long long count = 0;
+    if (auto c = get_flag(argc, argv, "--count")) count = std::stoll(*c);
+    size_t top = 20;
+    if (auto t = get_flag(argc, argv, "--top")) top = (size_t)std::max(1, std::stoi(*t));
+    if (!(period_s > 0)) {
+        std::cerr << "--period_s must be > 0\n";
+        return 2;
+    }
+
+    BufWriter lw(4096);
+    const auto log = get_flag(argc, argv, "--log");
+    if (log) {
+        if (!lw.open(*log)) {
+            std::cerr << "Failed to open: " << *log << "\n";
+            return 1;
+        }
+        lw.append(kRpmCsvHeader, sizeof(kRpmCsvHeader) - 1);
+        lw.flush();
+    }
+
+    RpmScanner rpm;
+    if (rpm.scan(root) == 0) {
+        std::cerr << "No runtime-PM devices under " << root << "\n";
+        return 3;
+    }
+    std::cerr << "rpm: " << rpm.size() << " devices with runtime PM under " << root << "\n";
+
+    std::vector<RpmDelta> d;
+    std::string rows;
+    int64_t last = now_ns();
+    for (long long n = 0; !g_stop && (count <= 0 || n < count); ++n) {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::duration<double>(period_s);
+        while (!g_stop && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const int64_t ts = now_ns();
+        rpm.poll(d);
+        const double interval_ms = (double)(ts - last) / 1e6;
+        last = ts;
+
+        size_t busy = 0;
+        for (auto& r : d) busy += (r.active_ms > 0 || r.status == "active");
+        std::printf("--- %.1f s: %zu of %zu devices active ---\n", interval_ms / 1e3, busy, d.size());
+        std::printf("%-48s %-11s %10s %12s %8s\n", "device", "status", "active_ms", "suspended_ms", "active%");
+        for (size_t i = 0; i < d.size() && i < top; ++i) {
+            const RpmDelta& r = d[i];
+            if (r.active_ms <= 0 && r.status != "active") break;
+            const double tot = r.active_ms + r.suspended_ms;
+            std::printf("%-48s %-11s %10.0f %12.0f %8.1f\n", r.dev.c_str(), r.status.c_str(), r.active_ms,
+                        r.suspended_ms, tot > 0 ? 100.0 * r.active_ms / tot : 0.0);
+        }
+        std::fflush(stdout);
+        if (log) {
+            rows.clear();
+            append_rpm_rows(rows, ts, interval_ms, d);
+            lw.append(rows);
+            lw.flush();
+        }
+    }
     return 0;
 }
 
 // ============================================================
-// 7) main dispatch
+// 4) main dispatch
 // ============================================================
 int main(int argc, char** argv) {
     if (argc < 2 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
@@ -725,6 +2894,24 @@ int main(int argc, char** argv) {
     if (cmd == "set")    return cmd_set(argc, argv);
     if (cmd == "unlock") return cmd_unlock(argc, argv);
     if (cmd == "log")    return cmd_log(argc, argv);
+    if (cmd == "analyze") return cmd_analyze(argc, argv);
+    if (cmd == "sensors") return cmd_sensors(argc, argv);
+    if (cmd == "dump")    return cmd_dump(argc, argv);
+    if (cmd == "bench")   return cmd_bench(argc, argv);
+    if (cmd == "stream")  return cmd_stream(argc, argv);
+    if (cmd == "collect") return cmd_collect(argc, argv);
+    if (cmd == "timeconv") return cmd_timeconv(argc, argv);
+    if (cmd == "calibrate") return cmd_calibrate(argc, argv);
+    if (cmd == "fakemeter") return cmd_fakemeter(argc, argv);
+    if (cmd == "daemon")  return cmd_daemon(argc, argv);
+    if (cmd == "qos")     return cmd_qos(argc, argv);
+    if (cmd == "cap")     return cmd_cap(argc, argv);
+    if (cmd == "uclamp")  return cmd_uclamp(argc, argv);
+    if (cmd == "report")  return cmd_report(argc, argv);
+    if (cmd == "edp")     return cmd_edp(argc, argv);
+    if (cmd == "pacing")  return cmd_pacing(argc, argv);
+    if (cmd == "frames")  return cmd_frames(argc, argv);
+    if (cmd == "rpm")     return cmd_rpm(argc, argv);
 
     std::cerr << "Unknown subcommand: " << cmd << "\n";
     usage();
@@ -0,0 +1,203 @@
+// budget.cpp
+#include "dvfs/budget.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+namespace {
+
+constexpr long long kCpuMaxPeriodUs = 100000;
+
+bool cgroup_usage_usec(const std::string& cg, long long& out) {
+    auto t = read_file(cg + "/cpu.stat");
+    if (!t) return false;
+    std::istringstream is(*t);
+    std::string k;
+    long long v;
+    while (is >> k >> v) {
+        if (k == "usage_usec") {
+            out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Non-idle CPU time of the whole system, us.
+bool system_busy_usec(long long& out) {
+    auto t = read_file("/proc/stat");
+    if (!t || t->compare(0, 4, "cpu ") != 0) return false;
+    std::istringstream is(t->substr(4, t->find('\n') - 4));
+    long long v[8] = {};
+    for (auto& x : v) is >> x;  // user nice system idle iowait irq softirq steal
+    const long long busy = v[0] + v[1] + v[2] + v[5] + v[6] + v[7];
+    out = busy * 1000000 / ::sysconf(_SC_CLK_TCK);
+    return true;
+}
+
+} // namespace
+
+bool parse_tenant(const std::string& s, Tenant& out) {
+    const auto colon = s.rfind(':');
+    out.cgroup = s.substr(0, colon);
+    out.weight = 1.0;
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        out.weight = std::strtod(s.c_str() + colon + 1, &end);
+        if (*end != '\0' || !(out.weight > 0)) return false;
+    }
+    return !out.cgroup.empty();
+}
+
+std::vector<double> share_budget(double budget, const std::vector<double>& weights,
+                                 const std::vector<double>& demand) {
+    const size_t n = weights.size();
+    std::vector<double> out(n, 0.0);
+    std::vector<bool> done(n, false);
+    double left = std::max(0.0, budget);
+    for (bool changed = true; changed;) {
+        changed = false;
+        double wsum = 0;
+        for (size_t i = 0; i < n; ++i) if (!done[i]) wsum += weights[i];
+        if (wsum <= 0) break;
+        // Satisfy everyone whose demand fits their fair share; repeat with
+        // what they leave.
+        for (size_t i = 0; i < n; ++i) {
+            if (done[i] || demand[i] < 0 || demand[i] > left * weights[i] / wsum) continue;
+            out[i] = demand[i];
+            done[i] = true;
+            changed = true;
+        }
+        if (changed) {
+            left = budget;
+            for (size_t i = 0; i < n; ++i) if (done[i]) left -= out[i];
+            left = std::max(0.0, left);
+        }
+    }
+    double wsum = 0;
+    for (size_t i = 0; i < n; ++i) if (!done[i]) wsum += weights[i];
+    for (size_t i = 0; i < n; ++i) if (!done[i]) out[i] = left * weights[i] / wsum;
+    return out;
+}
+
+// ---- BudgetSharer ----
+BudgetSharer::BudgetSharer(std::vector<Tenant> tenants, BudgetEnforce mode, double min_level)
+    : t_(std::move(tenants)), st_(t_.size()), mode_(mode), min_level_(min_level) {
+    ncpus_ = std::max(1, (int)::sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+bool BudgetSharer::start(std::string& err) {
+    for (auto& t : t_) {
+        long long u;
+        if (!cgroup_usage_usec(t.cgroup, u)) {
+            err = "No cpu.stat usage_usec under " + t.cgroup + " (cgroup v2?)";
+            return false;
+        }
+        if (mode_ == BudgetEnforce::CpuMax) {
+            auto m = read_text(t.cgroup + "/cpu.max");
+            if (!m) {
+                err = "No cpu.max under " + t.cgroup + " (cpu controller enabled?)";
+                return false;
+            }
+            saved_max_.push_back(*m);
+        } else if (!uc_.clamp_cgroup(t.cgroup, -1, 100.0, err)) {
+            return false;
+        }
+    }
+    started_ = true;
+    return true;
+}
+
+bool BudgetSharer::read_usage(std::vector<long long>& usec, long long& busy_usec) const {
+    usec.resize(t_.size());
+    for (size_t i = 0; i < t_.size(); ++i) {
+        if (!cgroup_usage_usec(t_[i].cgroup, usec[i])) usec[i] = i < last_usec_.size() ? last_usec_[i] : 0;
+    }
+    return system_busy_usec(busy_usec);
+}
+
+void BudgetSharer::step(double mw, double idle_mw, double cap_mw) {
+    if (!started_ || !(mw >= 0)) return;
+    std::vector<long long> usec;
+    long long busy = 0;
+    const int64_t ts = now_ns();
+    if (!read_usage(usec, busy)) return;
+    if (last_busy_ < 0) {
+        last_usec_ = usec;
+        last_busy_ = busy;
+        last_ts_ = ts;
+        return;
+    }
+    const double dt = (double)(ts - last_ts_) * 1e-9;
+    const double dbusy = (double)(busy - last_busy_);
+    const double dyn = std::max(0.0, mw - idle_mw);
+    double tenant_mw = 0;
+    std::vector<double> dus(t_.size());
+    double dsum = 0;
+    for (size_t i = 0; i < t_.size(); ++i) {
+        dus[i] = (double)std::max(0LL, usec[i] - last_usec_[i]);
+        dsum += dus[i];
+    }
+    // /proc/stat ticks are coarse; never attribute more than all of it.
+    const double denom = std::max(dbusy, dsum);
+    for (size_t i = 0; i < t_.size(); ++i) {
+        auto& s = st_[i];
+        s.usage_pct = dt > 0 ? dus[i] / (dt * 1e6) * 100.0 : 0.0;
+        s.attr_mw = denom > 0 ? dyn * dus[i] / denom : 0.0;
+        s.energy_mj += s.attr_mw * dt;
+        tenant_mw += s.attr_mw;
+    }
+    other_mw_ = dyn - tenant_mw;
+
+    // Demand: what a tenant uses plus headroom, unbounded if it is pressing
+    // against its allocation (throttled and using nearly all of it).
+    std::vector<double> w(t_.size()), demand(t_.size());
+    for (size_t i = 0; i < t_.size(); ++i) {
+        const auto& s = st_[i];
+        w[i] = t_[i].weight;
+        const bool pressing = s.level < 1.0 && s.alloc_mw > 0 && s.attr_mw >= 0.9 * s.alloc_mw;
+        demand[i] = pressing ? -1.0 : s.attr_mw * 1.25;
+    }
+    const auto alloc = share_budget(cap_mw - idle_mw - other_mw_, w, demand);
+    for (size_t i = 0; i < t_.size(); ++i) {
+        auto& s = st_[i];
+        s.alloc_mw = alloc[i];
+        double r = s.attr_mw > 1.0 ? alloc[i] / s.attr_mw : 1.5;
+        r = std::clamp(r, 0.5, 1.5);
+        s.level = std::clamp(s.level * std::sqrt(r), min_level_, 1.0);
+        enforce(i);
+    }
+    last_usec_ = std::move(usec);
+    last_busy_ = busy;
+    last_ts_ = ts;
+}
+
+void BudgetSharer::enforce(size_t i) {
+    const double lv = st_[i].level;
+    if (mode_ == BudgetEnforce::CpuMax) {
+        const long long quota = (long long)(lv * ncpus_ * kCpuMaxPeriodUs);
+        write_text(t_[i].cgroup + "/cpu.max", (lv >= 1.0 ? std::string("max") : std::to_string(quota)) + " " +
+                                                  std::to_string(kCpuMaxPeriodUs));
+    } else {
+        std::string err;
+        set_cgroup_uclamp(t_[i].cgroup, -1, lv * 100.0, err);
+    }
+}
+
+void BudgetSharer::restore() {
+    if (!started_) return;
+    for (size_t i = 0; i < saved_max_.size(); ++i) write_text(t_[i].cgroup + "/cpu.max", saved_max_[i]);
+    uc_.restore();
+    started_ = false;
+}
+
+} // namespace dvfs
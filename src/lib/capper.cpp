@@ -0,0 +1,47 @@
+// capper.cpp
+#include "dvfs/capper.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace dvfs {
+
+PowerCapper::PowerCapper(std::vector<long long> cpu_opps, std::vector<long long> gpu_opps, double cap_mw,
+                         double hyst, double alpha)
+    : cpu_(std::move(cpu_opps)), gpu_(std::move(gpu_opps)), cap_mw_(cap_mw), hyst_(hyst), alpha_(alpha) {
+    // Start uncapped.
+    ci_ = cpu_.empty() ? 0 : cpu_.size() - 1;
+    gi_ = gpu_.empty() ? 0 : gpu_.size() - 1;
+}
+
+bool PowerCapper::step(double mw, std::string& note) {
+    if (!(mw >= 0.0)) return false;
+    mw_ = (mw_ < 0.0) ? mw : mw_ + alpha_ * (mw - mw_);
+    const double lc = level(cpu_, ci_), lg = level(gpu_, gi_);
+    const bool cpu_down = ci_ > 0, gpu_down = gi_ > 0;
+    const bool cpu_up = !cpu_.empty() && ci_ + 1 < cpu_.size(), gpu_up = !gpu_.empty() && gi_ + 1 < gpu_.size();
+    // NaN compares false both ways: no pressure signal, level order only.
+    const bool low_stall = psi_ < psi_low_, high_stall = psi_ > psi_high_;
+    const char* what = nullptr;
+
+    if (mw_ > cap_mw_) {
+        if (low_stall && cpu_down) { ci_--; what = "cpu down"; }
+        else if (high_stall && gpu_down) { gi_--; what = "gpu down"; }
+        else if (gpu_down && (!cpu_down || lg >= lc)) { gi_--; what = "gpu down"; }
+        else if (cpu_down) { ci_--; what = "cpu down"; }
+    } else if (mw_ < cap_mw_ * (1.0 - hyst_)) {
+        if (high_stall && cpu_up) { ci_++; what = "cpu up"; }
+        else if (low_stall && gpu_up) { gi_++; what = "gpu up"; }
+        else if (cpu_up && (!gpu_up || lc <= lg)) { ci_++; what = "cpu up"; }
+        else if (gpu_up) { gi_++; what = "gpu up"; }
+    }
+    if (!what) return false;
+    char buf[192];
+    int n = std::snprintf(buf, sizeof(buf), "%s: %.0f mW vs cap %.0f -> cpu<=%lld kHz gpu<=%lld Hz", what, mw_,
+                          cap_mw_, cpu_max(), gpu_max());
+    if (!std::isnan(psi_)) std::snprintf(buf + n, sizeof(buf) - (size_t)n, " (cpu stall %.1f%%)", psi_);
+    note = buf;
+    return true;
+}
+
+} // namespace dvfs
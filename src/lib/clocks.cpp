@@ -0,0 +1,147 @@
+// clocks.cpp
+#include "dvfs/clocks.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+#include <time.h>
+
+#include "dvfs/sysfs.hpp"
+
+namespace dvfs {
+
+namespace {
+
+inline int64_t read_clock(clockid_t id) {
+    timespec ts;
+    ::clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+clockid_t clock_id(ClockDomain d) {
+    return d == ClockDomain::Monotonic ? CLOCK_MONOTONIC : d == ClockDomain::Boottime ? CLOCK_BOOTTIME : CLOCK_REALTIME;
+}
+
+} // namespace
+
+bool parse_clock_domain(const std::string& s, ClockDomain& d) {
+    if (s == "mono" || s == "monotonic") d = ClockDomain::Monotonic;
+    else if (s == "boot" || s == "boottime") d = ClockDomain::Boottime;
+    else if (s == "real" || s == "realtime") d = ClockDomain::Realtime;
+    else return false;
+    return true;
+}
+
+const char* clock_domain_name(ClockDomain d) {
+    return d == ClockDomain::Monotonic ? "mono" : d == ClockDomain::Boottime ? "boot" : "real";
+}
+
+int64_t clock_ns(ClockDomain d) { return read_clock(clock_id(d)); }
+
+ClockAnchor read_anchor(int tries) {
+    ClockAnchor best;
+    int64_t best_win = INT64_MAX;
+    for (int i = 0; i < std::max(1, tries); ++i) {
+        const int64_t m0 = read_clock(CLOCK_MONOTONIC);
+        const int64_t b = read_clock(CLOCK_BOOTTIME);
+        const int64_t r = read_clock(CLOCK_REALTIME);
+        const int64_t m1 = read_clock(CLOCK_MONOTONIC);
+        if (m1 - m0 < best_win) {
+            best_win = m1 - m0;
+            best.mono_ns = m0 + (m1 - m0) / 2;
+            best.boot_ns = b;
+            best.real_ns = r;
+            best.unc_ns = (m1 - m0 + 1) / 2;
+        }
+    }
+    return best;
+}
+
+void append_anchor_header(std::string& out) { out += "mono_ns,boot_ns,real_ns,unc_ns\n"; }
+
+void append_anchor(std::string& out, const ClockAnchor& a) {
+    char buf[24];
+    for (int64_t v : {a.mono_ns, a.boot_ns, a.real_ns, a.unc_ns}) {
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+        out.push_back(',');
+    }
+    out.back() = '\n';
+}
+
+bool load_anchors(const std::string& path, std::vector<ClockAnchor>& out, std::string& err) {
+    auto text = read_file(path);
+    if (!text) {
+        err = "Failed to open: " + path;
+        return false;
+    }
+    const char* p = text->data();
+    const char* e = p + text->size();
+    int line = 0;
+    while (p < e) {
+        const char* nl = std::find(p, e, '\n');
+        line++;
+        if (line > 1 && nl > p) {
+            int64_t v[4];
+            const char* q = p;
+            for (int i = 0; i < 4; ++i) {
+                auto r = std::from_chars(q, nl, v[i]);
+                if (r.ec != std::errc() || (i < 3 && (r.ptr == nl || *r.ptr != ','))) {
+                    err = path + ":" + std::to_string(line) + ": bad anchor";
+                    return false;
+                }
+                q = r.ptr + 1;
+            }
+            out.push_back({v[0], v[1], v[2], v[3]});
+        }
+        p = nl + 1;
+    }
+    if (out.empty()) {
+        err = path + ": no anchors";
+        return false;
+    }
+    return true;
+}
+
+ClockMap::ClockMap(std::vector<ClockAnchor> anchors) : a_(std::move(anchors)) {
+    std::stable_sort(a_.begin(), a_.end(), [](auto& x, auto& y) { return x.mono_ns < y.mono_ns; });
+    for (int d = 0; d < 3; ++d) {
+        for (size_t i = 1; i < a_.size(); ++i) {
+            if (a_[i].get((ClockDomain)d) < a_[i - 1].get((ClockDomain)d)) sorted_[d] = false;
+        }
+    }
+}
+
+int64_t ClockMap::convert(int64_t ts, ClockDomain from, ClockDomain to, int64_t* unc) const {
+    if (a_.empty() || from == to) {
+        if (unc) *unc = 0;
+        return ts;
+    }
+    // i = last anchor at or before ts in the source domain (-1 = before all).
+    long i = -1;
+    if (sorted_[(int)from]) {
+        auto it = std::upper_bound(a_.begin(), a_.end(), ts,
+                                   [from](int64_t t, const ClockAnchor& a) { return t < a.get(from); });
+        i = (long)(it - a_.begin()) - 1;
+    } else {
+        // REALTIME stepped backwards: pick the closest earlier anchor by value.
+        for (size_t k = 0; k < a_.size(); ++k) {
+            if (a_[k].get(from) <= ts && (i < 0 || a_[k].get(from) > a_[(size_t)i].get(from))) i = (long)k;
+        }
+    }
+    const ClockAnchor& a = a_[(size_t)std::max(0L, i)];
+    const int64_t off_a = a.get(to) - a.get(from);
+    if (unc) *unc = a.unc_ns;
+    if (i < 0 || (size_t)i + 1 >= a_.size()) return ts + off_a;
+
+    const ClockAnchor& b = a_[(size_t)i + 1];
+    const int64_t span = b.get(from) - a.get(from);
+    const int64_t off_b = b.get(to) - b.get(from);
+    if (unc) *unc = std::max(a.unc_ns, b.unc_ns);
+    if (span <= 0 || std::fabs((double)(off_b - off_a)) > span * kStepPpm * 1e-6) return ts + off_a;
+    const double f = (double)(ts - a.get(from)) / (double)span;
+    return ts + off_a + (int64_t)std::llround(f * (double)(off_b - off_a));
+}
+
+} // namespace dvfs
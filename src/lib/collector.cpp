@@ -0,0 +1,276 @@
+// collector.cpp
+#include "dvfs/collector.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dvfs/stream.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+// ---- MergeStore ----
+bool MergeStore::open(const std::string& path) { return w_.open(path); }
+
+int MergeStore::add_board(const std::string& name, const std::vector<std::string>& cols,
+                          std::vector<std::string>& dropped) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (cols_.empty() && boards_.empty()) {
+        cols_ = cols;
+        std::string h = "board,ts_ns,src_ts_ns";
+        for (auto& c : cols_) { h.push_back(','); h += c; }
+        h.push_back('\n');
+        w_.append(h);
+    }
+    Board b;
+    b.name = name;
+    for (auto& c : cols) {
+        int idx = -1;
+        for (size_t j = 0; j < cols_.size(); ++j) if (cols_[j] == c) { idx = (int)j; break; }
+        if (idx < 0) dropped.push_back(c);
+        b.map.push_back(idx);
+    }
+    boards_.push_back(std::move(b));
+    return (int)boards_.size() - 1;
+}
+
+void MergeStore::push(int board, const int64_t* src_ts, const double* vals, size_t nrows, int64_t offset_ns) {
+    std::lock_guard<std::mutex> lk(mu_);
+    Board& b = boards_[(size_t)board];
+    const size_t nc = b.map.size();
+    for (size_t r = 0; r < nrows; ++r) {
+        Row row{src_ts[r] - offset_ns, src_ts[r], std::vector<double>(cols_.size(), std::nan(""))};
+        for (size_t j = 0; j < nc; ++j) if (b.map[j] >= 0) row.v[(size_t)b.map[j]] = vals[r * nc + j];
+        if (row.ts > newest_) newest_ = row.ts;
+        b.q.push_back(std::move(row));
+    }
+    pump(false);
+}
+
+void MergeStore::finish(int board) {
+    std::lock_guard<std::mutex> lk(mu_);
+    boards_[(size_t)board].done = true;
+    pump(false);
+}
+
+void MergeStore::close() {
+    std::lock_guard<std::mutex> lk(mu_);
+    pump(true);
+    w_.close();
+}
+
+// Emit the oldest queued row while no live board could still send an older one.
+void MergeStore::pump(bool drain) {
+    char buf[24];
+    for (;;) {
+        Board* best = nullptr;
+        bool stalled = false;
+        for (auto& b : boards_) {
+            if (b.q.empty()) {
+                if (!b.done) stalled = true;
+                continue;
+            }
+            if (!best || b.q.front().ts < best->q.front().ts) best = &b;
+        }
+        if (!best) break;
+        const Row& r = best->q.front();
+        if (stalled && !drain && r.ts > newest_ - max_lag_ns_) break;
+
+        line_.clear();
+        line_ += best->name;
+        line_.push_back(',');
+        line_.append(buf, std::to_chars(buf, buf + sizeof(buf), r.ts).ptr);
+        line_.push_back(',');
+        line_.append(buf, std::to_chars(buf, buf + sizeof(buf), r.src).ptr);
+        for (double v : r.v) { line_.push_back(','); append_num(line_, v); }
+        line_.push_back('\n');
+        w_.append(line_);
+        best->q.pop_front();
+        written_++;
+    }
+    w_.flush();
+}
+
+// ---- Collector ----
+namespace {
+
+struct Conn {
+    std::string in;
+    std::string board = "?";
+    int id = -1;
+    std::unique_ptr<RowDecoder> dec;
+    int64_t offset = 0;
+    bool clocked = false;
+    std::vector<int64_t> ts;
+    std::vector<double> vals;
+};
+
+int open_listener(int port, std::string& err) {
+    int fd = ::socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        err = "socket failed";
+        return -1;
+    }
+    int one = 1, zero = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    sockaddr_in6 a{};
+    a.sin6_family = AF_INET6;
+    a.sin6_addr = in6addr_any;
+    a.sin6_port = htons((uint16_t)port);
+    if (::bind(fd, (sockaddr*)&a, sizeof(a)) != 0 || ::listen(fd, 64) != 0) {
+        err = "Failed to listen on port " + std::to_string(port) + ": " + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+bool Collector::start(int port, int threads, std::string& err) {
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    stop_ = false;
+    for (int i = 0; i < threads; ++i) {
+        int fd = open_listener(port, err);
+        if (fd < 0) {
+            stop();
+            return false;
+        }
+        if (i == 0) {
+            sockaddr_in6 a{};
+            socklen_t len = sizeof(a);
+            ::getsockname(fd, (sockaddr*)&a, &len);
+            port = port_ = ntohs(a.sin6_port);
+        }
+        listeners_.push_back(fd);
+    }
+    for (int fd : listeners_) threads_.emplace_back(&Collector::worker, this, fd);
+    return true;
+}
+
+void Collector::stop() {
+    stop_ = true;
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+    for (int fd : listeners_) ::close(fd);
+    listeners_.clear();
+}
+
+void Collector::note(const std::string& msg) {
+    if (!on_event) return;
+    std::lock_guard<std::mutex> lk(note_mu_);
+    on_event(msg);
+}
+
+void Collector::worker(int listen_fd) {
+    const int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd, &ev);
+
+    std::map<int, Conn> conns;
+    auto drop = [&](int fd, const std::string& why) {
+        Conn& c = conns[fd];
+        if (c.id >= 0) store_.finish(c.id);
+        note("board " + c.board + ": " + why);
+        ::epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        conns.erase(fd);
+    };
+
+    // Process every complete frame buffered on a connection; false = protocol error.
+    auto handle = [&](int fd, Conn& c) -> bool {
+        for (;;) {
+            const char* b = c.in.data();
+            const size_t fs = frame_size(b, b + c.in.size());
+            if (fs == SIZE_MAX) return false;
+            if (fs == 0) return true;
+            const FrameType t = (FrameType)b[0];
+            const char* p = b + kFrameHeader;
+            const char* e = b + fs;
+            if (t == FrameType::Hello) {
+                std::vector<std::string> cols, dropped;
+                if (c.dec || !decode_hello(p, e, c.board, cols)) return false;
+                c.dec.reset(new RowDecoder(cols.size()));
+                c.id = store_.add_board(c.board, cols, dropped);
+                std::string msg = "board " + c.board + ": connected, " + std::to_string(cols.size()) + " columns";
+                if (!dropped.empty()) msg += ", " + std::to_string(dropped.size()) + " not in store (dropped)";
+                note(msg);
+            } else if (t == FrameType::Sync) {
+                int64_t c0;
+                if (!get_i64(p, e, c0)) return false;
+                std::string pl, f;
+                put_i64(pl, c0);
+                put_i64(pl, now_ns());
+                append_frame(f, FrameType::SyncAck, pl);
+                // 21 bytes on an otherwise idle send path; a full socket buffer means a dead peer.
+                if (::send(fd, f.data(), f.size(), MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)f.size()) return false;
+            } else if (t == FrameType::Clock) {
+                int64_t off, rtt;
+                if (!get_i64(p, e, off) || !get_i64(p, e, rtt)) return false;
+                if (!c.clocked) {
+                    note("board " + c.board + ": clock offset " + std::to_string(off) + " ns (rtt " +
+                         std::to_string(rtt) + " ns)");
+                }
+                c.offset = off;
+                c.clocked = true;
+            } else if (t == FrameType::Rows) {
+                if (!c.dec || !c.clocked) return false;
+                c.ts.clear();
+                c.vals.clear();
+                if (!c.dec->decode(p, e, c.ts, c.vals)) return false;
+                store_.push(c.id, c.ts.data(), c.vals.data(), c.ts.size(), c.offset);
+            } else {
+                return false;
+            }
+            c.in.erase(0, fs);
+        }
+    };
+
+    epoll_event evs[64];
+    char buf[65536];
+    while (!stop_) {
+        const int n = ::epoll_wait(ep, evs, 64, 200);
+        for (int i = 0; i < n; ++i) {
+            const int fd = evs[i].data.fd;
+            if (fd == listen_fd) {
+                for (int cfd; (cfd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;) {
+                    epoll_event cev{};
+                    cev.events = EPOLLIN | EPOLLRDHUP;
+                    cev.data.fd = cfd;
+                    ::epoll_ctl(ep, EPOLL_CTL_ADD, cfd, &cev);
+                    conns[cfd];
+                }
+                continue;
+            }
+            Conn& c = conns[fd];
+            bool eof = false;
+            for (;;) {
+                ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+                if (r > 0) { c.in.append(buf, (size_t)r); continue; }
+                if (r == 0 || (errno != EAGAIN && errno != EINTR)) eof = true;
+                if (r < 0 && errno == EINTR) continue;
+                break;
+            }
+            if (!handle(fd, c)) drop(fd, "protocol error, disconnected");
+            else if (eof) drop(fd, "disconnected");
+        }
+    }
+    while (!conns.empty()) drop(conns.begin()->first, "collector stopping");
+    ::close(ep);
+}
+
+} // namespace dvfs
@@ -0,0 +1,116 @@
+// controller.cpp
+#include "dvfs/controller.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/topology.hpp"
+
+namespace dvfs {
+
+namespace {
+
+std::vector<long long> read_list(const std::string& path) {
+    std::vector<long long> out;
+    auto t = read_text(path);
+    if (!t) return out;
+    std::istringstream is(*t);
+    for (long long v; is >> v;) out.push_back(v);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+// Write min/max so that min <= max holds after every single write.
+bool write_range(const std::string& min_p, const std::string& max_p, long long mn, long long mx) {
+    auto cur_max = read_ll(max_p);
+    if (cur_max && mn > *cur_max) {
+        bool a = write_text(max_p, std::to_string(mx));
+        bool b = write_text(min_p, std::to_string(mn));
+        return a && b;
+    }
+    bool a = write_text(min_p, std::to_string(mn));
+    bool b = write_text(max_p, std::to_string(mx));
+    return a && b;
+}
+
+} // namespace
+
+Controller::Controller(std::string cpu_dir, std::string gpu_dir)
+    : cpu_dir_(std::move(cpu_dir)), gpu_dir_(std::move(gpu_dir)) {}
+
+std::optional<Controller> Controller::discover() {
+    auto cpu_dir = find_cpu_policy_dir();
+    auto gpu_dir = find_gpu_devfreq_dir();
+    if (!cpu_dir || !gpu_dir) return std::nullopt;
+    return Controller(*cpu_dir, *gpu_dir);
+}
+
+std::vector<SysfsWrite> Controller::plan_lock(const std::string& cpu_khz, const std::string& gpu_hz) const {
+    return {
+        {cpu_dir_ + "/scaling_min_freq", cpu_khz, ""},
+        {cpu_dir_ + "/scaling_max_freq", cpu_khz, ""},
+        {gpu_dir_ + "/min_freq", gpu_hz, ""},
+        {gpu_dir_ + "/max_freq", gpu_hz, ""},
+    };
+}
+
+std::vector<SysfsWrite> Controller::plan_unlock() const {
+    auto cmin = read_text(cpu_dir_ + "/cpuinfo_min_freq");
+    auto cmax = read_text(cpu_dir_ + "/cpuinfo_max_freq");
+
+    // Pick GPU min/max defaults from available_frequencies (first/last token).
+    std::string gpu_min_default;
+    std::string gpu_max_default;
+    if (auto af = read_text(gpu_dir_ + "/available_frequencies"); af && !af->empty()) {
+        std::string s = *af;
+        while (!s.empty() && (s.back()==' ' || s.back()=='\t' || s.back()=='\n' || s.back()=='\r')) s.pop_back();
+
+        size_t first_end = s.find_first_of(" \t");
+        gpu_min_default = (first_end == std::string::npos) ? s : s.substr(0, first_end);
+
+        size_t last_sep = s.find_last_of(" \t");
+        gpu_max_default = (last_sep == std::string::npos) ? s : s.substr(last_sep + 1);
+    }
+    if (gpu_min_default.empty()) gpu_min_default = read_text(gpu_dir_ + "/min_freq").value_or("306000000");
+    if (gpu_max_default.empty()) gpu_max_default = read_text(gpu_dir_ + "/max_freq").value_or("1020000000");
+
+    const std::string gov_p = gpu_dir_ + "/governor";
+    const bool has_gov = exists(gov_p);
+    return {
+        {cpu_dir_ + "/scaling_min_freq", cmin.value_or(""), cmin ? "cpuinfo_min_freq" : "cpuinfo_min_freq missing"},
+        {cpu_dir_ + "/scaling_max_freq", cmax.value_or(""), cmax ? "cpuinfo_max_freq" : "cpuinfo_max_freq missing"},
+        {gpu_dir_ + "/min_freq", gpu_min_default, "from available_frequencies if present"},
+        {gpu_dir_ + "/max_freq", gpu_max_default, "from available_frequencies if present"},
+        {gov_p, has_gov ? "nvhost_podgov" : "", has_gov ? "" : "no governor file"},
+    };
+}
+
+std::vector<bool> Controller::apply(const std::vector<SysfsWrite>& plan) {
+    std::vector<bool> ok;
+    ok.reserve(plan.size());
+    for (auto& w : plan) ok.push_back(w.value.empty() ? true : write_text(w.path, w.value));
+    return ok;
+}
+
+bool Controller::set_cpu_range_khz(long long min_khz, long long max_khz) const {
+    return write_range(cpu_dir_ + "/scaling_min_freq", cpu_dir_ + "/scaling_max_freq", min_khz, max_khz);
+}
+
+bool Controller::set_gpu_range_hz(long long min_hz, long long max_hz) const {
+    return write_range(gpu_dir_ + "/min_freq", gpu_dir_ + "/max_freq", min_hz, max_hz);
+}
+
+std::optional<long long> Controller::cpu_cur_khz() const { return read_ll(cpu_dir_ + "/scaling_cur_freq"); }
+std::optional<long long> Controller::gpu_cur_hz() const { return read_ll(gpu_dir_ + "/cur_freq"); }
+
+std::vector<long long> Controller::cpu_opps_khz() const {
+    return read_list(cpu_dir_ + "/scaling_available_frequencies");
+}
+
+std::vector<long long> Controller::gpu_opps_hz() const {
+    return read_list(gpu_dir_ + "/available_frequencies");
+}
+
+} // namespace dvfs
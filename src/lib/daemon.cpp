@@ -0,0 +1,441 @@
+// daemon.cpp
+#include "dvfs/daemon.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+namespace {
+
+bool parse_ll(const std::string& s, long long& v) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool make_addr(const std::string& path, sockaddr_un& a, std::string& err) {
+    a = {};
+    a.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(a.sun_path)) {
+        err = "Socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(a.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+// ---- QosServer ----
+bool QosServer::listen(const std::string& path, std::string& err) {
+    sockaddr_un a;
+    if (!make_addr(path, a, err)) return false;
+    lfd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (lfd_ < 0) {
+        err = "socket failed";
+        return false;
+    }
+    ::unlink(path.c_str());
+    if (::bind(lfd_, (sockaddr*)&a, sizeof(a)) != 0 || ::listen(lfd_, 16) != 0) {
+        err = "Failed to listen on " + path + ": " + std::strerror(errno);
+        ::close(lfd_);
+        lfd_ = -1;
+        return false;
+    }
+    path_ = path;
+    return true;
+}
+
+bool QosServer::open_trace(const std::string& path) {
+    if (!tw_.open(path)) return false;
+    tw_.append(std::string("ts_ns,client,event,domain,priority,cap,min,max,eff_min,eff_max,note\n"));
+    tw_.flush();
+    tracing_ = true;
+    return true;
+}
+
+void QosServer::trace(const std::string& client, const char* event, QosDomain d, const QosRequest* r,
+                      const std::string& note) {
+    const QosRange eff = arb_.aggregate(d).range;
+    if (on_event) {
+        std::string m = client + " " + event + " " + qos_domain_name(d);
+        if (r) m += " min=" + std::to_string(r->min) + " max=" + std::to_string(r->max) +
+                    " prio=" + std::to_string(r->priority) + (r->cap ? " cap" : "");
+        m += " -> " + std::to_string(eff.min) + ":" + std::to_string(eff.max);
+        if (!note.empty()) m += " (" + note + ")";
+        on_event(m);
+    }
+    if (!tracing_) return;
+    std::string line = std::to_string(now_ns()) + "," + client + "," + event + "," + qos_domain_name(d) + ",";
+    if (r) {
+        line += std::to_string(r->priority) + "," + (r->cap ? "1" : "0") + "," + std::to_string(r->min) + "," +
+                std::to_string(r->max);
+    } else {
+        line += ",,,";
+    }
+    line += "," + std::to_string(eff.min) + "," + std::to_string(eff.max) + "," + note + "\n";
+    tw_.append(line);
+    tw_.flush();
+}
+
+void QosServer::trace_latency(const std::string& client, const char* event, int us, const std::string& note) {
+    const int eff = lat_->global_us();
+    if (on_event) {
+        std::string m = client + " " + event + " lat";
+        if (us >= 0) m += " " + std::to_string(us) + "us";
+        m += " -> global " + (eff < 0 ? std::string("none") : std::to_string(eff) + "us");
+        for (auto& [cpu, v] : lat_->cpu_us()) m += " cpu" + std::to_string(cpu) + "=" + std::to_string(v) + "us";
+        if (!note.empty()) m += " (" + note + ")";
+        on_event(m);
+    }
+    if (!tracing_) return;
+    std::string line = std::to_string(now_ns()) + "," + client + "," + event + ",lat,,," +
+                       (us >= 0 ? std::to_string(us) : "") + ",," + (eff >= 0 ? std::to_string(eff) : "") + ",," +
+                       note + "\n";
+    tw_.append(line);
+    tw_.flush();
+}
+
+void QosServer::end_latency(Conn& c) {
+    std::string err;
+    if (!lat_ || !lat_->drop(c.name, err)) return;
+    std::string cost;
+    if (meter_) {
+        cost = meter_->end(c.name);
+        if (!cost.empty()) cost.pop_back();
+    }
+    trace_latency(c.name, "latency_off", -1, err);
+    if (on_event && !cost.empty()) on_event("window " + cost);
+}
+
+void QosServer::update(QosDomain d, const std::string& client) {
+    const QosResult res = arb_.aggregate(d);
+    for (auto& c : res.clipped) {
+        if (c == client) trace(client, "clipped", d, nullptr, "outranked or capped");
+    }
+    if (res.range == applied_[(int)d]) return;
+    write(d, res);
+}
+
+void QosServer::write(QosDomain d, const QosResult& res) {
+    const bool ok = !on_apply || on_apply(d, res.range);
+    applied_[(int)d] = res.range;
+    std::string note = ok ? "" : "write failed";
+    for (auto& c : res.clipped) note += (note.empty() ? "clipped " : " ") + c;
+    trace("-", "write", d, nullptr, note);
+}
+
+void QosServer::apply_all() {
+    for (int d = 0; d < kQosDomains; ++d) write((QosDomain)d, arb_.aggregate((QosDomain)d));
+}
+
+void QosServer::reply(Conn& c, const std::string& line) {
+    std::string out = line + "\n";
+    const char* p = out.data();
+    size_t left = out.size();
+    while (left > 0) {
+        ssize_t n = ::send(c.fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            pollfd pfd{c.fd, POLLOUT, 0};
+            if (::poll(&pfd, 1, 100) > 0) continue;
+        }
+        if (n <= 0) {
+            c.dead = true;
+            return;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+}
+
+void QosServer::handle(Conn& c, const std::string& line) {
+    std::istringstream is(line);
+    std::string cmd, arg;
+    is >> cmd;
+    if (cmd == "hello") {
+        is >> arg;
+        if (arg.empty() || arg == "-" || arg.find(',') != std::string::npos) return reply(c, "err bad name");
+        for (auto& o : conns_) {
+            if (o.get() != &c && o->name == arg) arg += "#" + std::to_string(c.fd);
+        }
+        end_latency(c);
+        for (int d = 0; d < kQosDomains; ++d) {
+            const auto reqs = arb_.requests((QosDomain)d);
+            for (auto r : reqs) {
+                if (r.client != c.name) continue;
+                arb_.drop((QosDomain)d, c.name);
+                r.client = arg;
+                arb_.request((QosDomain)d, r);
+            }
+        }
+        c.name = arg;
+        return reply(c, "ok " + c.name);
+    }
+    if (cmd == "get") {
+        std::string r = "ok";
+        for (int d = 0; d < kQosDomains; ++d) {
+            const QosRange x = arb_.aggregate((QosDomain)d).range;
+            r += std::string(" ") + qos_domain_name((QosDomain)d) + "=" + std::to_string(x.min) + ":" +
+                 std::to_string(x.max);
+        }
+        return reply(c, r);
+    }
+    if (cmd == "status") {
+        for (int d = 0; d < kQosDomains; ++d) {
+            const QosResult res = arb_.aggregate((QosDomain)d);
+            for (auto& r : arb_.requests((QosDomain)d)) {
+                const bool clipped = std::find(res.clipped.begin(), res.clipped.end(), r.client) != res.clipped.end();
+                reply(c, "req " + r.client + " " + qos_domain_name((QosDomain)d) + " min=" + std::to_string(r.min) +
+                             " max=" + std::to_string(r.max) + " prio=" + std::to_string(r.priority) +
+                             " cap=" + (r.cap ? "1" : "0") + (clipped ? " clipped" : ""));
+            }
+        }
+        return handle(c, "get");
+    }
+
+    if (cmd == "latency") {
+        if (!lat_) return reply(c, "err latency holds not enabled");
+        is >> arg;
+        if (arg == "off") {
+            end_latency(c);
+            return reply(c, "ok");
+        }
+        long long us = -1;
+        if (!parse_ll(arg, us)) return reply(c, "err bad latency: " + arg);
+        std::vector<int> cpus;
+        std::string label = "-";
+        for (std::string kv; is >> kv;) {
+            if (kv.compare(0, 5, "cpus=") == 0 && parse_cpu_list(kv.substr(5), cpus)) continue;
+            if (kv.compare(0, 6, "label=") == 0 && kv.size() > 6 && kv.find(',') == std::string::npos) {
+                label = kv.substr(6);
+                continue;
+            }
+            return reply(c, "err bad field: " + kv);
+        }
+        end_latency(c);  // a new request starts a new window
+        std::string err;
+        const bool ok = lat_->request(c.name, (int)us, cpus, err);
+        if (meter_) meter_->begin(c.name, label, (int)us, cpus);
+        trace_latency(c.name, "latency", (int)us, (cpus.empty() ? "" : "cpus=" + format_cpu_list(cpus)) + err);
+        return reply(c, ok ? "ok " + std::to_string(us) : "err " + err);
+    }
+
+    QosDomain d;
+    is >> arg;
+    if (cmd != "set" && cmd != "clear" && cmd != "opps") return reply(c, "err unknown command: " + cmd);
+    if (!parse_qos_domain(arg, d)) return reply(c, "err bad domain: " + arg);
+    if (cmd == "opps") {
+        std::string r = "ok";
+        for (long long v : arb_.opps(d)) r += " " + std::to_string(v);
+        return reply(c, r);
+    }
+    if (cmd == "clear") {
+        if (arb_.drop(d, c.name)) {
+            trace(c.name, "clear", d, nullptr, "");
+            update(d, c.name);
+        }
+        return handle(c, "get");
+    }
+
+    QosRequest r;
+    r.client = c.name;
+    for (std::string kv; is >> kv;) {
+        const auto eq = kv.find('=');
+        const std::string k = kv.substr(0, eq);
+        long long v = 0;
+        if (eq == std::string::npos || !parse_ll(kv.substr(eq + 1), v) || v < 0)
+            return reply(c, "err bad field: " + kv);
+        if (k == "min") r.min = v;
+        else if (k == "max") r.max = v;
+        else if (k == "prio") r.priority = (int)v;
+        else if (k == "cap") r.cap = v != 0;
+        else return reply(c, "err unknown field: " + k);
+    }
+    if (r.cap && r.min > 0) return reply(c, "err a cap only sets max");
+    arb_.request(d, r);
+    trace(c.name, "set", d, &r, "");
+    update(d, c.name);
+    handle(c, "get");
+}
+
+void QosServer::local_set(QosDomain d, QosRequest r) {
+    const std::string client = r.client;
+    arb_.request(d, r);
+    trace(client, "set", d, &r, "local");
+    update(d, client);
+}
+
+void QosServer::local_release(const std::string& client, const std::string& note) {
+    for (int d = 0; d < kQosDomains; ++d) {
+        if (arb_.drop((QosDomain)d, client)) {
+            trace(client, "release", (QosDomain)d, nullptr, note);
+            update((QosDomain)d, client);
+        }
+    }
+}
+
+void QosServer::drop(Conn& c) {
+    end_latency(c);
+    for (int d = 0; d < kQosDomains; ++d) {
+        if (arb_.drop((QosDomain)d, c.name)) {
+            trace(c.name, "release", (QosDomain)d, nullptr, "disconnected");
+            update((QosDomain)d, c.name);
+        }
+    }
+    ::close(c.fd);
+    c.fd = -1;
+}
+
+void QosServer::poll(int timeout_ms) {
+    std::vector<pollfd> pfds;
+    pfds.push_back({lfd_, POLLIN, 0});
+    for (auto& c : conns_) pfds.push_back({c->fd, POLLIN, 0});
+    const size_t nconn = conns_.size();
+    for (auto& w : watches_) pfds.push_back({w.first, POLLIN, 0});
+    if (::poll(pfds.data(), pfds.size(), timeout_ms) <= 0) return;
+
+    for (size_t i = 0; i < watches_.size(); ++i) {
+        if (pfds[1 + nconn + i].revents) watches_[i].second();
+    }
+    for (size_t i = 1; i <= nconn; ++i) {
+        if (!pfds[i].revents) continue;
+        Conn& c = *conns_[i - 1];
+        char buf[1024];
+        ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            c.dead = true;
+            continue;
+        }
+        c.in.append(buf, (size_t)n);
+        for (size_t nl; !c.dead && (nl = c.in.find('\n')) != std::string::npos;) {
+            std::string line = trim(c.in.substr(0, nl));
+            c.in.erase(0, nl + 1);
+            if (!line.empty()) handle(c, line);
+        }
+        if (c.in.size() > 4096) c.dead = true;
+    }
+    for (auto& c : conns_) if (c->dead) drop(*c);
+    conns_.erase(std::remove_if(conns_.begin(), conns_.end(), [](const std::unique_ptr<Conn>& c) { return c->fd < 0; }),
+                 conns_.end());
+
+    if (pfds[0].revents) {
+        for (int fd; (fd = ::accept4(lfd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;) {
+            auto c = std::make_unique<Conn>();
+            c->fd = fd;
+            ucred cr{};
+            socklen_t len = sizeof(cr);
+            c->name = (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cr, &len) == 0) ? "pid" + std::to_string(cr.pid)
+                                                                                  : "fd" + std::to_string(fd);
+            if (on_event) on_event(c->name + " connected");
+            conns_.push_back(std::move(c));
+        }
+    }
+}
+
+void QosServer::close() {
+    for (auto& c : conns_) drop(*c);
+    conns_.clear();
+    if (lfd_ >= 0) {
+        ::close(lfd_);
+        ::unlink(path_.c_str());
+    }
+    lfd_ = -1;
+    tw_.close();
+    tracing_ = false;
+}
+
+// ---- QosClient ----
+bool QosClient::connect(const std::string& path, const std::string& name, std::string& err) {
+    close();
+    sockaddr_un a;
+    if (!make_addr(path, a, err)) return false;
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, (sockaddr*)&a, sizeof(a)) != 0) {
+        err = "Failed to connect: " + path + ": " + std::strerror(errno) + " (is dvfs_tool daemon running?)";
+        close();
+        return false;
+    }
+    std::string r;
+    return name.empty() || call("hello " + name, r, err);
+}
+
+void QosClient::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    in_.clear();
+}
+
+bool QosClient::read_line(std::string& line) {
+    for (;;) {
+        if (auto nl = in_.find('\n'); nl != std::string::npos) {
+            line = in_.substr(0, nl);
+            in_.erase(0, nl + 1);
+            return true;
+        }
+        char buf[1024];
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        in_.append(buf, (size_t)n);
+    }
+}
+
+bool QosClient::call(const std::string& cmd, std::string& reply, std::string& err, std::vector<std::string>* lines) {
+    if (fd_ < 0) {
+        err = "not connected";
+        return false;
+    }
+    const std::string out = cmd + "\n";
+    if (::send(fd_, out.data(), out.size(), MSG_NOSIGNAL) != (ssize_t)out.size()) {
+        err = std::string("send failed: ") + std::strerror(errno);
+        return false;
+    }
+    for (std::string line;;) {
+        if (!read_line(line)) {
+            err = "daemon closed the connection";
+            return false;
+        }
+        if (line.compare(0, 3, "ok ") == 0 || line == "ok") {
+            reply = line.size() > 3 ? line.substr(3) : "";
+            return true;
+        }
+        if (line.compare(0, 4, "err ") == 0) {
+            err = line.substr(4);
+            return false;
+        }
+        if (lines) lines->push_back(line);
+    }
+}
+
+bool parse_qos_reply(const std::string& reply, QosDomain d, QosRange& out) {
+    const std::string key = std::string(qos_domain_name(d)) + "=";
+    std::istringstream is(reply);
+    for (std::string tok; is >> tok;) {
+        if (tok.compare(0, key.size(), key) != 0) continue;
+        const auto colon = tok.find(':', key.size());
+        if (colon == std::string::npos) return false;
+        return parse_ll(tok.substr(key.size(), colon - key.size()), out.min) &&
+               parse_ll(tok.substr(colon + 1), out.max);
+    }
+    return false;
+}
+
+long long qos_in_force(long long v, const QosRange& r) {
+    if (r.max > 0 && v > r.max) v = r.max;
+    if (r.min > 0 && v < r.min) v = r.min;
+    return v;
+}
+
+} // namespace dvfs
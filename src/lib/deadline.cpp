@@ -0,0 +1,37 @@
+// deadline.cpp
+#include "dvfs/deadline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dvfs {
+
+FrameGovernor::FrameGovernor(std::vector<long long> opps, FrameGovParams p) : opps_(std::move(opps)), p_(p) {
+    if (opps_.empty()) opps_.push_back(1);
+    cur_ = opps_.size() - 1;
+}
+
+long long FrameGovernor::frame(long long opp, double busy_s) {
+    if (!(busy_s > 0) || opp <= 0) return opps_[cur_];
+    const double w = busy_s * (double)opp;
+    if (n_++ == 0) {
+        mean_ = w;
+        var_ = 0;
+    } else {
+        const double d = w - mean_;
+        mean_ += p_.alpha * d;
+        var_ = (1.0 - p_.alpha) * (var_ + p_.alpha * d * d);
+    }
+    pred_ = std::max(w, mean_ + p_.k_sd * std::sqrt(var_));
+    const double budget = p_.deadline_s * (1.0 - p_.margin);
+    cur_ = opps_.size() - 1;  // nothing fits: run flat out
+    for (size_t i = 0; i < opps_.size(); ++i) {
+        if (pred_ / (double)opps_[i] <= budget) {
+            cur_ = i;
+            break;
+        }
+    }
+    return opps_[cur_];
+}
+
+} // namespace dvfs
@@ -0,0 +1,270 @@
+// derive.cpp
+#include "dvfs/derive.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace dvfs {
+
+namespace {
+
+class DeriveParser {
+public:
+    DeriveParser(const std::string& src, const std::vector<std::string>& cols, DeriveExpr& out)
+        : s_(src), cols_(cols), out_(out) {}
+
+    bool parse(std::string& err) {
+        if (!expr()) { err = err_; return false; }
+        skip_ws();
+        if (pos_ != s_.size()) { err = "unexpected '" + s_.substr(pos_) + "'"; return false; }
+        return true;
+    }
+
+private:
+    void skip_ws() { while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t')) pos_++; }
+    bool eat(char c) {
+        skip_ws();
+        if (pos_ < s_.size() && s_[pos_] == c) { pos_++; return true; }
+        return false;
+    }
+    bool fail(const std::string& m) { if (err_.empty()) err_ = m; return false; }
+
+    void emit(DOp op, int pop, int push, int arg = 0, double k = 0.0) {
+        out_.code.push_back({op, arg, k});
+        depth_ += push - pop;
+        if (depth_ > out_.stack_max) out_.stack_max = depth_;
+    }
+
+    bool expr() {
+        if (!term()) return false;
+        for (;;) {
+            if (eat('+'))      { if (!term()) return false; emit(DOp::Add, 2, 1); }
+            else if (eat('-')) { if (!term()) return false; emit(DOp::Sub, 2, 1); }
+            else return true;
+        }
+    }
+    bool term() {
+        if (!unary()) return false;
+        for (;;) {
+            if (eat('*'))      { if (!unary()) return false; emit(DOp::Mul, 2, 1); }
+            else if (eat('/')) { if (!unary()) return false; emit(DOp::Div, 2, 1); }
+            else return true;
+        }
+    }
+    bool unary() {
+        if (eat('-')) { if (!unary()) return false; emit(DOp::Neg, 1, 1); return true; }
+        return primary();
+    }
+    bool number(double& v) {
+        skip_ws();
+        const char* b = s_.c_str() + pos_;
+        char* e = nullptr;
+        v = std::strtod(b, &e);
+        if (e == b) return false;
+        pos_ += (size_t)(e - b);
+        return true;
+    }
+    bool primary() {
+        skip_ws();
+        if (pos_ >= s_.size()) return fail("unexpected end of expression");
+        if (eat('(')) {
+            if (!expr()) return false;
+            return eat(')') ? true : fail("missing ')'");
+        }
+        char c = s_[pos_];
+        if ((c >= '0' && c <= '9') || c == '.') {
+            double v;
+            if (!number(v)) return fail("bad number");
+            emit(DOp::Const, 0, 1, 0, v);
+            return true;
+        }
+        if (!(std::isalpha((unsigned char)c) || c == '_')) return fail(std::string("unexpected '") + c + "'");
+        size_t b = pos_;
+        while (pos_ < s_.size() && (std::isalnum((unsigned char)s_[pos_]) || s_[pos_] == '_')) pos_++;
+        std::string id = s_.substr(b, pos_ - b);
+
+        if (!eat('(')) {
+            for (size_t i = 0; i < cols_.size(); ++i) {
+                if (cols_[i] == id) { emit(DOp::Col, 0, 1, (int)i); return true; }
+            }
+            return fail("unknown column '" + id + "'");
+        }
+        return call(id);
+    }
+    bool call(const std::string& fn) {
+        if (fn == "diff" || fn == "abs") {
+            if (!expr() || !eat(')')) return fail(fn + "(x) expects one argument");
+            if (fn == "abs") { emit(DOp::Abs, 1, 1); return true; }
+            emit(DOp::Diff, 1, 1, (int)out_.state.size());
+            out_.state.push_back(std::nan(""));
+            return true;
+        }
+        if (fn == "ewma") {
+            double a;
+            if (!expr() || !eat(',') || !number(a) || !eat(')')) return fail("ewma(x, alpha) expects a constant alpha");
+            if (!(a > 0.0 && a <= 1.0)) return fail("ewma alpha must be in (0, 1]");
+            emit(DOp::Ewma, 1, 1, (int)out_.state.size(), a);
+            out_.state.push_back(std::nan(""));
+            return true;
+        }
+        if (fn == "min" || fn == "max") {
+            if (!expr() || !eat(',') || !expr() || !eat(')')) return fail(fn + "(a, b) expects two arguments");
+            emit(fn == "min" ? DOp::Min : DOp::Max, 2, 1);
+            return true;
+        }
+        if (fn == "clamp") {
+            if (!expr() || !eat(',') || !expr() || !eat(',') || !expr() || !eat(')'))
+                return fail("clamp(x, lo, hi) expects three arguments");
+            emit(DOp::Clamp, 3, 1);
+            return true;
+        }
+        return fail("unknown function '" + fn + "'");
+    }
+
+    const std::string& s_;
+    const std::vector<std::string>& cols_;
+    DeriveExpr& out_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    std::string err_;
+};
+
+} // namespace
+
+bool compile_derive(const std::string& spec, const std::vector<std::string>& cols,
+                           DeriveExpr& out, std::string& err) {
+    auto eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) { err = "expected name=expr"; return false; }
+    out = DeriveExpr{};
+    out.name = spec.substr(0, eq);
+    while (!out.name.empty() && out.name.back() == ' ') out.name.pop_back();
+    while (!out.name.empty() && out.name.front() == ' ') out.name.erase(0, 1);
+    // Same identifier rule as column references, so later expressions can use it.
+    bool ident = !out.name.empty() && (std::isalpha((unsigned char)out.name[0]) || out.name[0] == '_');
+    for (char c : out.name) ident = ident && (std::isalnum((unsigned char)c) || c == '_');
+    if (!ident) {
+        err = "expected name=expr, name matching [A-Za-z_][A-Za-z0-9_]* (got '" + out.name + "')";
+        return false;
+    }
+    for (auto& c : cols) {
+        if (c == out.name) { err = "column '" + out.name + "' already exists"; return false; }
+    }
+    std::string body = spec.substr(eq + 1);
+    DeriveParser p(body, cols, out);
+    if (!p.parse(err)) return false;
+    out.stack.assign((size_t)out.stack_max * kDeriveBatch, 0.0);
+    return true;
+}
+
+void eval_derive(DeriveExpr& d, const double* const* cols, size_t n, double* out) {
+    double* st = d.stack.data();
+    int sp = 0;   // number of live stack slots
+    auto slot = [&](int i) { return st + (size_t)i * kDeriveBatch; };
+
+    for (const DInsn& in : d.code) {
+        switch (in.op) {
+        case DOp::Col: {
+            std::memcpy(slot(sp), cols[in.arg], n * sizeof(double));
+            sp++;
+            break;
+        }
+        case DOp::Const: {
+            double* r = slot(sp);
+            for (size_t i = 0; i < n; ++i) r[i] = in.k;
+            sp++;
+            break;
+        }
+        case DOp::Add: { double* a = slot(sp - 2); const double* b = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] += b[i]; sp--; break; }
+        case DOp::Sub: { double* a = slot(sp - 2); const double* b = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] -= b[i]; sp--; break; }
+        case DOp::Mul: { double* a = slot(sp - 2); const double* b = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] *= b[i]; sp--; break; }
+        case DOp::Div: { double* a = slot(sp - 2); const double* b = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] /= b[i]; sp--; break; }
+        case DOp::Neg: { double* a = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] = -a[i]; break; }
+        case DOp::Abs: { double* a = slot(sp - 1); for (size_t i = 0; i < n; ++i) a[i] = std::fabs(a[i]); break; }
+        case DOp::Min: case DOp::Max: {
+            double* a = slot(sp - 2); const double* b = slot(sp - 1);
+            const bool mn = in.op == DOp::Min;
+            for (size_t i = 0; i < n; ++i) {
+                if (std::isnan(a[i]) || std::isnan(b[i])) a[i] = std::nan("");
+                else a[i] = mn ? std::min(a[i], b[i]) : std::max(a[i], b[i]);
+            }
+            sp--;
+            break;
+        }
+        case DOp::Clamp: {
+            double* x = slot(sp - 3); const double* lo = slot(sp - 2); const double* hi = slot(sp - 1);
+            for (size_t i = 0; i < n; ++i) {
+                double v = x[i];
+                if (v < lo[i]) v = lo[i];
+                if (v > hi[i]) v = hi[i];
+                x[i] = v;
+            }
+            sp -= 2;
+            break;
+        }
+        case DOp::Diff: {
+            double* a = slot(sp - 1);
+            double prev = d.state[in.arg];
+            for (size_t i = 0; i < n; ++i) {
+                double cur = a[i];
+                a[i] = cur - prev;   // NaN on first row / after a gap
+                prev = cur;
+            }
+            d.state[in.arg] = prev;
+            break;
+        }
+        case DOp::Ewma: {
+            double* a = slot(sp - 1);
+            double acc = d.state[in.arg];
+            for (size_t i = 0; i < n; ++i) {
+                double x = a[i];
+                if (!std::isnan(x)) acc = std::isnan(acc) ? x : acc + in.k * (x - acc);
+                a[i] = acc;
+            }
+            d.state[in.arg] = acc;
+            break;
+        }
+        }
+    }
+    std::memcpy(out, slot(0), n * sizeof(double));
+}
+
+bool DeriveSet::add(const std::string& spec, std::string& err) {
+    DeriveExpr d;
+    if (!compile_derive(spec, names_, d, err)) return false;
+    names_.push_back(d.name);
+    exprs_.push_back(std::move(d));
+    outs_.emplace_back(kDeriveBatch, 0.0);
+    return true;
+}
+
+void DeriveSet::eval(const double* const* base, size_t n) {
+    ptrs_.assign(base, base + nbase_);
+    for (size_t i = 0; i < exprs_.size(); ++i) {
+        eval_derive(exprs_[i], ptrs_.data(), n, outs_[i].data());
+        ptrs_.push_back(outs_[i].data());
+    }
+}
+
+std::vector<bool> DeriveSet::base_refs() const {
+    std::vector<bool> used(nbase_, false);
+    for (auto& d : exprs_)
+        for (auto& in : d.code)
+            if (in.op == DOp::Col && (size_t)in.arg < nbase_) used[in.arg] = true;
+    return used;
+}
+
+bool build_derive_set(DeriveSet& ds, const std::vector<std::string>& specs, std::string& err) {
+    for (auto& spec : specs) {
+        std::string e;
+        if (!ds.add(spec, e)) {
+            err = "'" + spec + "': " + e;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace dvfs
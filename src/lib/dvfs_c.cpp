@@ -0,0 +1,272 @@
+// dvfs_c.cpp
+// C ABI over Sampler: a background thread samples into a fixed ring that
+// readers copy out of under a mutex (copies are a few hundred bytes per row).
+// No exception crosses the C boundary: every entry point (and the sampling
+// thread) catches and reports DVFS_E_INTERNAL.
+#include "dvfs/dvfs_c.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dvfs/sensors.hpp"
+#include "dvfs/sysfs.hpp"
+#include "dvfs/util.hpp"
+
+using namespace dvfs;
+
+struct dvfs_sampler {
+    Sampler smp;
+    int period_ms = 100;
+    size_t ncols = 0;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    bool running = false;
+    bool stop = false;
+    std::thread thr;
+
+    // ring: row r lives at slot (r - 1) % DVFS_RING_ROWS
+    std::vector<double> vals;
+    std::vector<int64_t> ts;
+    std::vector<int64_t> dt;
+    uint64_t seq = 0;
+    std::vector<std::string> text;
+
+    std::deque<dvfs_marker> markers;
+};
+
+namespace {
+
+thread_local std::string t_err;
+
+int fail(int code, std::string msg) {
+    t_err = std::move(msg);
+    return code;
+}
+
+// Runs an entry point body; exceptions become DVFS_E_INTERNAL.
+template <typename F>
+auto guarded(F&& f, decltype(f()) on_error) noexcept -> decltype(f()) {
+    try {
+        return f();
+    } catch (const std::exception& e) {
+        try { t_err = std::string("internal error: ") + e.what(); } catch (...) { t_err.clear(); }
+    } catch (...) {
+        try { t_err = "internal error"; } catch (...) { t_err.clear(); }
+    }
+    return on_error;
+}
+
+void run_loop(dvfs_sampler* h) {
+    Sample s;
+    h->smp.prepare(s);
+    auto next = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lk(h->mu);
+    while (!h->stop) {
+        next += std::chrono::milliseconds(h->period_ms);
+        lk.unlock();
+        h->smp.sample(s);
+        lk.lock();
+        const size_t slot = (size_t)(h->seq % DVFS_RING_ROWS);
+        std::copy(s.num.begin(), s.num.end(), h->vals.begin() + slot * h->ncols);
+        h->ts[slot] = s.ts_ns;
+        h->dt[slot] = s.dt_ns;
+        h->text = s.text;
+        h->seq++;
+        // Oversampling slots between ticks (see Sampler::wait_until), stop-aware.
+        const int slots = h->smp.oversample_slots();
+        const auto period = std::chrono::milliseconds(h->period_ms);
+        for (int j = 1; j < slots; ++j) {
+            if (h->cv.wait_until(lk, next - period + period * j / slots, [h] { return h->stop; })) break;
+            lk.unlock();
+            h->smp.subsample(j);
+            lk.lock();
+        }
+        h->cv.wait_until(lk, next, [h] { return h->stop; });
+    }
+}
+
+// Sampling thread: an exception ends sampling (readers see no new rows)
+// rather than terminating the host process.
+void run(dvfs_sampler* h) noexcept {
+    try {
+        run_loop(h);
+    } catch (...) {
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int dvfs_abi_version(void) { return DVFS_C_ABI_VERSION; }
+
+const char* dvfs_last_error(void) { return t_err.c_str(); }
+
+dvfs_sampler* dvfs_sampler_create(const char* sensor_config, int period_ms) {
+    return guarded([&]() -> dvfs_sampler* {
+        std::vector<SensorSpec> specs;
+        std::string err;
+        if (sensor_config) {
+            auto text = read_file(sensor_config);
+            if (!text) {
+                fail(DVFS_E_OPEN, std::string("Failed to open: ") + sensor_config);
+                return nullptr;
+            }
+            if (!parse_sensor_config(*text, sensor_config, specs, err)) {
+                fail(DVFS_E_ARG, err);
+                return nullptr;
+            }
+        } else if (!parse_sensor_config(kDefaultSensors, "<builtin>", specs, err)) {
+            fail(DVFS_E_ARG, err);
+            return nullptr;
+        }
+        if (period_ms <= 0) period_ms = 100;
+
+        auto h = std::make_unique<dvfs_sampler>();
+        if (!h->smp.init(std::move(specs), {}, {}, period_ms, err)) {
+            fail(DVFS_E_DISCOVER, err);
+            return nullptr;
+        }
+        h->period_ms = period_ms;
+        h->ncols = h->smp.columns().size();
+        h->vals.assign(h->ncols * DVFS_RING_ROWS, 0.0);
+        h->ts.assign(DVFS_RING_ROWS, 0);
+        h->dt.assign(DVFS_RING_ROWS, 0);
+        return h.release();
+    }, nullptr);
+}
+
+void dvfs_sampler_destroy(dvfs_sampler* h) {
+    if (!h) return;
+    dvfs_sampler_stop(h);
+    guarded([&] { delete h; return 0; }, 0);
+}
+
+int dvfs_sampler_ncols(const dvfs_sampler* h) {
+    if (!h) return fail(DVFS_E_ARG, "null handle");
+    return (int)h->ncols;
+}
+
+const char* dvfs_sampler_column(const dvfs_sampler* h, int col) {
+    if (!h || col < 0 || (size_t)col >= h->ncols) return nullptr;
+    return h->smp.columns()[(size_t)col].c_str();
+}
+
+int dvfs_sampler_column_index(const dvfs_sampler* h, const char* name) {
+    return guarded([&] {
+        if (!h || !name) return fail(DVFS_E_ARG, "null argument");
+        int c = h->smp.column(name);
+        return (c < 0) ? fail(DVFS_E_ARG, std::string("no such column: ") + name) : c;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_start(dvfs_sampler* h) {
+    return guarded([&] {
+        if (!h) return fail(DVFS_E_ARG, "null handle");
+        std::lock_guard<std::mutex> lk(h->mu);
+        if (h->running) return fail(DVFS_E_ARG, "sampler already running");
+        h->stop = false;
+        h->thr = std::thread(run, h);
+        h->running = true;
+        return (int)DVFS_OK;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_stop(dvfs_sampler* h) {
+    return guarded([&] {
+        if (!h) return fail(DVFS_E_ARG, "null handle");
+        {
+            std::lock_guard<std::mutex> lk(h->mu);
+            if (!h->running) return (int)DVFS_OK;
+            h->stop = true;
+        }
+        h->cv.notify_all();
+        h->thr.join();
+        std::lock_guard<std::mutex> lk(h->mu);
+        h->running = false;
+        return (int)DVFS_OK;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_latest(dvfs_sampler* h, dvfs_sample* out) {
+    return guarded([&] {
+        if (!h || !out || out->struct_size < sizeof(dvfs_sample) || (out->capacity && !out->values))
+            return fail(DVFS_E_ARG, "bad argument");
+        std::lock_guard<std::mutex> lk(h->mu);
+        out->ncols = (uint32_t)h->ncols;
+        if (h->seq == 0) return fail(DVFS_E_NODATA, "no sample yet");
+        const size_t slot = (size_t)((h->seq - 1) % DVFS_RING_ROWS);
+        const size_t n = std::min<size_t>(h->ncols, out->capacity);
+        std::memcpy(out->values, &h->vals[slot * h->ncols], n * sizeof(double));
+        out->seq = h->seq;
+        out->ts_ns = h->ts[slot];
+        out->dt_ns = h->dt[slot];
+        return (int)DVFS_OK;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_read(dvfs_sampler* h, uint64_t* seq, int64_t* ts_ns, double* values, int max_rows) {
+    return guarded([&] {
+        if (!h || !seq || !values || max_rows < 0) return fail(DVFS_E_ARG, "bad argument");
+        std::lock_guard<std::mutex> lk(h->mu);
+        uint64_t from = std::max<uint64_t>(*seq, h->seq > DVFS_RING_ROWS ? h->seq - DVFS_RING_ROWS : 0);
+        int n = 0;
+        for (; from < h->seq && n < max_rows; ++from, ++n) {
+            const size_t slot = (size_t)(from % DVFS_RING_ROWS);
+            std::memcpy(values + (size_t)n * h->ncols, &h->vals[slot * h->ncols], h->ncols * sizeof(double));
+            if (ts_ns) ts_ns[n] = h->ts[slot];
+        }
+        *seq = from;
+        return n;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_text(dvfs_sampler* h, int col, char* buf, size_t len) {
+    return guarded([&] {
+        if (!h || !buf || len == 0 || col < 0) return fail(DVFS_E_ARG, "bad argument");
+        std::lock_guard<std::mutex> lk(h->mu);
+        if ((size_t)col >= h->text.size()) return fail(DVFS_E_ARG, "not a text column");
+        const std::string& t = h->text[(size_t)col];
+        const size_t n = std::min(t.size(), len - 1);
+        std::memcpy(buf, t.data(), n);
+        buf[n] = '\0';
+        return (int)n;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_mark(dvfs_sampler* h, const char* label) {
+    return guarded([&] {
+        if (!h || !label) return fail(DVFS_E_ARG, "bad argument");
+        dvfs_marker m{};
+        m.struct_size = sizeof(dvfs_marker);
+        m.ts_ns = now_ns();
+        std::strncpy(m.label, label, sizeof(m.label) - 1);
+        std::lock_guard<std::mutex> lk(h->mu);
+        m.seq = h->seq;
+        h->markers.push_back(m);
+        return (int)DVFS_OK;
+    }, DVFS_E_INTERNAL);
+}
+
+int dvfs_sampler_next_marker(dvfs_sampler* h, dvfs_marker* out) {
+    return guarded([&] {
+        if (!h || !out || out->struct_size < sizeof(dvfs_marker)) return fail(DVFS_E_ARG, "bad argument");
+        std::lock_guard<std::mutex> lk(h->mu);
+        if (h->markers.empty()) return 0;
+        *out = h->markers.front();
+        h->markers.pop_front();
+        return 1;
+    }, DVFS_E_INTERNAL);
+}
+
+} // extern "C"
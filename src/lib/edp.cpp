@@ -0,0 +1,165 @@
+// edp.cpp
+#include "dvfs/edp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace dvfs {
+
+namespace {
+
+size_t first_stride(size_t n) { return std::max<size_t>(1, n / 4); }
+
+// Index of the highest OPP <= v (the lowest if none is); i when v is 0.
+size_t snap(const std::vector<long long>& opps, size_t i, long long v) {
+    if (opps.empty() || v <= 0) return i;
+    const auto it = std::upper_bound(opps.begin(), opps.end(), v);
+    return it == opps.begin() ? 0 : (size_t)(it - opps.begin()) - 1;
+}
+
+} // namespace
+
+bool parse_edp_metric(const std::string& s, int& exponent) {
+    if (s == "edp") exponent = 1;
+    else if (s == "ed2p") exponent = 2;
+    else return false;
+    return true;
+}
+
+EdpClimber::EdpClimber(std::vector<long long> cpu_opps, std::vector<long long> gpu_opps, EdpParams p)
+    : cpu_(std::move(cpu_opps)), gpu_(std::move(gpu_opps)), p_(p), last_(std::nan("")) {
+    // Start at the top: full speed is the safe default for progress.
+    ci_ = cpu_.empty() ? 0 : cpu_.size() - 1;
+    gi_ = gpu_.empty() ? 0 : gpu_.size() - 1;
+    explore(true);
+    skip_ = p_.settle;
+}
+
+double EdpClimber::cost(double mj, double s, double work) const {
+    if (!(work > 0.0)) return INFINITY;  // no progress at all: worst
+    return (mj / work) * std::pow(s / work, (double)p_.exponent);
+}
+
+void EdpClimber::explore(bool reset_strides) {
+    settled_ = false;
+    cost_.clear();
+    centre_ = {ci_, gi_};
+    if (reset_strides) {
+        cs_ = first_stride(cpu_.size());
+        gs_ = first_stride(gpu_.size());
+    }
+    off_ = 0;
+}
+
+bool EdpClimber::move_to(const Point& p) {
+    if (p == Point{ci_, gi_}) return false;
+    ci_ = p.first;
+    gi_ = p.second;
+    skip_ = p_.settle;
+    return true;
+}
+
+bool EdpClimber::next_probe() {
+    const auto down = [](size_t i, size_t s) { return i >= s ? i - s : 0; };
+    const auto up = [](size_t i, size_t s, size_t n) { return std::min(i + s, n - 1); };
+    std::vector<Point> cand;
+    // Lower first: a cheaper-and-slower point is the usual win for batch work.
+    if (!cpu_.empty()) cand.push_back({down(centre_.first, cs_), centre_.second});
+    if (!gpu_.empty()) cand.push_back({centre_.first, down(centre_.second, gs_)});
+    if (!cpu_.empty()) cand.push_back({up(centre_.first, cs_, cpu_.size()), centre_.second});
+    if (!gpu_.empty()) cand.push_back({centre_.first, up(centre_.second, gs_, gpu_.size())});
+    for (auto& c : cand) {
+        if (c != centre_ && !cost_.count(c)) return move_to(c);
+    }
+    return false;
+}
+
+bool EdpClimber::step(double mj, double s, double work, std::string& note) {
+    if (!(s > 0.0) || !(mj >= 0.0)) return false;
+    if (skip_ > 0) {
+        skip_--;
+        last_ = std::nan("");
+        return false;
+    }
+    const double c = cost(mj, s, work);
+    last_ = c;
+    const Point cur{ci_, gi_};
+    char buf[200];
+
+    if (settled_) {
+        const double rate = work / s, mw = mj / s;
+        // Reference: mean of the first two settled windows, then fixed, so a
+        // slow ramp re-explores as well once it has moved far enough.
+        if (ref_n_ < 2) {
+            ref_n_++;
+            ref_rate_ += (rate - ref_rate_) / ref_n_;
+            ref_mw_ += (mw - ref_mw_) / ref_n_;
+            return false;
+        }
+        const bool off = std::fabs(rate / ref_rate_ - 1.0) > p_.phase || std::fabs(mw / ref_mw_ - 1.0) > p_.phase;
+        if (!off) {
+            off_ = 0;
+            return false;
+        }
+        if (++off_ < 2) return false;
+        std::snprintf(buf, sizeof(buf), "phase change: rate %.4g -> %.4g /s, %.0f -> %.0f mW; ", ref_rate_, rate,
+                      ref_mw_, mw);
+        note = buf;
+        explore(true);
+    } else {
+        note.clear();
+        auto ct = cost_.find(centre_);
+        if (cur != centre_ && ct != cost_.end() && c < ct->second * (1.0 - p_.margin)) centre_ = cur;
+    }
+    cost_[cur] = c;
+    return advance(c, note);
+}
+
+bool EdpClimber::clipped(long long cpu_khz, long long gpu_hz, std::string& note) {
+    const Point cur{ci_, gi_};
+    const Point real{snap(cpu_, ci_, cpu_khz), snap(gpu_, gi_, gpu_hz)};
+    if (real == cur) return false;
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "cpu=%lld kHz gpu=%lld Hz clipped by the daemon; ", this->cpu_khz(),
+                  this->gpu_hz());
+    note = buf;
+    last_ = std::nan("");
+    if (!settled_ && cur != centre_) {
+        cost_[cur] = INFINITY;
+        return advance(INFINITY, note);
+    }
+    // The centre itself: restart around what actually runs, remembering
+    // that this point cannot.
+    explore(settled_);
+    cost_[cur] = INFINITY;
+    centre_ = real;
+    move_to(real);
+    std::snprintf(buf, sizeof(buf), "centre cpu=%lld kHz gpu=%lld Hz", this->cpu_khz(), this->gpu_hz());
+    note += buf;
+    return true;
+}
+
+bool EdpClimber::advance(double c, std::string& note) {
+    char buf[200];
+    for (;;) {
+        if (next_probe()) {
+            std::snprintf(buf, sizeof(buf), "probe cpu=%lld kHz gpu=%lld Hz (cost here %.4g)", cpu_khz(), gpu_hz(), c);
+            note += buf;
+            return true;
+        }
+        if (cs_ == 1 && gs_ == 1) break;
+        cs_ = std::max<size_t>(1, cs_ / 2);
+        gs_ = std::max<size_t>(1, gs_ / 2);
+    }
+    settled_ = true;
+    ref_n_ = 0;
+    ref_rate_ = ref_mw_ = 0.0;
+    move_to(centre_);
+    std::snprintf(buf, sizeof(buf), "settled cpu=%lld kHz gpu=%lld Hz (cost %.4g, %zu points)", cpu_khz(), gpu_hz(),
+                  cost_[centre_], cost_.size());
+    note += buf;
+    return true;
+}
+
+} // namespace dvfs
@@ -0,0 +1,80 @@
+// filter.cpp
+#include "dvfs/filter.hpp"
+
+#include <algorithm>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+bool parse_filter(const std::string& spec, const std::vector<std::string>& cols,
+                  SensorFilter& f, std::string& err) {
+    auto colon = spec.find(':');
+    if (colon == std::string::npos) { err = "expected <col>:<stage>[+<stage>...]"; return false; }
+    f.col = trim(spec.substr(0, colon));
+    auto it = std::find(cols.begin(), cols.end(), f.col);
+    if (it == cols.end()) { err = "unknown column '" + f.col + "'"; return false; }
+    f.col_idx = (int)(it - cols.begin());
+
+    std::string rest = spec.substr(colon + 1);
+    size_t b = 0;
+    while (b <= rest.size()) {
+        size_t e = rest.find('+', b);
+        if (e == std::string::npos) e = rest.size();
+        std::string st = trim(rest.substr(b, e - b));
+        b = e + 1;
+        if (st.empty()) { err = "empty stage"; return false; }
+
+        std::string name = st, args;
+        auto lp = st.find('(');
+        if (lp != std::string::npos) {
+            if (st.back() != ')') { err = "missing ')' in '" + st + "'"; return false; }
+            name = trim(st.substr(0, lp));
+            args = st.substr(lp + 1, st.size() - lp - 2);
+        }
+        std::vector<double> av;
+        for (auto& a : split_top(args)) {
+            double v = parse_num(a.data(), a.data() + a.size());
+            if (std::isnan(v)) { err = "bad argument '" + a + "' in '" + st + "'"; return false; }
+            av.push_back(v);
+        }
+
+        FilterStage s{};
+        if (name == "median") {
+            s.kind = FStage::Median;
+            s.n = av.empty() ? 5 : (int)av[0];
+            if (s.n < 1 || s.n > kMedianMax || (s.n % 2) == 0) { err = "median window must be odd and <= 9"; return false; }
+        } else if (name == "ewma") {
+            s.kind = FStage::Ewma;
+            s.a = av.empty() ? 0.2 : av[0];
+            if (!(s.a > 0.0 && s.a <= 1.0)) { err = "ewma alpha must be in (0, 1]"; return false; }
+        } else if (name == "kalman") {
+            s.kind = FStage::Kalman;
+            if (av.size() != 2 || !(av[0] >= 0.0) || !(av[1] > 0.0)) { err = "kalman(q, r) needs q >= 0, r > 0"; return false; }
+            s.a = av[0];
+            s.r = av[1];
+        } else {
+            err = "unknown stage '" + name + "'";
+            return false;
+        }
+        f.stages.push_back(s);
+        if (e == rest.size()) break;
+    }
+    return true;
+}
+
+bool build_filters(std::vector<SensorFilter>& out, const std::vector<std::string>& cols,
+                   const std::vector<std::string>& specs, std::string& err) {
+    for (auto& spec : specs) {
+        SensorFilter f;
+        std::string e;
+        if (!parse_filter(spec, cols, f, e)) {
+            err = "'" + spec + "': " + e;
+            return false;
+        }
+        out.push_back(std::move(f));
+    }
+    return true;
+}
+
+} // namespace dvfs
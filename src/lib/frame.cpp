@@ -0,0 +1,192 @@
+// frame.cpp
+#include "dvfs/frame.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "dvfs/util.hpp"
+
+namespace fs = std::filesystem;
+
+namespace dvfs {
+
+bool Frame::load(const std::string& path, std::string& err) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) { err = "failed to open " + path; return false; }
+    std::error_code ec;
+    const size_t size = (size_t)fs::file_size(path, ec);
+    if (ec) { err = "cannot stat " + path; return false; }
+    text_ = arena_.alloc<char>(size + 1);
+    ifs.read(text_, (std::streamsize)size);
+    text_[size] = '\n';
+    end_ = text_ + size + 1;
+
+    // Header
+    const char* p = text_;
+    const char* eol = std::find(p, (const char*)end_, '\n');
+    const char* f = p;
+    for (const char* q = p; q <= eol; ++q) {
+        if (q == eol || *q == ',') {
+            const char* e = q;
+            if (e > f && e[-1] == '\r') e--;
+            names_.emplace_back(f, e);
+            f = q + 1;
+        }
+    }
+    cols_.assign(names_.size(), nullptr);
+
+    // Row index: offset of each non-empty line.
+    std::vector<uint64_t> offs;
+    for (p = eol + 1; p < end_; ) {
+        const char* e = std::find(p, (const char*)end_, '\n');
+        if (e > p && !(e == p + 1 && *p == '\r')) offs.push_back((uint64_t)(p - text_));
+        p = e + 1;
+    }
+    nrows_ = offs.size();
+    rows_ = arena_.alloc<uint64_t>(nrows_ ? nrows_ : 1);
+    std::copy(offs.begin(), offs.end(), rows_);
+    return true;
+}
+
+const FrameCol* Frame::col(const std::string& name) {
+    int i = index(name);
+    if (i < 0) return nullptr;
+    if (!cols_[i]) cols_[i] = parse_col((size_t)i);
+    return cols_[i];
+}
+
+const FrameCol* Frame::add_f64(const std::string& name, double*& data) {
+    data = arena_.alloc<double>(nrows_ ? nrows_ : 1);
+    names_.push_back(name);
+    owned_.push_back(std::make_unique<FrameCol>());
+    FrameCol* c = owned_.back().get();
+    c->name = name;
+    c->type = ColType::F64;
+    c->data = data;
+    cols_.push_back(c);
+    return c;
+}
+
+void Frame::field(size_t r, size_t c, const char*& b, const char*& e) const {
+    const char* p = text_ + rows_[r];
+    for (size_t k = 0; k < c; ++k) {
+        while (*p != ',' && *p != '\n') p++;
+        if (*p == '\n') { b = e = p; return; }
+        p++;
+    }
+    b = p;
+    while (*p != ',' && *p != '\n') p++;
+    e = (p > b && p[-1] == '\r') ? p - 1 : p;
+}
+
+FrameCol* Frame::parse_col(size_t c) {
+    owned_.push_back(std::make_unique<FrameCol>());
+    FrameCol* col = owned_.back().get();
+    col->name = names_[c];
+
+    // Pass 1: infer the narrowest type.
+    bool all_int = true, fits32 = true, all_num = true;
+    for (size_t r = 0; r < nrows_ && all_num; ++r) {
+        const char *b, *e;
+        field(r, c, b, e);
+        if (b == e) continue;
+        int64_t iv;
+        auto ri = std::from_chars(b, e, iv);
+        if (ri.ec == std::errc() && ri.ptr == e) {
+            if (iv <= INT32_MIN || iv > INT32_MAX) fits32 = false;
+            continue;
+        }
+        all_int = false;
+        double dv;
+        auto rd = std::from_chars(b, e, dv);
+        if (rd.ec != std::errc() || rd.ptr != e) all_num = false;
+    }
+    col->type = !all_num ? ColType::Dict : !all_int ? ColType::F64 : fits32 ? ColType::I32 : ColType::I64;
+
+    // Pass 2: fill.
+    const size_t n = nrows_ ? nrows_ : 1;
+    switch (col->type) {
+    case ColType::I32: {
+        auto* d = arena_.alloc<int32_t>(n);
+        for (size_t r = 0; r < nrows_; ++r) {
+            const char *b, *e; field(r, c, b, e);
+            int32_t v = kMissI32;
+            if (b != e) std::from_chars(b, e, v);
+            d[r] = v;
+        }
+        col->data = d;
+        break;
+    }
+    case ColType::I64: {
+        auto* d = arena_.alloc<int64_t>(n);
+        for (size_t r = 0; r < nrows_; ++r) {
+            const char *b, *e; field(r, c, b, e);
+            int64_t v = kMissI64;
+            if (b != e) std::from_chars(b, e, v);
+            d[r] = v;
+        }
+        col->data = d;
+        break;
+    }
+    case ColType::F64: {
+        auto* d = arena_.alloc<double>(n);
+        for (size_t r = 0; r < nrows_; ++r) {
+            const char *b, *e; field(r, c, b, e);
+            d[r] = parse_num(b, e);
+        }
+        col->data = d;
+        break;
+    }
+    case ColType::Dict: {
+        auto* d = arena_.alloc<int32_t>(n);
+        for (size_t r = 0; r < nrows_; ++r) {
+            const char *b, *e; field(r, c, b, e);
+            if (b == e) { d[r] = -1; continue; }
+            std::string s(b, e);
+            auto it = std::find(col->dict.begin(), col->dict.end(), s);
+            d[r] = (int32_t)(it - col->dict.begin());
+            if (it == col->dict.end()) col->dict.push_back(std::move(s));
+        }
+        col->data = d;
+        break;
+    }
+    }
+    return col;
+}
+
+bool parse_where(const std::string& spec, WherePred& w) {
+    static const std::pair<const char*, CmpOp> ops[] = {
+        {"<=", CmpOp::Le}, {">=", CmpOp::Ge}, {"==", CmpOp::Eq}, {"!=", CmpOp::Ne},
+        {"<", CmpOp::Lt},  {">", CmpOp::Gt},  {"=", CmpOp::Eq},
+    };
+    for (auto& [tok, op] : ops) {
+        auto p = spec.find(tok);
+        if (p == std::string::npos) continue;
+        w.col = trim(spec.substr(0, p));
+        w.op = op;
+        w.rhs = trim(spec.substr(p + std::strlen(tok)));
+        return !w.col.empty() && !w.rhs.empty();
+    }
+    return false;
+}
+
+bool parse_agg(const std::string& spec, AggSpec& a) {
+    a.label = spec;
+    if (spec == "count" || spec == "count()") { a.fn = AggFn::Count; return true; }
+    auto lp = spec.find('(');
+    if (lp == std::string::npos || spec.back() != ')') return false;
+    std::string fn = trim(spec.substr(0, lp));
+    a.col = trim(spec.substr(lp + 1, spec.size() - lp - 2));
+    if      (fn == "count") a.fn = AggFn::Count;
+    else if (fn == "sum")   a.fn = AggFn::Sum;
+    else if (fn == "mean" || fn == "avg") a.fn = AggFn::Mean;
+    else if (fn == "min")   a.fn = AggFn::Min;
+    else if (fn == "max")   a.fn = AggFn::Max;
+    else return false;
+    return a.fn == AggFn::Count || !a.col.empty();
+}
+
+} // namespace dvfs
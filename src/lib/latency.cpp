@@ -0,0 +1,243 @@
+// latency.cpp
+#include "dvfs/latency.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+bool parse_cpu_list(const std::string& s, std::vector<int>& out) {
+    out.clear();
+    for (const auto& part : split_top(s)) {
+        if (part.empty()) continue;
+        char* end = nullptr;
+        const long a = std::strtol(part.c_str(), &end, 10);
+        long b = a;
+        if (*end == '-') b = std::strtol(end + 1, &end, 10);
+        if (*end != '\0' || a < 0 || b < a || b > 4095) return false;
+        for (long c = a; c <= b; ++c) out.push_back((int)c);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return !out.empty();
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string s;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!s.empty()) s += ' ';  // space: the list sits inside a CSV field
+        s += std::to_string(cpus[i]);
+        if (j > i) s += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return s;
+}
+
+std::vector<int> online_cpus(const std::string& cpu_root) {
+    std::vector<int> out;
+    auto t = read_text(cpu_root + "/online");
+    if (!t || !parse_cpu_list(*t, out)) out = {0};
+    return out;
+}
+
+std::vector<IdleState> idle_states(const std::string& cpu_root, int cpu) {
+    std::vector<IdleState> out;
+    const std::string base = cpu_root + "/cpu" + std::to_string(cpu) + "/cpuidle/state";
+    for (int k = 0;; ++k) {
+        const std::string d = base + std::to_string(k);
+        auto name = read_text(d + "/name");
+        if (!name) break;
+        auto lat = read_text(d + "/latency");
+        out.push_back({*name, lat ? std::atoi(lat->c_str()) : 0});
+    }
+    return out;
+}
+
+std::vector<long long> idle_time_us(const std::string& cpu_root, const std::vector<int>& cpus, size_t nstates) {
+    std::vector<long long> out(nstates, 0);
+    for (int c : cpus) {
+        const std::string base = cpu_root + "/cpu" + std::to_string(c) + "/cpuidle/state";
+        for (size_t k = 0; k < nstates; ++k) {
+            if (auto t = read_text(base + std::to_string(k) + "/time")) out[k] += std::atoll(t->c_str());
+        }
+    }
+    return out;
+}
+
+// ---- LatencyQos ----
+bool LatencyQos::request(const std::string& client, int us, std::vector<int> cpus, std::string& err) {
+    if (us < 0) {
+        err = "latency must be >= 0 us";
+        return false;
+    }
+    reqs_[client] = Req{us, std::move(cpus)};
+    return apply(err);
+}
+
+bool LatencyQos::drop(const std::string& client, std::string& err) {
+    if (!reqs_.erase(client)) return false;
+    apply(err);
+    return true;
+}
+
+void LatencyQos::release_all() {
+    reqs_.clear();
+    std::string err;
+    apply(err);
+}
+
+bool LatencyQos::apply(std::string& err) {
+    int global = -1;
+    std::map<int, int> cpu;
+    for (auto& [client, r] : reqs_) {
+        if (r.cpus.empty()) global = (global < 0) ? r.us : std::min(global, r.us);
+        for (int c : r.cpus) {
+            auto it = cpu.find(c);
+            if (it == cpu.end() || r.us < it->second) cpu[c] = r.us;
+        }
+    }
+    bool ok = true;
+
+    // Global: the request lives as long as the fd; a new value replaces it.
+    if (global != global_ && !dry_) {
+        if (global < 0) {
+            if (dma_fd_ >= 0) ::close(dma_fd_);
+            dma_fd_ = -1;
+        } else {
+            if (dma_fd_ < 0) dma_fd_ = ::open(dma_dev_.c_str(), O_WRONLY | O_CLOEXEC);
+            const int32_t v = global;
+            if (dma_fd_ < 0 || ::write(dma_fd_, &v, sizeof(v)) != (ssize_t)sizeof(v)) {
+                err = "Failed to write: " + dma_dev_ + ": " + std::strerror(errno);
+                ok = false;
+            }
+        }
+    }
+    global_ = global;
+
+    // Per CPU: save the original on first write, restore when uncovered.
+    for (auto& [c, us] : cpu) {
+        auto it = cpu_.find(c);
+        if (it != cpu_.end() && it->second == us) continue;
+        const std::string p = cpu_root_ + "/cpu" + std::to_string(c) + "/power/pm_qos_resume_latency_us";
+        if (!dry_) {
+            if (!saved_.count(c)) saved_[c] = read_text(p).value_or("0");
+            if (!write_text(p, us == 0 ? "n/a" : std::to_string(us))) {
+                err = "Failed to write: " + p;
+                ok = false;
+            }
+        }
+    }
+    for (auto& [c, us] : cpu_) {
+        if (cpu.count(c)) continue;
+        auto s = saved_.find(c);
+        if (s == saved_.end()) continue;
+        write_text(cpu_root_ + "/cpu" + std::to_string(c) + "/power/pm_qos_resume_latency_us", s->second);
+        saved_.erase(s);
+    }
+    cpu_ = std::move(cpu);
+    return ok;
+}
+
+// ---- PhaseMeter ----
+PhaseMeter::PhaseMeter(std::string cpu_root) : root_(std::move(cpu_root)) {
+    cpus_ = online_cpus(root_);
+    states_ = idle_states(root_, cpus_.front());
+    base_idle_.assign(states_.size(), 0.0);
+}
+
+bool PhaseMeter::open(const std::string& path) {
+    if (!w_.open(path)) return false;
+    w_.append(std::string("start_ns,end_ns,client,label,latency_us,cpus,dur_ms,mean_mw,baseline_mw,extra_mj,"
+                          "deep_idle_pct,baseline_deep_idle_pct\n"));
+    w_.flush();
+    logging_ = true;
+    return true;
+}
+
+void PhaseMeter::tick(int64_t ts_ns, double mw, bool held) {
+    auto idle = idle_time_us(root_, cpus_, states_.size());
+    if (last_ts_ > 0 && ts_ns > last_ts_) {
+        const double dt = (double)(ts_ns - last_ts_) * 1e-9;
+        const bool have_mw = std::isfinite(mw);
+        for (auto& [client, w] : open_) {
+            if (!have_mw) continue;
+            w.e_mws += mw * dt;
+            w.p_s += dt;
+        }
+        if (!held) {
+            const double k = std::exp(-dt / 30.0);
+            if (have_mw) {
+                base_e_ = base_e_ * k + mw * dt;
+                base_p_ = base_p_ * k + dt;
+            }
+            base_wall_us_ = base_wall_us_ * k + dt * 1e6;
+            for (size_t s = 0; s < states_.size(); ++s) base_idle_[s] = base_idle_[s] * k + (double)(idle[s] - last_idle_[s]);
+        }
+    }
+    last_ts_ = ts_ns;
+    last_idle_ = std::move(idle);
+}
+
+void PhaseMeter::begin(const std::string& client, const std::string& label, int us, const std::vector<int>& cpus) {
+    Window w;
+    w.label = label;
+    w.us = us;
+    w.cpus = cpus;
+    w.t0 = now_ns();
+    w.idle0 = idle_time_us(root_, cpus.empty() ? cpus_ : cpus, states_.size());
+    open_[client] = std::move(w);
+}
+
+// Share (%) of wall_us x cpus spent in states deeper than us.
+double PhaseMeter::deep_share(const std::vector<long long>& d, int us, double wall_us) const {
+    if (wall_us <= 0 || states_.empty()) return std::nan("");
+    double deep = 0.0;
+    for (size_t s = 0; s < states_.size(); ++s) if (states_[s].latency_us > us) deep += (double)d[s];
+    return 100.0 * deep / wall_us;
+}
+
+std::string PhaseMeter::end(const std::string& client) {
+    auto it = open_.find(client);
+    if (it == open_.end()) return "";
+    Window w = std::move(it->second);
+    open_.erase(it);
+    const int64_t t1 = now_ns();
+    const double dur_s = (double)(t1 - w.t0) * 1e-9;
+    const auto& cpus = w.cpus.empty() ? cpus_ : w.cpus;
+    const auto idle1 = idle_time_us(root_, cpus, states_.size());
+    std::vector<long long> d(states_.size());
+    for (size_t s = 0; s < d.size(); ++s) d[s] = idle1[s] - w.idle0[s];
+    std::vector<long long> bd(states_.size());
+    for (size_t s = 0; s < bd.size(); ++s) bd[s] = (long long)base_idle_[s];
+
+    const double mean = w.p_s > 0 ? w.e_mws / w.p_s : std::nan("");
+    const double base = base_p_ > 0 ? base_e_ / base_p_ : std::nan("");
+    std::string line = std::to_string(w.t0) + "," + std::to_string(t1) + "," + client + "," + w.label + "," +
+                       std::to_string(w.us) + "," + (w.cpus.empty() ? "all" : format_cpu_list(w.cpus)) + ",";
+    append_num(line, std::round(dur_s * 1e4) / 10.0);
+    for (double v : {mean, base, (mean - base) * dur_s, deep_share(d, w.us, dur_s * 1e6 * (double)cpus.size()),
+                     deep_share(bd, w.us, base_wall_us_ * (double)cpus_.size())}) {
+        line.push_back(',');
+        append_num(line, std::round(v * 10.0) / 10.0 + 0.0);  // no "-0"
+    }
+    line.push_back('\n');
+    if (logging_) {
+        w_.append(line);
+        w_.flush();
+    }
+    return line;
+}
+
+} // namespace dvfs
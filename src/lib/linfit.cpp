@@ -0,0 +1,169 @@
+// linfit.cpp
+#include "dvfs/linfit.hpp"
+
+#include <cmath>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+bool parse_fit_formula(const std::string& spec, std::string& y, std::vector<std::string>& xs) {
+    const auto tilde = spec.find('~');
+    if (tilde == std::string::npos) return false;
+    y = trim(spec.substr(0, tilde));
+    xs.clear();
+    std::string rest = spec.substr(tilde + 1);
+    for (size_t b = 0;;) {
+        const auto e = rest.find('+', b);
+        const std::string t = trim(rest.substr(b, e == std::string::npos ? std::string::npos : e - b));
+        if (t.empty()) return false;
+        xs.push_back(t);
+        if (e == std::string::npos) break;
+        b = e + 1;
+    }
+    return !y.empty();
+}
+
+bool fit_linear(const std::vector<const double*>& x, const double* y, size_t nrows,
+                LinFit& out, std::string& err) {
+    const size_t k = x.size();
+    std::vector<size_t> rows;
+    for (size_t r = 0; r < nrows; ++r) {
+        bool ok = std::isfinite(y[r]);
+        for (size_t j = 0; j < k && ok; ++j) ok = std::isfinite(x[j][r]);
+        if (ok) rows.push_back(r);
+    }
+    const size_t n = rows.size();
+    if (n < k + 2) {
+        err = "need at least " + std::to_string(k + 2) + " complete rows, have " + std::to_string(n);
+        return false;
+    }
+
+    // Centre and scale each regressor.
+    out = LinFit{};
+    out.n = n;
+    out.mean.assign(k, 0.0);
+    std::vector<double> sd(k, 0.0);
+    for (size_t r : rows) out.y_mean += y[r];
+    out.y_mean /= (double)n;
+    for (size_t j = 0; j < k; ++j) {
+        for (size_t r : rows) out.mean[j] += x[j][r];
+        out.mean[j] /= (double)n;
+        for (size_t r : rows) sd[j] += (x[j][r] - out.mean[j]) * (x[j][r] - out.mean[j]);
+        sd[j] = std::sqrt(sd[j] / (double)n);
+        if (!(sd[j] > 0.0)) {
+            err = "regressor " + std::to_string(j + 1) + " is constant over the fitted rows";
+            return false;
+        }
+    }
+
+    // Normal equations Z'Z b = Z'(y - mean y), as an augmented k x (k+1) matrix.
+    std::vector<double> a(k * (k + 1), 0.0);
+    std::vector<double> z(k);
+    for (size_t r : rows) {
+        for (size_t j = 0; j < k; ++j) z[j] = (x[j][r] - out.mean[j]) / sd[j];
+        const double dy = y[r] - out.y_mean;
+        for (size_t i = 0; i < k; ++i) {
+            for (size_t j = 0; j < k; ++j) a[i * (k + 1) + j] += z[i] * z[j];
+            a[i * (k + 1) + k] += z[i] * dy;
+        }
+    }
+    // Gaussian elimination with partial pivoting. Z'Z has n on its diagonal,
+    // so a pivot this small relative to n means the terms are collinear.
+    for (size_t c = 0; c < k; ++c) {
+        size_t p = c;
+        for (size_t i = c + 1; i < k; ++i)
+            if (std::fabs(a[i * (k + 1) + c]) > std::fabs(a[p * (k + 1) + c])) p = i;
+        if (!(std::fabs(a[p * (k + 1) + c]) > 1e-9 * (double)n)) {
+            err = "regressors are collinear";
+            return false;
+        }
+        if (p != c)
+            for (size_t j = 0; j <= k; ++j) std::swap(a[c * (k + 1) + j], a[p * (k + 1) + j]);
+        for (size_t i = 0; i < k; ++i) {
+            if (i == c) continue;
+            const double f = a[i * (k + 1) + c] / a[c * (k + 1) + c];
+            for (size_t j = c; j <= k; ++j) a[i * (k + 1) + j] -= f * a[c * (k + 1) + j];
+        }
+    }
+
+    out.coef.assign(k + 1, 0.0);
+    out.coef[0] = out.y_mean;
+    for (size_t j = 0; j < k; ++j) {
+        out.coef[j + 1] = a[j * (k + 1) + k] / a[j * (k + 1) + j] / sd[j];
+        out.coef[0] -= out.coef[j + 1] * out.mean[j];
+    }
+
+    double sse = 0.0, sst = 0.0;
+    for (size_t r : rows) {
+        double pred = out.coef[0];
+        for (size_t j = 0; j < k; ++j) pred += out.coef[j + 1] * x[j][r];
+        sse += (y[r] - pred) * (y[r] - pred);
+        sst += (y[r] - out.y_mean) * (y[r] - out.y_mean);
+    }
+    out.r2 = (sst > 0.0) ? 1.0 - sse / sst : 1.0;
+    out.rmse = std::sqrt(sse / (double)n);
+    return true;
+}
+
+namespace {
+
+// Sums over rows where both are present, with ref shifted by lag rows.
+struct PairAcc {
+    double n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+
+    double corr() const {
+        const double vx = n * sxx - sx * sx, vy = n * syy - sy * sy;
+        return (vx > 0 && vy > 0) ? (n * sxy - sx * sy) / std::sqrt(vx * vy) : 0.0;
+    }
+};
+
+template <class F>
+void for_pairs(const std::vector<double>& x, const std::vector<double>& ref, int lag, F&& f) {
+    for (size_t i = 0; i < x.size(); ++i) {
+        const long j = (long)i + lag;
+        if (j < 0 || (size_t)j >= ref.size() || std::isnan(x[i]) || std::isnan(ref[(size_t)j])) continue;
+        f(x[i], ref[(size_t)j]);
+    }
+}
+
+PairAcc acc_at(const std::vector<double>& x, const std::vector<double>& ref, int lag) {
+    PairAcc a;
+    for_pairs(x, ref, lag, [&](double xv, double yv) {
+        a.n++; a.sx += xv; a.sy += yv; a.sxx += xv * xv; a.syy += yv * yv; a.sxy += xv * yv;
+    });
+    return a;
+}
+
+} // namespace
+
+bool fit_gain_offset(const std::vector<double>& x, const std::vector<double>& ref, int max_lag,
+                     GainFit& out, std::string& err) {
+    out = GainFit{};
+    PairAcc best = acc_at(x, ref, 0);
+    for (int lag = -max_lag; lag <= max_lag; ++lag) {
+        PairAcc a = acc_at(x, ref, lag);
+        if (a.n >= 3 && a.corr() > best.corr()) { best = a; out.lag = lag; }
+    }
+    out.n = (size_t)best.n;
+    const double vx = best.n * best.sxx - best.sx * best.sx;
+    if (best.n < 3 || vx <= 0) {
+        err = "not enough varying samples";
+        return false;
+    }
+    out.gain = (best.n * best.sxy - best.sx * best.sy) / vx;
+    out.offset = (best.sy - out.gain * best.sx) / best.n;
+    const double r = best.corr();
+    out.r2 = r * r;
+    double se0 = 0, se1 = 0;
+    for_pairs(x, ref, out.lag, [&](double xv, double yv) {
+        const double d0 = yv - xv, d1 = yv - (out.gain * xv + out.offset);
+        se0 += d0 * d0;
+        se1 += d1 * d1;
+    });
+    out.rms_raw = std::sqrt(se0 / best.n);
+    out.rms_fit = std::sqrt(se1 / best.n);
+    return true;
+}
+
+} // namespace dvfs
@@ -0,0 +1,167 @@
+// markers.cpp
+#include "dvfs/markers.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+bool parse_marker_line(const std::string& line, int64_t now, Marker& out) {
+    std::string s = trim(line);
+    if (s.empty()) return false;
+    out.ts_ns = now;
+    const auto sp = s.find_first_of(" \t");
+    if (sp != std::string::npos && std::all_of(s.begin(), s.begin() + (long)sp, [](char c) { return c >= '0' && c <= '9'; })) {
+        out.ts_ns = std::strtoll(s.c_str(), nullptr, 10);
+        s = trim(s.substr(sp + 1));
+    }
+    // Labels end up in a CSV field.
+    std::replace(s.begin(), s.end(), ',', ';');
+    out.label = s;
+    return !s.empty();
+}
+
+bool load_markers(const std::string& path, std::vector<Marker>& out, std::string& err) {
+    auto text = read_file(path);
+    if (!text) {
+        err = "Failed to open: " + path;
+        return false;
+    }
+    size_t pos = text->find('\n');  // header
+    while (pos != std::string::npos && pos + 1 < text->size()) {
+        const size_t nl = text->find('\n', pos + 1);
+        const std::string line = text->substr(pos + 1, (nl == std::string::npos ? text->size() : nl) - pos - 1);
+        pos = nl;
+        const auto comma = line.find(',');
+        if (comma == std::string::npos) continue;
+        out.push_back({std::strtoll(line.c_str(), nullptr, 10), line.substr(comma + 1)});
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Marker& a, const Marker& b) { return a.ts_ns < b.ts_ns; });
+    return true;
+}
+
+std::vector<Span> marker_spans(const std::vector<Marker>& ms) {
+    std::vector<Span> out;
+    std::map<std::string, std::deque<int64_t>> open;
+    for (auto& m : ms) {
+        const auto colon = m.label.rfind(':');
+        if (colon == std::string::npos) continue;
+        const std::string name = m.label.substr(0, colon), tag = m.label.substr(colon + 1);
+        if (tag == "begin") {
+            open[name].push_back(m.ts_ns);
+        } else if (tag == "end") {
+            auto it = open.find(name);
+            if (it == open.end() || it->second.empty()) continue;
+            out.push_back({name, it->second.front(), m.ts_ns});
+            it->second.pop_front();
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Span& a, const Span& b) { return a.t0 < b.t0; });
+    return out;
+}
+
+double energy_mj(const std::vector<int64_t>& ts, const std::vector<double>& mw, int64_t t0, int64_t t1) {
+    double e = 0.0;
+    size_t i = (size_t)(std::upper_bound(ts.begin(), ts.end(), t0) - ts.begin());
+    if (i > 0) i--;
+    for (; i + 1 < ts.size() && ts[i] < t1; ++i) {
+        if (std::isnan(mw[i])) continue;
+        const int64_t a = std::max(ts[i], t0), b = std::min(ts[i + 1], t1);
+        if (b > a) e += mw[i] * (double)(b - a) * 1e-9;
+    }
+    return e;
+}
+
+// ---- MarkerFifo ----
+bool MarkerFifo::start(const std::string& fifo, const std::string& out_path, std::string& err, bool queue) {
+    stop();
+    queue_ = queue;
+    struct stat st {};
+    if (::stat(fifo.c_str(), &st) != 0) {
+        if (::mkfifo(fifo.c_str(), 0666) != 0) {
+            err = "Failed to create fifo: " + fifo + ": " + std::strerror(errno);
+            return false;
+        }
+        ::chmod(fifo.c_str(), 0666);  // writable by the (unprivileged) workload
+    } else if (!S_ISFIFO(st.st_mode)) {
+        err = fifo + " exists and is not a fifo";
+        return false;
+    }
+    // O_RDWR keeps a writer open, so the FIFO never reads EOF between apps.
+    fd_ = ::open(fifo.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    out_ = ::open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0 || out_ < 0) {
+        err = "Failed to open: " + (fd_ < 0 ? fifo : out_path) + ": " + std::strerror(errno);
+        stop();
+        return false;
+    }
+    const char hdr[] = "ts_ns,label\n";
+    if (::write(out_, hdr, sizeof(hdr) - 1) < 0) {
+        err = "Failed to write: " + out_path;
+        stop();
+        return false;
+    }
+    stop_ = false;
+    thr_ = std::thread(&MarkerFifo::run, this);
+    return true;
+}
+
+void MarkerFifo::stop() {
+    stop_ = true;
+    if (thr_.joinable()) thr_.join();
+    if (fd_ >= 0) ::close(fd_);
+    if (out_ >= 0) ::close(out_);
+    fd_ = out_ = -1;
+}
+
+void MarkerFifo::take(std::vector<Marker>& out) {
+    std::lock_guard<std::mutex> lk(mu_);
+    out.insert(out.end(), std::make_move_iterator(q_.begin()), std::make_move_iterator(q_.end()));
+    q_.clear();
+}
+
+void MarkerFifo::run() {
+    std::string line, out;
+    char buf[4096];
+    while (!stop_) {
+        pollfd pfd{fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) <= 0) continue;
+        const ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n <= 0) continue;
+        const int64_t now = now_ns();
+        out.clear();
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buf[i] != '\n') {
+                if (line.size() < 256) line.push_back(buf[i]);
+                continue;
+            }
+            Marker m;
+            if (parse_marker_line(line, now, m)) {
+                out += std::to_string(m.ts_ns) + "," + m.label + "\n";
+                n_.fetch_add(1, std::memory_order_relaxed);
+                if (queue_) {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    q_.push_back(std::move(m));
+                }
+            }
+            line.clear();
+        }
+        if (!out.empty() && ::write(out_, out.data(), out.size()) < 0) break;
+    }
+}
+
+} // namespace dvfs
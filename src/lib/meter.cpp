@@ -0,0 +1,147 @@
+// meter.cpp
+#include "dvfs/meter.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+std::optional<double> parse_meter_line(const std::string& line) {
+    const char* p = line.c_str();
+    while (*p == ' ' || *p == '\t') p++;
+    char* end = nullptr;
+    const double v = std::strtod(p, &end);
+    if (end == p || !std::isfinite(v)) return std::nullopt;
+    while (*end == ' ' || *end == '\t') end++;
+    if (end[0] == 'm' && end[1] == 'W') return v;
+    return v * 1000.0;  // "W" or no unit
+}
+
+namespace {
+
+speed_t baud_const(int baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B115200;
+    }
+}
+
+void make_raw(int fd, int baud) {
+    termios tio{};
+    if (::tcgetattr(fd, &tio) != 0) return;
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    if (baud > 0) {
+        ::cfsetispeed(&tio, baud_const(baud));
+        ::cfsetospeed(&tio, baud_const(baud));
+    }
+    ::tcsetattr(fd, TCSANOW, &tio);
+}
+
+} // namespace
+
+int open_serial(const std::string& dev, int baud, std::string& err) {
+    int fd = ::open(dev.c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) {
+        err = "Failed to open: " + dev + ": " + std::strerror(errno);
+        return -1;
+    }
+    if (::isatty(fd)) make_raw(fd, baud);
+    return fd;
+}
+
+int open_pty(std::string& slave, std::string& err) {
+    int fd = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0 || ::grantpt(fd) != 0 || ::unlockpt(fd) != 0) {
+        err = std::string("Failed to create pty: ") + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    slave = ::ptsname(fd);
+    make_raw(fd, 0);
+    return fd;
+}
+
+bool SerialMeter::start(std::string& err) {
+    stop();
+    int baud = 115200;
+    dev_ = spec_;
+    if (auto at = spec_.rfind('@'); at != std::string::npos) {
+        dev_ = spec_.substr(0, at);
+        baud = std::atoi(spec_.c_str() + at + 1);
+    }
+    fd_ = open_serial(dev_, baud, err);
+    if (fd_ < 0) return false;
+    stop_ = false;
+    thr_ = std::thread(&SerialMeter::run, this);
+    return true;
+}
+
+void SerialMeter::stop() {
+    stop_ = true;
+    if (thr_.joinable()) thr_.join();
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+void SerialMeter::run() {
+    std::string line;
+    char buf[512];
+    while (!stop_) {
+        pollfd pfd{fd_, POLLIN, 0};
+        const int pr = ::poll(&pfd, 1, 100);
+        if (pr <= 0) continue;
+        ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n <= 0) {
+            // pty without a writer (EIO) or unplugged device: back off and retry.
+            if (n < 0 && errno == EINTR) continue;
+            ::usleep(100000);
+            continue;
+        }
+        const int64_t ts = now_ns();
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buf[i] != '\n' && buf[i] != '\r') {
+                if (line.size() < 256) line.push_back(buf[i]);
+                continue;
+            }
+            if (auto mw = parse_meter_line(line)) {
+                std::lock_guard<std::mutex> lk(mu_);
+                ts_[n_ % kRing] = ts;
+                mw_[n_ % kRing] = *mw;
+                n_++;
+            }
+            line.clear();
+        }
+    }
+}
+
+double SerialMeter::at(int64_t ts_ns) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (n_ == 0) return std::nan("");
+    const uint64_t lo = (n_ > kRing) ? n_ - kRing : 0;
+    uint64_t i = n_ - 1;
+    if (ts_ns >= ts_[i % kRing]) return (ts_ns - ts_[i % kRing] <= kStaleNs) ? mw_[i % kRing] : std::nan("");
+    while (i > lo && ts_[(i - 1) % kRing] > ts_ns) i--;
+    if (i == lo) return std::nan("");  // older than the ring
+    const size_t a = (i - 1) % kRing, b = i % kRing;
+    if (ts_[b] - ts_[a] > kStaleNs) return std::nan("");
+    const double f = (double)(ts_ns - ts_[a]) / (double)(ts_[b] - ts_[a]);
+    return mw_[a] + f * (mw_[b] - mw_[a]);
+}
+
+} // namespace dvfs
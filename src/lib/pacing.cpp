@@ -0,0 +1,118 @@
+// pacing.cpp
+#include "dvfs/pacing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace dvfs {
+
+namespace {
+
+// Least squares y = c0 + c1 x; false if x has no spread.
+bool fit_line(const std::vector<double>& x, const std::vector<double>& y, double& c0, double& c1) {
+    const double n = (double)x.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+    const double den = n * sxx - sx * sx;
+    if (x.size() < 2 || !(std::fabs(den) > 1e-12 * (sxx * n))) return false;
+    c1 = (n * sxy - sx * sy) / den;
+    c0 = (sy - c1 * sx) / n;
+    return true;
+}
+
+} // namespace
+
+bool pacing_analysis(const PacingInput& in, PacingResult& out, std::string& err) {
+    if (in.obs.empty()) {
+        err = "no spans to model";
+        return false;
+    }
+    if (!(in.period_s > 0)) {
+        err = "no period (need >= 2 spans or an explicit period)";
+        return false;
+    }
+    if (in.opps_khz.empty()) {
+        err = "empty OPP table";
+        return false;
+    }
+    out = PacingResult{};
+    const double fmax = (double)in.opps_khz.back();
+
+    // Group the spans by clock: mean busy time and power per frequency.
+    std::map<long long, std::pair<double, double>> sum;  // khz -> (busy, mw)
+    std::map<long long, int> cnt;
+    for (auto& o : in.obs) {
+        const long long k = std::llround(o.khz);
+        sum[k].first += o.busy_s;
+        sum[k].second += o.active_mw;
+        cnt[k]++;
+    }
+    std::vector<double> inv_f, busy, cube, mw;
+    for (auto& [k, s] : sum) {
+        inv_f.push_back(1.0 / (double)k);
+        busy.push_back(s.first / cnt[k]);
+        cube.push_back(std::pow((double)k / fmax, 3.0));
+        mw.push_back(s.second / cnt[k]);
+    }
+
+    // Time model. One clock: split by mem_frac (default all CPU-bound).
+    bool fitted = in.mem_frac < 0 && fit_line(inv_f, busy, out.a_s, out.b_s_khz);
+    if (fitted && (out.a_s < 0 || out.b_s_khz < 0)) fitted = false;  // noise; fall back
+    if (!fitted) {
+        const double beta = std::clamp(in.mem_frac < 0 ? 0.0 : in.mem_frac, 0.0, 1.0);
+        double t = 0, f = 0;
+        for (size_t i = 0; i < busy.size(); ++i) {
+            t += busy[i];
+            f += 1.0 / inv_f[i];
+        }
+        t /= (double)busy.size();
+        f /= (double)busy.size();
+        out.a_s = beta * t;
+        out.b_s_khz = (1.0 - beta) * t * f;
+    }
+
+    // Power model for clocks never observed.
+    if (!fit_line(cube, mw, out.p0_mw, out.p3_mw) || out.p3_mw < 0) {
+        double m = 0, c = 0;
+        for (size_t i = 0; i < mw.size(); ++i) {
+            m += mw[i];
+            c += cube[i];
+        }
+        m /= (double)mw.size();
+        c /= (double)mw.size();
+        out.p0_mw = std::min(in.idle_mw, m);
+        out.p3_mw = c > 0 ? (m - out.p0_mw) / c : 0.0;
+    }
+
+    const double T = in.period_s;
+    for (long long f : in.opps_khz) {
+        PacingRow r;
+        r.khz = f;
+        r.busy_s = out.a_s + out.b_s_khz / (double)f;
+        auto it = sum.find(f);
+        r.measured = it != sum.end();
+        r.active_mw = r.measured ? it->second.second / cnt[f] : out.p0_mw + out.p3_mw * std::pow((double)f / fmax, 3.0);
+        const double slack = T - r.busy_s;
+        r.feasible = slack >= 0;
+        r.busy_mj = r.active_mw * r.busy_s;
+        r.idle_mj = in.idle_mw * std::max(0.0, slack);
+        r.trans_mj = slack > in.transition_s ? std::max(0.0, r.active_mw - in.idle_mw) * in.transition_s : 0.0;
+        r.total_mj = r.busy_mj + r.idle_mj + r.trans_mj;
+        out.rows.push_back(r);
+    }
+    for (int i = 0; i < (int)out.rows.size(); ++i) {
+        if (!out.rows[i].feasible) continue;
+        if (out.paced < 0) out.paced = i;
+        out.race = i;
+        if (out.best < 0 || out.rows[i].total_mj < out.rows[out.best].total_mj) out.best = i;
+    }
+    return true;
+}
+
+} // namespace dvfs
@@ -0,0 +1,104 @@
+// power.cpp
+#include "dvfs/power.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace dvfs {
+
+std::optional<long long> parse_mw_field(const std::string& line, const std::string& key) {
+    // Example: " ... VDD_IN 21954mW/21896mW ..."
+    auto pos = line.find(key);
+    if (pos == std::string::npos) return std::nullopt;
+    pos += key.size();
+
+    // skip spaces
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
+
+    // parse digits
+    long long val = 0;
+    bool any = false;
+    while (pos < line.size() && (line[pos] >= '0' && line[pos] <= '9')) {
+        any = true;
+        val = val * 10 + (line[pos] - '0');
+        pos++;
+    }
+    if (!any) return std::nullopt;
+
+    // expect "mW"
+    if (pos + 1 >= line.size() || line[pos] != 'm' || line[pos+1] != 'W') return std::nullopt;
+    return val;
+}
+
+PowerReader::PowerReader(std::vector<std::string> keys)
+    : keys_(std::move(keys)), mw_(new std::atomic<long long>[keys_.size()]) {
+    for (size_t i = 0; i < keys_.size(); ++i) mw_[i].store(-1, std::memory_order_relaxed);
+}
+
+PowerReader::~PowerReader() { stop(); }
+
+bool PowerReader::start(int interval_ms) {
+    if (thr_.joinable()) return true;
+
+    // If dvfs_tool is run with sudo already, no need for "sudo" here.
+    // Otherwise tegrastats may require root on your system.
+    const std::string iv = std::to_string(std::max(interval_ms, kMinIntervalMs));
+    std::vector<std::string> args;
+    if (::geteuid() != 0) args.push_back("sudo");
+    args.insert(args.end(), {"tegrastats", "--interval", iv});
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(a.data());
+    argv.push_back(nullptr);
+
+    int pfd[2];
+    if (::pipe2(pfd, O_CLOEXEC) != 0) return false;
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_adddup2(&fa, pfd[1], STDOUT_FILENO);
+    int rc = ::posix_spawnp(&pid_, argv[0], &fa, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&fa);
+    ::close(pfd[1]);
+    if (rc != 0) {
+        ::close(pfd[0]);
+        pid_ = -1;
+        return false;
+    }
+
+    stop_ = false;
+    thr_ = std::thread([this, fd = pfd[0]]() {
+        FILE* fp = ::fdopen(fd, "r");
+        if (!fp) { ::close(fd); return; }
+
+        char buf[8192];
+        while (!stop_ && std::fgets(buf, sizeof(buf), fp)) {
+            std::string line(buf);
+            for (size_t i = 0; i < keys_.size(); ++i) {
+                if (auto v = parse_mw_field(line, keys_[i]); v) mw_[i].store(*v, std::memory_order_relaxed);
+            }
+        }
+        std::fclose(fp);
+    });
+    return true;
+}
+
+void PowerReader::stop() {
+    stop_ = true;
+    // Killing the child closes the pipe, which unblocks the reader thread.
+    if (pid_ > 0) ::kill(pid_, SIGTERM);
+    if (thr_.joinable()) thr_.join();
+    if (pid_ > 0) {
+        int st;
+        ::waitpid(pid_, &st, 0);
+        pid_ = -1;
+    }
+}
+
+} // namespace dvfs
@@ -0,0 +1,122 @@
+// procmon.cpp
+#include "dvfs/procmon.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+
+namespace dvfs {
+
+bool ProcConnector::open(std::string& err) {
+    close();
+    fd_ = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd_ < 0) {
+        err = std::string("netlink socket: ") + std::strerror(errno);
+        return false;
+    }
+    sockaddr_nl sa{};
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = CN_IDX_PROC;
+    sa.nl_pid = 0;  // kernel assigns
+    if (::bind(fd_, (sockaddr*)&sa, sizeof(sa)) != 0) {
+        err = std::string("netlink bind: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+    // Bigger buffer: exec storms (make -j) otherwise overflow it.
+    int rcv = 1 << 20;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcv, sizeof(rcv));
+
+    // nlmsghdr | cn_msg | proc_cn_mcast_op, packed back to back.
+    alignas(nlmsghdr) char msg[NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    auto* nl = (nlmsghdr*)msg;
+    nl->nlmsg_len = sizeof(msg);
+    nl->nlmsg_type = NLMSG_DONE;
+    auto* cn = (cn_msg*)NLMSG_DATA(nl);
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(proc_cn_mcast_op);
+    *(proc_cn_mcast_op*)cn->data = PROC_CN_MCAST_LISTEN;
+    if (::send(fd_, msg, sizeof(msg), 0) != (ssize_t)sizeof(msg)) {
+        err = std::string("proc connector subscribe: ") + std::strerror(errno) + " (needs root / CAP_NET_ADMIN)";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ProcConnector::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool ProcConnector::read(std::vector<ProcEvent>& out) {
+    alignas(nlmsghdr) char buf[8192];
+    for (;;) {
+        const ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno != ENOBUFS;
+        }
+        if (n == 0) return true;
+        int len = (int)n;
+        for (auto* nl = (nlmsghdr*)buf; NLMSG_OK(nl, len); nl = NLMSG_NEXT(nl, len)) {
+            if (nl->nlmsg_type == NLMSG_ERROR || nl->nlmsg_type == NLMSG_NOOP) continue;
+            const auto* cn = (const cn_msg*)NLMSG_DATA(nl);
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            const auto* ev = (const proc_event*)cn->data;
+            ProcEvent e;
+            e.ts_ns = (int64_t)ev->timestamp_ns;
+            if (ev->what == proc_event::PROC_EVENT_EXEC) {
+                e.kind = ProcEvent::Exec;
+                e.pid = ev->event_data.exec.process_pid;
+                e.tgid = ev->event_data.exec.process_tgid;
+            } else if (ev->what == proc_event::PROC_EVENT_EXIT) {
+                e.kind = ProcEvent::Exit;
+                e.pid = ev->event_data.exit.process_pid;
+                e.tgid = ev->event_data.exit.process_tgid;
+                if (e.pid != e.tgid) continue;
+            } else {
+                continue;
+            }
+            out.push_back(e);
+        }
+    }
+}
+
+std::string process_name(int pid) {
+    const std::string base = "/proc/" + std::to_string(pid);
+    char buf[4096];
+    const ssize_t n = ::readlink((base + "/exe").c_str(), buf, sizeof(buf) - 1);
+    if (n > 0) {
+        std::string p(buf, (size_t)n);
+        if (p.size() > 10 && p.compare(p.size() - 10, 10, " (deleted)") == 0) p.resize(p.size() - 10);
+        const auto slash = p.rfind('/');
+        return slash == std::string::npos ? p : p.substr(slash + 1);
+    }
+    return read_text(base + "/comm").value_or("");
+}
+
+std::vector<int> list_pids() {
+    std::vector<int> out;
+    DIR* d = ::opendir("/proc");
+    if (!d) return out;
+    while (dirent* e = ::readdir(d)) {
+        char* end = nullptr;
+        const long pid = std::strtol(e->d_name, &end, 10);
+        if (*end == '\0' && pid > 0) out.push_back((int)pid);
+    }
+    ::closedir(d);
+    return out;
+}
+
+} // namespace dvfs
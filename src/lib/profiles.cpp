@@ -0,0 +1,197 @@
+// profiles.cpp
+#include "dvfs/profiles.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+namespace {
+
+bool parse_ll(const std::string& s, long long& v) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size() && v >= 0;
+}
+
+bool alive(int pid) {
+    struct stat st {};
+    return ::stat(("/proc/" + std::to_string(pid)).c_str(), &st) == 0;
+}
+
+} // namespace
+
+bool parse_profiles(const std::string& text, const std::string& origin, std::vector<Profile>& out,
+                    std::string& err) {
+    std::istringstream is(text);
+    std::string line;
+    int lineno = 0;
+    while (std::getline(is, line)) {
+        lineno++;
+        auto toks = config_tokens(line);
+        if (toks.empty()) continue;
+        const std::string where = origin + ":" + std::to_string(lineno) + ": ";
+
+        Profile p;
+        for (auto& t : toks) {
+            auto eq = t.find('=');
+            if (eq == std::string::npos) { err = where + "expected key=value, got '" + t + "'"; return false; }
+            std::string k = t.substr(0, eq), v = t.substr(eq + 1);
+            long long n = 0;
+            if (k == "exe") p.exe = v;
+            else if (k == "cpu_min_khz" || k == "cpu_max_khz" || k == "gpu_min_hz" || k == "gpu_max_hz") {
+                if (!parse_ll(v, n)) { err = where + "bad " + k + " '" + v + "'"; return false; }
+                (k == "cpu_min_khz" ? p.cpu_min : k == "cpu_max_khz" ? p.cpu_max : k == "gpu_min_hz" ? p.gpu_min : p.gpu_max) = n;
+            }
+            else if (k == "prio") {
+                if (!parse_ll(v, n)) { err = where + "bad prio '" + v + "'"; return false; }
+                p.priority = (int)n;
+            }
+            else if (k == "cap") p.cap = (v == "1" || v == "true" || v == "yes");
+            else if (k == "uclamp_min" || k == "uclamp_max") {
+                if (!parse_uclamp_value(v, k == "uclamp_min" ? p.uclamp.min : p.uclamp.max)) {
+                    err = where + "bad " + k + " '" + v + "' (0..1024 or 0..100%)";
+                    return false;
+                }
+            }
+            else { err = where + "unknown key '" + k + "'"; return false; }
+        }
+        if (p.exe.empty() || p.exe.find_first_of("/,") != std::string::npos) {
+            err = where + "exe=<basename> is required";
+            return false;
+        }
+        if (p.cap && (p.cpu_min || p.gpu_min)) { err = where + "a cap only sets maxes"; return false; }
+        if (!p.cpu_min && !p.cpu_max && !p.gpu_min && !p.gpu_max && p.uclamp.min < 0 && p.uclamp.max < 0) {
+            err = where + "profile for '" + p.exe + "' sets nothing";
+            return false;
+        }
+        for (auto& o : out) {
+            if (o.exe == p.exe) { err = where + "duplicate profile '" + p.exe + "'"; return false; }
+        }
+        out.push_back(std::move(p));
+    }
+    return true;
+}
+
+// ---- ProfileAgent ----
+bool ProfileAgent::open_log(const std::string& path) {
+    if (!w_.open(path)) return false;
+    w_.append(std::string("ts_ns,pid,exe,event,latency_us,note\n"));
+    w_.flush();
+    logging_ = true;
+    return true;
+}
+
+bool ProfileAgent::start(std::string& err) {
+    if (!pc_.open(err)) return false;
+    srv_.watch(pc_.fd(), [this] { drain(); });
+    started_ = true;
+    rescan();
+    return true;
+}
+
+void ProfileAgent::stop() {
+    while (!active_.empty()) revert(active_.begin()->first, now_ns(), "stopped");
+    pc_.close();
+    w_.close();
+    logging_ = false;
+    started_ = false;
+}
+
+const Profile* ProfileAgent::match(const std::string& exe) const {
+    for (auto& p : profiles_) {
+        if (p.exe == exe) return &p;
+    }
+    return nullptr;
+}
+
+void ProfileAgent::drain() {
+    evs_.clear();
+    const bool complete = pc_.read(evs_);
+    for (auto& e : evs_) {
+        if (e.kind == ProcEvent::Exit) {
+            if (active_.count(e.tgid)) revert(e.tgid, e.ts_ns, "exit");
+            continue;
+        }
+        // exec replaces the image: whatever the old one had goes.
+        if (active_.count(e.tgid)) revert(e.tgid, e.ts_ns, "exec");
+        const std::string exe = process_name(e.tgid);
+        if (const Profile* p = match(exe)) apply(e.tgid, exe, *p, e.ts_ns);
+    }
+    if (!complete) rescan();
+}
+
+void ProfileAgent::rescan() {
+    std::vector<int> gone;
+    for (auto& [pid, a] : active_) {
+        if (!alive(pid)) gone.push_back(pid);
+    }
+    for (int pid : gone) revert(pid, now_ns(), "gone");
+    for (int pid : list_pids()) {
+        if (active_.count(pid)) continue;
+        const std::string exe = process_name(pid);
+        if (const Profile* p = match(exe)) apply(pid, exe, *p, now_ns());
+    }
+}
+
+void ProfileAgent::apply(int pid, const std::string& exe, const Profile& p, int64_t ts_ns) {
+    Active a;
+    a.prof = &p;
+    a.client = "profile:" + exe + ":" + std::to_string(pid);
+    const std::pair<QosDomain, std::pair<long long, long long>> doms[] = {
+        {QosDomain::Cpu, {p.cpu_min, p.cpu_max}}, {QosDomain::Gpu, {p.gpu_min, p.gpu_max}}};
+    for (auto& [d, mm] : doms) {
+        if (!mm.first && !mm.second) continue;
+        QosRequest r;
+        r.client = a.client;
+        r.priority = p.priority;
+        r.cap = p.cap;
+        r.min = mm.first;
+        r.max = mm.second;
+        srv_.local_set(d, r);
+    }
+    std::string note;
+    if ((p.uclamp.min >= 0 || p.uclamp.max >= 0) && !dry_) {
+        a.uc = std::make_unique<UclampActuator>();
+        std::string err;
+        if (!a.uc->clamp_process(pid, p.uclamp, err)) note = err;
+    }
+    active_[pid] = std::move(a);
+    log(ts_ns, pid, exe, "apply", note);
+}
+
+void ProfileAgent::revert(int pid, int64_t ts_ns, const char* note) {
+    auto it = active_.find(pid);
+    if (it == active_.end()) return;
+    Active a = std::move(it->second);
+    active_.erase(it);
+    srv_.local_release(a.client, note);
+    if (a.uc) a.uc->restore();  // threads that already exited are skipped
+    log(ts_ns, pid, a.prof->exe, "revert", note);
+}
+
+void ProfileAgent::log(int64_t ts_ns, int pid, const std::string& exe, const char* event, const std::string& note) {
+    const double us = (double)(now_ns() - ts_ns) * 1e-3;
+    if (on_event) {
+        std::string m = "profile " + std::string(event) + " " + exe + " pid " + std::to_string(pid) + " in ";
+        append_num(m, std::round(us * 10.0) / 10.0);
+        m += " us";
+        if (!note.empty()) m += " (" + note + ")";
+        on_event(m);
+    }
+    if (!logging_) return;
+    std::string line = std::to_string(ts_ns) + "," + std::to_string(pid) + "," + exe + "," + event + ",";
+    append_num(line, std::round(us * 10.0) / 10.0);
+    std::string n = note;
+    std::replace(n.begin(), n.end(), ',', ';');
+    line += "," + n + "\n";
+    w_.append(line);
+    w_.flush();
+}
+
+} // namespace dvfs
@@ -0,0 +1,81 @@
+// psi.cpp
+#include "dvfs/psi.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dvfs {
+
+namespace {
+
+// "total=<n>" on the line starting at p.
+int64_t line_total(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+    if (!eol) eol = end;
+    for (const char* q = p; q + 6 <= eol; ++q) {
+        if (std::memcmp(q, "total=", 6) != 0) continue;
+        int64_t v;
+        if (std::from_chars(q + 6, eol, v).ec != std::errc()) return -1;
+        return v;
+    }
+    return -1;
+}
+
+double pct(int64_t cur, int64_t prev, double dt_us) {
+    if (cur < 0 || prev < 0 || !(dt_us > 0)) return std::nan("");
+    return 100.0 * (double)(cur - prev) / dt_us;
+}
+
+} // namespace
+
+bool parse_psi(const char* buf, size_t n, PsiTotals& out) {
+    out = PsiTotals{};
+    const char* end = buf + n;
+    for (const char* p = buf; p < end;) {
+        if (end - p >= 5 && std::memcmp(p, "some ", 5) == 0) out.some_us = line_total(p, end);
+        else if (end - p >= 5 && std::memcmp(p, "full ", 5) == 0) out.full_us = line_total(p, end);
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        if (!eol) break;
+        p = eol + 1;
+    }
+    return out.some_us >= 0;
+}
+
+std::string psi_path(const std::string& s) {
+    if (s == "cpu" || s == "memory" || s == "io") return "/proc/pressure/" + s;
+    return s;
+}
+
+bool PsiRate::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    prev_ = PsiTotals{};
+    return fd_ >= 0;
+}
+
+void PsiRate::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool PsiRate::read(int64_t ts_ns, double& some_pct, double& full_pct) {
+    some_pct = full_pct = std::nan("");
+    char buf[256];
+    ssize_t n = (fd_ >= 0) ? ::pread(fd_, buf, sizeof(buf), 0) : -1;
+    if (n < 0 && fd_ >= 0 && errno == EAGAIN) n = ::pread(fd_, buf, sizeof(buf), 0);
+    PsiTotals t;
+    if (n <= 0 || !parse_psi(buf, (size_t)n, t)) return false;
+    const double dt_us = (double)(ts_ns - prev_ts_) / 1e3;
+    some_pct = pct(t.some_us, prev_.some_us, dt_us);
+    full_pct = pct(t.full_us, prev_.full_us, dt_us);
+    prev_ = t;
+    prev_ts_ = ts_ns;
+    return true;
+}
+
+} // namespace dvfs
@@ -0,0 +1,103 @@
+// qos.cpp
+#include "dvfs/qos.hpp"
+
+#include <algorithm>
+
+namespace dvfs {
+
+const char* qos_domain_name(QosDomain d) { return d == QosDomain::Cpu ? "cpu" : "gpu"; }
+
+bool parse_qos_domain(const std::string& s, QosDomain& out) {
+    if (s == "cpu") out = QosDomain::Cpu;
+    else if (s == "gpu") out = QosDomain::Gpu;
+    else return false;
+    return true;
+}
+
+void QosArbiter::set_limits(QosDomain d, long long lo, long long hi, std::vector<long long> opps) {
+    Domain& D = dom_[(int)d];
+    D.hw = {lo, std::max(lo, hi)};
+    D.opps = std::move(opps);
+}
+
+void QosArbiter::request(QosDomain d, QosRequest r) {
+    auto& reqs = dom_[(int)d].reqs;
+    r.seq = ++seq_;
+    for (auto& q : reqs) {
+        if (q.client == r.client) {
+            q = std::move(r);
+            return;
+        }
+    }
+    reqs.push_back(std::move(r));
+}
+
+bool QosArbiter::drop(QosDomain d, const std::string& client) {
+    auto& reqs = dom_[(int)d].reqs;
+    auto it = std::remove_if(reqs.begin(), reqs.end(), [&](const QosRequest& q) { return q.client == client; });
+    const bool found = it != reqs.end();
+    reqs.erase(it, reqs.end());
+    return found;
+}
+
+void QosArbiter::drop_client(const std::string& client) {
+    for (int d = 0; d < kQosDomains; ++d) drop((QosDomain)d, client);
+}
+
+QosResult QosArbiter::aggregate(QosDomain d) const {
+    const Domain& D = dom_[(int)d];
+    QosResult res;
+    long long lo = D.hw.min, hi = D.hw.max;
+
+    // Caps bound everything.
+    for (auto& q : D.reqs) {
+        if (q.cap && q.max > 0 && q.max < hi) hi = std::max(lo, q.max);
+    }
+
+    std::vector<const QosRequest*> order;
+    for (auto& q : D.reqs) if (!q.cap) order.push_back(&q);
+    std::stable_sort(order.begin(), order.end(), [](const QosRequest* a, const QosRequest* b) {
+        return a->priority > b->priority || (a->priority == b->priority && a->seq < b->seq);
+    });
+
+    for (size_t i = 0; i < order.size();) {
+        // One priority group: max of mins, min of maxes, max wins inside it.
+        size_t j = i;
+        long long gmin = lo, gmax = hi;
+        for (; j < order.size() && order[j]->priority == order[i]->priority; ++j) {
+            if (order[j]->min > 0) gmin = std::max(gmin, order[j]->min);
+            if (order[j]->max > 0) gmax = std::min(gmax, order[j]->max);
+        }
+        bool clip = false;
+        if (gmax < lo) { gmax = lo; clip = true; }
+        if (gmin > hi) { gmin = hi; clip = true; }
+        if (gmin > gmax) { gmin = gmax; clip = true; }
+        if (clip) {
+            for (size_t k = i; k < j; ++k) {
+                const QosRequest& q = *order[k];
+                if ((q.min > 0 && q.min > gmin) || (q.max > 0 && q.max < gmax)) res.clipped.push_back(q.client);
+            }
+        }
+        lo = gmin;
+        hi = gmax;
+        i = j;
+    }
+    // A floor above a cap was clamped to it; say who lost.
+    for (auto& q : D.reqs) {
+        if (!q.cap && q.min > hi && std::find(res.clipped.begin(), res.clipped.end(), q.client) == res.clipped.end())
+            res.clipped.push_back(q.client);
+    }
+
+    // Snap onto OPPs: min up, max down; max wins if they cross.
+    if (!D.opps.empty()) {
+        auto up = std::lower_bound(D.opps.begin(), D.opps.end(), lo);
+        auto dn = std::upper_bound(D.opps.begin(), D.opps.end(), hi);
+        lo = (up == D.opps.end()) ? D.opps.back() : *up;
+        hi = (dn == D.opps.begin()) ? D.opps.front() : *(dn - 1);
+        if (lo > hi) lo = hi;
+    }
+    res.range = {lo, hi};
+    return res;
+}
+
+} // namespace dvfs
@@ -0,0 +1,107 @@
+// rpm.cpp
+#include "dvfs/rpm.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+
+namespace dvfs {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// pread the attribute from its fd, or reopen by path when the fd is not
+// held (more devices than the fd limit allows).
+std::string read_attr(int fd, const std::string& path) {
+    if (fd < 0) return read_text(path).value_or("");
+    char buf[64];
+    ssize_t n = ::pread(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EAGAIN) n = ::pread(fd, buf, sizeof(buf), 0);
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ')) n--;
+    return (n > 0) ? std::string(buf, (size_t)n) : std::string();
+}
+
+long long read_ms(int fd, const std::string& path) {
+    const std::string s = read_attr(fd, path);
+    long long v;
+    if (s.empty() || std::from_chars(s.data(), s.data() + s.size(), v).ec != std::errc()) return -1;
+    return v;
+}
+
+} // namespace
+
+RpmScanner::~RpmScanner() {
+    for (auto& d : devs_) {
+        for (int fd : {d.fd_status, d.fd_active, d.fd_suspended}) if (fd >= 0) ::close(fd);
+    }
+}
+
+size_t RpmScanner::scan(const std::string& root) {
+    std::error_code ec;
+    // Symlinks (subsystem, driver, supplier links) are not followed, so
+    // every device is visited once.
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename() != "power" || it->is_symlink(ec)) continue;
+        it.disable_recursion_pending();
+        const std::string dir = it->path().string();
+        const auto status = read_text(dir + "/runtime_status");
+        if (!status || *status == "unsupported") continue;
+        Dev d;
+        d.dir = dir;
+        d.name = it->path().parent_path().lexically_relative(root).string();
+        d.fd_status = ::open((dir + "/runtime_status").c_str(), O_RDONLY | O_CLOEXEC);
+        d.fd_active = ::open((dir + "/runtime_active_time").c_str(), O_RDONLY | O_CLOEXEC);
+        d.fd_suspended = ::open((dir + "/runtime_suspended_time").c_str(), O_RDONLY | O_CLOEXEC);
+        d.active = read_ms(d.fd_active, dir + "/runtime_active_time");
+        d.suspended = read_ms(d.fd_suspended, dir + "/runtime_suspended_time");
+        devs_.push_back(std::move(d));
+    }
+    return devs_.size();
+}
+
+void RpmScanner::poll(std::vector<RpmDelta>& out) {
+    out.resize(devs_.size());
+    for (size_t i = 0; i < devs_.size(); ++i) {
+        Dev& d = devs_[i];
+        RpmDelta& r = out[i];
+        r.dev = d.name;
+        r.status = read_attr(d.fd_status, d.dir + "/runtime_status");
+        const long long a = read_ms(d.fd_active, d.dir + "/runtime_active_time");
+        const long long s = read_ms(d.fd_suspended, d.dir + "/runtime_suspended_time");
+        r.active_ms = (a >= 0 && d.active >= 0) ? (double)(a - d.active) : 0.0;
+        r.suspended_ms = (s >= 0 && d.suspended >= 0) ? (double)(s - d.suspended) : 0.0;
+        d.active = a;
+        d.suspended = s;
+    }
+    // Busiest first; among equals, devices that are active now first.
+    std::stable_sort(out.begin(), out.end(), [](const RpmDelta& x, const RpmDelta& y) {
+        if (x.active_ms != y.active_ms) return x.active_ms > y.active_ms;
+        return (x.status == "active") > (y.status == "active");
+    });
+}
+
+void append_rpm_rows(std::string& out, int64_t ts_ns, double interval_ms, const std::vector<RpmDelta>& d) {
+    char buf[160];
+    for (auto& r : d) {
+        if (r.active_ms <= 0 && r.status != "active") continue;
+        const double tot = r.active_ms + r.suspended_ms;
+        std::snprintf(buf, sizeof(buf), "%lld,%.0f,", (long long)ts_ns, interval_ms);
+        out += buf;
+        out += r.dev + "," + r.status;
+        std::snprintf(buf, sizeof(buf), ",%.0f,%.0f,%.1f\n", r.active_ms, r.suspended_ms,
+                      tot > 0 ? 100.0 * r.active_ms / tot : 0.0);
+        out += buf;
+    }
+}
+
+} // namespace dvfs
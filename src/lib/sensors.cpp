@@ -0,0 +1,620 @@
+// sensors.cpp
+#include "dvfs/sensors.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/topology.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+const char* const kDefaultSensors = R"(# dvfs_tool built-in sensor registry
+name=cpu_khz           type=sysfs      path=${cpufreq}/scaling_cur_freq  unit=kHz  watch=CPUfreq label=cur
+name=cpu_min_khz       type=sysfs      path=${cpufreq}/scaling_min_freq  unit=kHz  watch=CPUfreq label=min
+name=cpu_max_khz       type=sysfs      path=${cpufreq}/scaling_max_freq  unit=kHz  watch=CPUfreq label=max
+name=cpu_governor      type=sysfs      path=${cpufreq}/scaling_governor  unit=text watch=CPUfreq label=gov
+name=gpu_hz            type=sysfs      path=${gpu}/cur_freq              unit=Hz   watch=GPUfreq label=cur
+name=gpu_min_hz        type=sysfs      path=${gpu}/min_freq              unit=Hz   watch=GPUfreq label=min
+name=gpu_max_hz        type=sysfs      path=${gpu}/max_freq              unit=Hz   watch=GPUfreq label=max
+name=gpu_governor      type=sysfs      path=${gpu}/governor              unit=text watch=GPUfreq label=gov
+name=gpu_load          type=sysfs      path=/sys/devices/platform/gpu.0/load unit=permille watch=GPUfreq label=load optional=1
+name=gpu_rpm_status    type=sysfs      path=/sys/devices/platform/gpu.0/power/runtime_status unit=text watch=GPUfreq label=rpm optional=1
+name=gpu_active_ms     type=sysfs      path=/sys/devices/platform/gpu.0/power/runtime_active_time unit=ms optional=1
+name=gpu_suspended_ms  type=sysfs      path=/sys/devices/platform/gpu.0/power/runtime_suspended_time unit=ms optional=1
+name=fan_cur_state     type=sysfs      path=${fan}/cur_state             unit=state watch=FAN    label=cur_state optional=1
+name=fan_max_state     type=sysfs      path=${fan}/max_state             unit=state watch=FAN    label=max_state optional=1
+name=fan_pwm           type=sysfs      path=/sys/devices/platform/pwm-fan/hwmon/hwmon*/pwm1 unit=pwm watch=FAN label=pwm optional=1
+name=temp_cpu_mC       type=thermal    path=cpu-thermal,CPU-therm,cpu,CPU        unit=mC watch=Temps label=CPU
+name=temp_gpu_mC       type=thermal    path=gpu-thermal,GPU-therm,gpu,ga10b,GPU  unit=mC watch=Temps label=GPU
+name=temp_soc0_mC      type=thermal    path=soc0-thermal,SOC0,soc0               unit=mC watch=Temps label=SOC0
+name=temp_soc1_mC      type=thermal    path=soc1-thermal,SOC1,soc1               unit=mC watch=Temps label=SOC1
+name=temp_soc2_mC      type=thermal    path=soc2-thermal,SOC2,soc2               unit=mC watch=Temps label=SOC2
+name=temp_tj_mC        type=thermal    path=tj-thermal,TJ,tj                     unit=mC watch=Temps label=TJ
+name=vdd_in_mW         type=tegrastats path=VDD_IN          unit=mW watch=Power label=VDD_IN
+name=vdd_cpu_gpu_cv_mW type=tegrastats path=VDD_CPU_GPU_CV  unit=mW watch=Power label=VDD_CPU_GPU_CV
+name=vdd_soc_mW        type=tegrastats path=VDD_SOC         unit=mW watch=Power label=VDD_SOC
+name=psi_cpu_some_pct  type=psi        path=cpu,some    unit=% watch=PSI label=cpu optional=1
+name=psi_mem_some_pct  type=psi        path=memory,some unit=% watch=PSI label=mem optional=1
+name=psi_mem_full_pct  type=psi        path=memory,full unit=% watch=PSI label=mem_full optional=1
+name=psi_io_some_pct   type=psi        path=io,some     unit=% watch=PSI label=io optional=1
+name=psi_io_full_pct   type=psi        path=io,full     unit=% watch=PSI label=io_full optional=1
+name=gpu_gated_pct     type=derived    path=100*diff(gpu_suspended_ms)/(diff(gpu_active_ms)+diff(gpu_suspended_ms)) unit=%
+)";
+
+namespace {
+
+// Expand ${...} placeholders and '*' globs; nullopt if unresolvable.
+std::optional<std::string> resolve_sysfs_path(const Topology& topo, const std::string& pat) {
+    std::string p = pat;
+    const std::pair<const char*, const std::optional<std::string>*> vars[] = {
+        {"${cpufreq}", &topo.cpufreq}, {"${gpu}", &topo.gpu}, {"${fan}", &topo.fan},
+    };
+    for (auto& [var, val] : vars) {
+        for (auto pos = p.find(var); pos != std::string::npos; pos = p.find(var)) {
+            if (!*val) return std::nullopt;
+            p.replace(pos, std::strlen(var), **val);
+        }
+    }
+    if (p.find('*') != std::string::npos) {
+        glob_t g{};
+        std::optional<std::string> hit;
+        if (::glob(p.c_str(), 0, nullptr, &g) == 0 && g.gl_pathc > 0) hit = std::string(g.gl_pathv[0]);
+        ::globfree(&g);
+        return hit;
+    }
+    return exists(p) ? std::optional<std::string>(p) : std::nullopt;
+}
+
+bool perf_event_config(const std::string& ev, uint32_t& type, uint64_t& config) {
+    const std::tuple<const char*, uint32_t, uint64_t> table[] = {
+        {"cycles",           PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+        {"cache-misses",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"branches",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+        {"branch-misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"bus-cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES},
+        {"cpu-clock",        PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK},
+        {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        {"cpu-migrations",   PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+        {"page-faults",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    };
+    for (auto& [n, t, c] : table) {
+        if (ev == n) { type = t; config = c; return true; }
+    }
+    return false;
+}
+
+// One counter per online CPU (system-wide); empty on failure.
+std::vector<int> open_perf_counters(const std::string& ev) {
+    std::vector<int> fds;
+    perf_event_attr attr{};
+    uint32_t type;
+    uint64_t config;
+    if (!perf_event_config(ev, type, config)) return fds;
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    const long ncpu = ::sysconf(_SC_NPROCESSORS_ONLN);
+    for (long cpu = 0; cpu < ncpu; ++cpu) {
+        int fd = (int)::syscall(SYS_perf_event_open, &attr, -1, (int)cpu, -1, 0);
+        if (fd >= 0) fds.push_back(fd);
+    }
+    return fds;
+}
+
+uint64_t read_perf(int fd) {
+    uint64_t v = 0;
+    return (::read(fd, &v, sizeof(v)) == (ssize_t)sizeof(v)) ? v : 0;
+}
+
+int every_for(const SensorSpec& sp, int period_ms) {
+    return (sp.period_ms > period_ms) ? (sp.period_ms + period_ms / 2) / period_ms : 1;
+}
+
+bool parse_double(const std::string& v, double& out) {
+    const double d = parse_num(v.data(), v.data() + v.size());
+    if (std::isnan(d)) return false;
+    out = d;
+    return true;
+}
+
+} // namespace
+
+bool parse_sensor_config(const std::string& text, const std::string& origin,
+                         std::vector<SensorSpec>& out, std::string& err) {
+    std::istringstream is(text);
+    std::string line;
+    int lineno = 0;
+    while (std::getline(is, line)) {
+        lineno++;
+        auto toks = config_tokens(line);
+        if (toks.empty()) continue;
+        const std::string where = origin + ":" + std::to_string(lineno) + ": ";
+
+        SensorSpec sp;
+        bool have_type = false;
+        for (auto& t : toks) {
+            auto eq = t.find('=');
+            if (eq == std::string::npos) { err = where + "expected key=value, got '" + t + "'"; return false; }
+            std::string k = t.substr(0, eq), v = t.substr(eq + 1);
+            if (k == "name") sp.name = v;
+            else if (k == "type") {
+                have_type = true;
+                if      (v == "sysfs")      sp.type = SensorType::Sysfs;
+                else if (v == "thermal")    sp.type = SensorType::Thermal;
+                else if (v == "hwmon")      sp.type = SensorType::Hwmon;
+                else if (v == "tegrastats") sp.type = SensorType::Tegrastats;
+                else if (v == "perf")       sp.type = SensorType::Perf;
+                else if (v == "serial")     sp.type = SensorType::Serial;
+                else if (v == "psi")        sp.type = SensorType::Psi;
+                else if (v == "derived")    sp.type = SensorType::Derived;
+                else { err = where + "unknown type '" + v + "'"; return false; }
+            }
+            else if (k == "path") sp.path = v;
+            else if (k == "unit") sp.unit = v;
+            else if (k == "period_ms") {
+                auto r = std::from_chars(v.data(), v.data() + v.size(), sp.period_ms);
+                if (r.ec != std::errc() || sp.period_ms < 0) { err = where + "bad period_ms '" + v + "'"; return false; }
+            }
+            else if (k == "watch") sp.watch = v;
+            else if (k == "label") sp.label = v;
+            else if (k == "filter") sp.filter = v;
+            else if (k == "optional") sp.optional = (v == "1" || v == "true" || v == "yes");
+            else if (k == "oversample") {
+                auto r = std::from_chars(v.data(), v.data() + v.size(), sp.oversample);
+                if (r.ec != std::errc() || sp.oversample < 1 || sp.oversample > kMaxOversample) {
+                    err = where + "bad oversample '" + v + "' (1.." + std::to_string(kMaxOversample) + ")";
+                    return false;
+                }
+            }
+            else if (k == "gain" || k == "offset") {
+                double& d = (k == "gain") ? sp.gain : sp.offset;
+                if (!parse_double(v, d)) { err = where + "bad " + k + " '" + v + "'"; return false; }
+            }
+            else { err = where + "unknown key '" + k + "'"; return false; }
+        }
+        if (sp.name.empty() || !have_type || sp.path.empty()) {
+            err = where + "name, type and path are required";
+            return false;
+        }
+        if (sp.name == "ts_ns" || sp.name == "dt_ns") { err = where + "'" + sp.name + "' is reserved"; return false; }
+        for (auto& o : out) {
+            if (o.name == sp.name) { err = where + "duplicate sensor '" + sp.name + "'"; return false; }
+        }
+        if (sp.label.empty()) sp.label = sp.name;
+        out.push_back(std::move(sp));
+    }
+    return true;
+}
+
+bool parse_calibration(const std::string& text, const std::string& origin,
+                       std::vector<SensorCal>& out, std::string& err) {
+    std::istringstream is(text);
+    std::string line;
+    int lineno = 0;
+    while (std::getline(is, line)) {
+        lineno++;
+        auto toks = config_tokens(line);
+        if (toks.empty()) continue;
+        const std::string where = origin + ":" + std::to_string(lineno) + ": ";
+        SensorCal c;
+        for (auto& t : toks) {
+            auto eq = t.find('=');
+            if (eq == std::string::npos) { err = where + "expected key=value, got '" + t + "'"; return false; }
+            std::string k = t.substr(0, eq), v = t.substr(eq + 1);
+            if (k == "name") c.name = v;
+            else if (k == "gain" || k == "offset") {
+                if (!parse_double(v, k == "gain" ? c.gain : c.offset)) { err = where + "bad " + k + " '" + v + "'"; return false; }
+            }
+            else if (k == "r2" || k == "n" || k == "lag_rows" || k == "ref") continue;  // fit stats from calibrate
+            else { err = where + "unknown key '" + k + "'"; return false; }
+        }
+        if (c.name.empty()) { err = where + "name is required"; return false; }
+        out.push_back(std::move(c));
+    }
+    return true;
+}
+
+bool apply_calibration(std::vector<SensorSpec>& specs, const std::vector<SensorCal>& cals, std::string& err) {
+    for (auto& c : cals) {
+        auto it = std::find_if(specs.begin(), specs.end(), [&](const SensorSpec& s) { return s.name == c.name; });
+        if (it == specs.end() || it->type == SensorType::Derived) {
+            err = "calibration for unknown sensor '" + c.name + "'";
+            return false;
+        }
+        it->gain = c.gain;
+        it->offset = c.offset;
+    }
+    return true;
+}
+
+Sampler::Sampler() = default;
+
+Sampler::~Sampler() {
+    pool_.reset();
+    for (auto& s : sensors_) {
+        if (s.fd >= 0) ::close(s.fd);
+        for (int fd : s.perf_fds) ::close(fd);
+    }
+}
+
+bool Sampler::init(std::vector<SensorSpec> specs, const std::vector<std::string>& extra_filters,
+                   const std::vector<std::string>& extra_derives, int period_ms, std::string& err) {
+    const Topology topo = Topology::discover();
+    std::vector<std::string> tkeys;
+
+    for (auto& sp : specs) {
+        if (sp.type == SensorType::Derived) { derived_.push_back(sp); continue; }
+        Sensor s;
+        s.spec = sp;
+        s.fmt = (sp.unit == "text") ? SensorFmt::Text : SensorFmt::Int;
+        s.every = every_for(sp, period_ms);
+
+        std::optional<std::string> path;
+        switch (sp.type) {
+        case SensorType::Sysfs:
+            path = resolve_sysfs_path(topo, sp.path);
+            if (!path && !sp.optional) {
+                err = "sensor '" + sp.name + "': cannot resolve " + sp.path + ". Run: dvfs_tool probe";
+                return false;
+            }
+            break;
+        case SensorType::Thermal: {
+            std::vector<std::string> kws;
+            std::istringstream ks(sp.path);
+            for (std::string k; std::getline(ks, k, ',');) if (!k.empty()) kws.push_back(k);
+            if (auto tz = find_thermal_zone_by_keywords(kws)) path = *tz + "/temp";
+            break;
+        }
+        case SensorType::Hwmon:
+            path = find_hwmon_attr(sp.path);
+            break;
+        case SensorType::Tegrastats:
+            s.tstat = (int)tkeys.size();
+            tkeys.push_back(sp.path);
+            s.source = "tegrastats:" + sp.path;
+            break;
+        case SensorType::Perf:
+            s.perf_fds = open_perf_counters(sp.path);
+            for (int fd : s.perf_fds) s.perf_prev += read_perf(fd);
+            s.source = s.perf_fds.empty() ? "" : "perf:" + sp.path;
+            break;
+        case SensorType::Serial: {
+            auto m = std::make_unique<SerialMeter>(sp.path);
+            if (!m->start(err)) {
+                err = "sensor '" + sp.name + "': " + err;
+                return false;
+            }
+            s.meter = (int)meters_.size();
+            s.source = "serial:" + m->device();
+            s.fmt = SensorFmt::Real;
+            meters_.push_back(std::move(m));
+            break;
+        }
+        case SensorType::Psi: {
+            const auto comma = sp.path.rfind(',');
+            const std::string line = (comma == std::string::npos) ? "some" : sp.path.substr(comma + 1);
+            const std::string file = psi_path(sp.path.substr(0, comma));
+            if (line != "some" && line != "full") {
+                err = "sensor '" + sp.name + "': psi path must be <file>[,some|full]";
+                return false;
+            }
+            s.fmt = SensorFmt::Real;
+            s.psi_full = (line == "full");
+            s.psi = std::make_unique<PsiRate>();
+            if (s.psi->open(file)) s.source = "psi:" + file + "," + line;
+            else if (!sp.optional) {
+                err = "sensor '" + sp.name + "': cannot open " + file + " (kernel without CONFIG_PSI, or psi=0?)";
+                return false;
+            }
+            break;
+        }
+        case SensorType::Derived:
+            break;
+        }
+        s.cal = (sp.gain != 1.0 || sp.offset != 0.0);
+        s.over = sp.oversample;
+        if (s.over > 1 && (s.fmt == SensorFmt::Text || sp.type == SensorType::Perf)) {
+            err = "sensor '" + sp.name + "': oversample needs a numeric level sensor (not text / perf)";
+            return false;
+        }
+        if (path) {
+            s.source = *path;
+            s.fd = ::open(path->c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        s.col = (int)sensors_.size();
+        sensors_.push_back(std::move(s));
+    }
+
+    // Column namespace for filters / derives: numeric sensors by name.
+    for (auto& s : sensors_) names_.push_back(s.spec.name);
+    nsd_ = 0;
+    for (auto& s : sensors_) {
+        if (s.over <= 1) continue;
+        s.sd_col = (int)names_.size();
+        names_.push_back(s.spec.name + "_sd");
+        slots_ = std::max(slots_, s.over);
+        nsd_++;
+    }
+    std::vector<std::string> fspecs;
+    for (auto& s : sensors_) if (!s.spec.filter.empty()) fspecs.push_back(s.spec.name + ":" + s.spec.filter);
+    fspecs.insert(fspecs.end(), extra_filters.begin(), extra_filters.end());
+    if (!build_filters(filters_, names_, fspecs, err)) { err = "bad filter " + err; return false; }
+    for (auto& f : filters_) {
+        if ((size_t)f.col_idx < sensors_.size() && sensors_[(size_t)f.col_idx].fmt == SensorFmt::Text) {
+            err = "bad filter '" + f.col + "': text column (filters need numbers)";
+            return false;
+        }
+    }
+    for (auto& f : filters_) names_.push_back(f.col + "_f");
+
+    derive_ = std::make_unique<DeriveSet>(names_);
+    std::vector<std::string> dspecs;
+    for (auto& d : derived_) dspecs.push_back(d.name + "=" + d.path);
+    dspecs.insert(dspecs.end(), extra_derives.begin(), extra_derives.end());
+    if (!build_derive_set(*derive_, dspecs, err)) { err = "bad derived column " + err; return false; }
+    nbase_ = names_.size();
+    for (size_t i = 0; i < derive_->size(); ++i) names_.push_back(derive_->name(i));
+
+    if (!tkeys.empty()) {
+        // An oversampled rail needs a fresh tegrastats line per read, not one
+        // per tick; faster than kMinIntervalMs the reads share lines again.
+        int tover = 1;
+        for (auto& s : sensors_) if (s.tstat >= 0) tover = std::max(tover, s.over);
+        pwr_ = std::make_unique<PowerReader>(tkeys);
+        pwr_->start(std::max(PowerReader::kMinIntervalMs, period_ms / tover));
+    }
+    ptrs_.resize(nbase_);
+    return true;
+}
+
+bool Sampler::init(int period_ms, std::string& err) {
+    std::vector<SensorSpec> specs;
+    if (!parse_sensor_config(kDefaultSensors, "<builtin>", specs, err)) return false;
+    return init(std::move(specs), {}, {}, period_ms, err);
+}
+
+int Sampler::column(const std::string& name) const {
+    auto it = std::find(names_.begin(), names_.end(), name);
+    return (it == names_.end()) ? -1 : (int)(it - names_.begin());
+}
+
+double Sampler::read_num(Sensor& se, int64_t ts) {
+    if (se.psi) {
+        double some, full;
+        se.psi->read(ts, some, full);
+        return se.psi_full ? full : some;
+    }
+    if (se.fd >= 0) {
+        char buf[64];
+        ssize_t n = ::pread(se.fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EAGAIN) n = ::pread(se.fd, buf, sizeof(buf), 0);
+        while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ' || buf[n - 1] == '\r')) n--;
+        int64_t iv;
+        if (n <= 0 || std::from_chars(buf, buf + n, iv).ec != std::errc()) return std::nan("");
+        return (double)iv;
+    }
+    if (se.tstat >= 0) {
+        const long long mw = pwr_->mw((size_t)se.tstat);
+        return (mw >= 0) ? (double)mw : std::nan("");
+    }
+    if (se.meter >= 0) return meters_[(size_t)se.meter]->at(ts);
+    return std::nan("");
+}
+
+// Pool of shard threads; shard 0 is the (unpinned) sampling thread itself.
+// Start: bump gen (workers spin briefly on it, then sleep on cv_start).
+// Done: the last worker to finish its range wakes the sampling thread.
+struct ShardPool {
+    static constexpr int kSpin = 4000;
+
+    Sampler* smp = nullptr;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<std::thread> threads;
+    std::mutex mu;
+    std::condition_variable cv_start, cv_done;
+    std::atomic<uint64_t> gen{0};
+    std::atomic<int> pending{0};
+    bool quit = false;
+    Sample* cur = nullptr;
+    int64_t ts = 0;
+
+    void worker(size_t k) {
+        uint64_t seen = 0;
+        for (;;) {
+            uint64_t g = gen.load(std::memory_order_acquire);
+            for (int i = 0; i < kSpin && g == seen; ++i) g = gen.load(std::memory_order_acquire);
+            if (g == seen) {
+                std::unique_lock<std::mutex> lk(mu);
+                cv_start.wait(lk, [&] { return quit || gen.load(std::memory_order_acquire) != seen; });
+                if (quit) return;
+                g = gen.load(std::memory_order_acquire);
+            }
+            seen = g;
+            smp->read_range(ranges[k].first, ranges[k].second, *cur, ts);
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lk(mu);
+                cv_done.notify_one();
+            }
+        }
+    }
+
+    void run(Sample& s, int64_t t) {
+        cur = &s;
+        ts = t;
+        pending.store((int)threads.size(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            gen.fetch_add(1, std::memory_order_release);
+        }
+        cv_start.notify_all();
+        smp->read_range(ranges[0].first, ranges[0].second, s, t);
+        for (int i = 0; i < kSpin && pending.load(std::memory_order_acquire) > 0; ++i) {}
+        if (pending.load(std::memory_order_acquire) > 0) {
+            std::unique_lock<std::mutex> lk(mu);
+            cv_done.wait(lk, [&] { return pending.load(std::memory_order_acquire) == 0; });
+        }
+    }
+
+    ~ShardPool() {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            quit = true;
+        }
+        cv_start.notify_all();
+        for (auto& t : threads) t.join();
+    }
+};
+
+bool Sampler::set_threads(int n, bool pin, std::string& err) {
+    pool_.reset();
+    if (n <= 1 || sensors_.size() < 2) return true;
+    n = std::min<int>(n, (int)sensors_.size());
+
+    cpu_set_t allowed;
+    std::vector<int> cpus;
+    if (::sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+    }
+
+    auto pool = std::make_unique<ShardPool>();
+    pool->smp = this;
+    // Contiguous ranges keep each shard's Sample::num writes on its own cache lines.
+    const size_t per = sensors_.size() / (size_t)n, extra = sensors_.size() % (size_t)n;
+    for (size_t k = 0, b = 0; k < (size_t)n; ++k) {
+        const size_t e = b + per + (k < extra ? 1 : 0);
+        pool->ranges.emplace_back(b, e);
+        b = e;
+    }
+    for (size_t k = 1; k < (size_t)n; ++k) {
+        pool->threads.emplace_back(&ShardPool::worker, pool.get(), k);
+        if (pin && !cpus.empty()) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpus[k % cpus.size()], &one);
+            if (int rc = ::pthread_setaffinity_np(pool->threads.back().native_handle(), sizeof(one), &one); rc != 0) {
+                err = std::string("pthread_setaffinity_np: ") + std::strerror(rc);
+                return false;  // pool_ stays empty; ~ShardPool joins the started workers
+            }
+        }
+    }
+    pool_ = std::move(pool);
+    return true;
+}
+
+int Sampler::threads() const { return pool_ ? (int)pool_->ranges.size() : 1; }
+
+void Sampler::sample(Sample& s) {
+    const int64_t ts = now_ns();
+    s.dt_ns = (s.ts_ns == 0) ? 0 : (ts - s.ts_ns);
+    s.ts_ns = ts;
+
+    if (pool_) pool_->run(s, ts);
+    else read_range(0, sensors_.size(), s, ts);
+    tick_++;
+
+    size_t c = sensors_.size() + nsd_;
+    for (auto& f : filters_) s.num[c++] = f.step(s.num[f.col_idx]);
+    if (!derive_->empty()) {
+        for (size_t i = 0; i < nbase_; ++i) ptrs_[i] = &s.num[i];
+        derive_->eval(ptrs_.data(), 1);
+        for (size_t i = 0; i < derive_->size(); ++i) s.num[nbase_ + i] = derive_->out(i)[0];
+    }
+}
+
+void Sampler::read_range(size_t begin, size_t end, Sample& s, int64_t ts) {
+    char buf[256];
+    struct Prof {
+        Sensor& se;
+        int64_t t0;
+        ~Prof() { if (t0) { se.cost_ns += now_ns() - t0; se.reads++; } }
+    };
+    for (size_t i = begin; i < end; ++i) {
+        Sensor& se = sensors_[i];
+        const bool due = (tick_ % se.every == 0);
+        if (!due && se.over <= 1) continue;
+        Prof prof{se, profile_ ? now_ns() : 0};
+        double& v = s.num[se.col];
+        if (se.fmt == SensorFmt::Text) {
+            ssize_t n = (se.fd >= 0) ? ::pread(se.fd, buf, sizeof(buf) - 1, 0) : -1;
+            if (n < 0 && se.fd >= 0 && errno == EAGAIN) n = ::pread(se.fd, buf, sizeof(buf) - 1, 0);
+            while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ' || buf[n - 1] == '\r')) n--;
+            if (n <= 0) s.text[se.col].clear();
+            else s.text[se.col].assign(buf, (size_t)n);
+            continue;
+        }
+        if (!se.perf_fds.empty()) {
+            uint64_t tot = 0;
+            for (int fd : se.perf_fds) tot += read_perf(fd);
+            v = (double)(tot - se.perf_prev);
+            se.perf_prev = tot;
+        } else if (se.over > 1) {
+            // Final read of the interval; report the mean of all reads since the last due tick.
+            se.acc.add(read_num(se, ts));
+            if (!due) continue;
+            v = se.acc.mean();
+            s.num[(size_t)se.sd_col] = se.acc.sd() * std::fabs(se.spec.gain);
+            se.acc = OverAcc{};
+        } else {
+            v = read_num(se, ts);
+        }
+        if (se.cal) {
+            v = v * se.spec.gain + se.spec.offset;
+            if (se.fmt == SensorFmt::Int) v = std::round(v);
+        }
+    }
+}
+
+void Sampler::subsample(int slot) {
+    if (slot <= 0 || slot >= slots_) return;
+    const int64_t ts = now_ns();
+    for (auto& se : sensors_) {
+        if (se.over <= 1) continue;
+        // K reads per tick at slots floor(i * slots / K); slot 0 is sample() itself.
+        if ((int64_t)slot * se.over / slots_ == (int64_t)(slot - 1) * se.over / slots_) continue;
+        se.acc.add(read_num(se, ts));
+    }
+}
+
+void Sampler::wait_until(std::chrono::steady_clock::time_point next, int period_ms) {
+    if (slots_ > 1) {
+        const auto period = std::chrono::milliseconds(period_ms);
+        const auto start = next - period;
+        for (int j = 1; j < slots_; ++j) {
+            std::this_thread::sleep_until(start + period * j / slots_);
+            subsample(j);
+        }
+    }
+    std::this_thread::sleep_until(next);
+}
+
+void Sampler::reset_costs() {
+    for (auto& se : sensors_) { se.cost_ns = 0; se.reads = 0; }
+}
+
+void Sampler::retime(int period_ms) {
+    for (auto& se : sensors_) se.every = every_for(se.spec, period_ms);
+}
+
+} // namespace dvfs
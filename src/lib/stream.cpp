@@ -0,0 +1,365 @@
+// stream.cpp
+#include "dvfs/stream.hpp"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+namespace {
+
+constexpr int kInitialSyncRounds = 8;
+constexpr int64_t kResyncNs = 1000000000LL;  // one Sync per second while streaming
+constexpr int kResyncWindow = 5;             // Clock frame = best of 5 rounds
+
+uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+int64_t unzigzag(uint64_t u) { return (int64_t)(u >> 1) ^ -(int64_t)(u & 1); }
+
+// Integral values within +-2^52 are carried as deltas; the rest as raw doubles.
+bool as_int(double v, int64_t& out) {
+    if (!(std::fabs(v) < 4503599627370496.0)) return false;
+    out = (int64_t)v;
+    return (double)out == v;
+}
+
+} // namespace
+
+// ---- primitives ----
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+void put_i64(std::string& out, int64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back((char)((uint64_t)v >> (8 * i)));
+}
+
+void put_str(std::string& out, const std::string& s) {
+    put_varint(out, s.size());
+    out += s;
+}
+
+bool get_varint(const char*& p, const char* e, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < e && shift < 64; shift += 7) {
+        const uint8_t b = (uint8_t)*p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool get_i64(const char*& p, const char* e, int64_t& v) {
+    if (e - p < 8) return false;
+    uint64_t u = 0;
+    for (int i = 0; i < 8; ++i) u |= (uint64_t)(uint8_t)p[i] << (8 * i);
+    v = (int64_t)u;
+    p += 8;
+    return true;
+}
+
+bool get_str(const char*& p, const char* e, std::string& s) {
+    uint64_t n;
+    if (!get_varint(p, e, n) || (uint64_t)(e - p) < n) return false;
+    s.assign(p, (size_t)n);
+    p += n;
+    return true;
+}
+
+void append_frame(std::string& out, FrameType t, const std::string& payload) {
+    out.push_back((char)t);
+    const uint32_t n = (uint32_t)payload.size();
+    for (int i = 0; i < 4; ++i) out.push_back((char)(n >> (8 * i)));
+    out += payload;
+}
+
+size_t frame_size(const char* p, const char* e) {
+    if ((size_t)(e - p) < kFrameHeader) return 0;
+    uint32_t n = 0;
+    for (int i = 0; i < 4; ++i) n |= (uint32_t)(uint8_t)p[1 + i] << (8 * i);
+    if (n > kMaxFrame || (uint8_t)p[0] < (uint8_t)FrameType::Hello || (uint8_t)p[0] > (uint8_t)FrameType::Rows)
+        return SIZE_MAX;
+    return ((size_t)(e - p) < kFrameHeader + n) ? 0 : kFrameHeader + n;
+}
+
+std::string encode_hello(const std::string& board, const std::vector<std::string>& cols) {
+    std::string out(kStreamMagic, sizeof(kStreamMagic) - 1);
+    put_str(out, board);
+    put_varint(out, cols.size());
+    for (auto& c : cols) put_str(out, c);
+    return out;
+}
+
+bool decode_hello(const char* p, const char* e, std::string& board, std::vector<std::string>& cols) {
+    const size_t m = sizeof(kStreamMagic) - 1;
+    if ((size_t)(e - p) < m || std::memcmp(p, kStreamMagic, m) != 0) return false;
+    p += m;
+    uint64_t n;
+    if (!get_str(p, e, board) || !get_varint(p, e, n) || n > 4096) return false;
+    cols.resize((size_t)n);
+    for (auto& c : cols) if (!get_str(p, e, c)) return false;
+    return p == e;
+}
+
+// ---- row codec ----
+void RowEncoder::add(int64_t ts_ns, const double* v) {
+    put_varint(body_, zigzag(ts_ns - prev_ts_));
+    prev_ts_ = ts_ns;
+    for (size_t i = 0; i < prev_.size(); ++i) {
+        int64_t iv;
+        if (std::isnan(v[i])) {
+            body_.push_back(0x01);
+        } else if (as_int(v[i], iv)) {
+            put_varint(body_, zigzag(iv - prev_[i]) << 1);
+            prev_[i] = iv;
+        } else {
+            body_.push_back(0x03);
+            int64_t bits;
+            std::memcpy(&bits, &v[i], 8);
+            put_i64(body_, bits);
+        }
+    }
+    rows_++;
+}
+
+void RowEncoder::take(std::string& out) {
+    if (rows_ == 0) return;
+    std::string payload;
+    payload.reserve(body_.size() + 4);
+    put_varint(payload, rows_);
+    payload += body_;
+    append_frame(out, FrameType::Rows, payload);
+    body_.clear();
+    rows_ = 0;
+}
+
+bool RowDecoder::decode(const char* p, const char* e, std::vector<int64_t>& ts, std::vector<double>& vals) {
+    uint64_t nrows, u;
+    if (!get_varint(p, e, nrows)) return false;
+    for (uint64_t r = 0; r < nrows; ++r) {
+        if (!get_varint(p, e, u)) return false;
+        prev_ts_ += unzigzag(u);
+        ts.push_back(prev_ts_);
+        for (size_t i = 0; i < prev_.size(); ++i) {
+            if (!get_varint(p, e, u)) return false;
+            if (u == 0x01) {
+                vals.push_back(std::nan(""));
+            } else if (u == 0x03) {
+                int64_t bits;
+                if (!get_i64(p, e, bits)) return false;
+                double d;
+                std::memcpy(&d, &bits, 8);
+                vals.push_back(d);
+            } else if (u & 1) {
+                return false;
+            } else {
+                prev_[i] += unzigzag(u >> 1);
+                vals.push_back((double)prev_[i]);
+            }
+        }
+    }
+    return p == e;
+}
+
+// ---- board side ----
+StreamClient::~StreamClient() { close(); }
+
+bool StreamClient::connect(const std::string& hostport, const std::string& board,
+                           const std::vector<std::string>& cols, std::string& err) {
+    close();
+    const auto colon = hostport.rfind(':');
+    if (colon == std::string::npos) {
+        err = "expected host:port, got '" + hostport + "'";
+        return false;
+    }
+    const std::string host = hostport.substr(0, colon), port = hostport.substr(colon + 1);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &res); rc != 0) {
+        err = hostport + ": " + gai_strerror(rc);
+        return false;
+    }
+    for (addrinfo* a = res; a && fd_ < 0; a = a->ai_next) {
+        fd_ = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd_ >= 0 && ::connect(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+    ::freeaddrinfo(res);
+    if (fd_ < 0) {
+        err = "Failed to connect: " + hostport;
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    std::string f;
+    append_frame(f, FrameType::Hello, encode_hello(board, cols));
+    if (!send_all(f)) {
+        err = "Failed to send hello: " + hostport;
+        close();
+        return false;
+    }
+
+    int64_t best_rtt = INT64_MAX, best_off = 0;
+    for (int i = 0; i < kInitialSyncRounds; ++i) {
+        if (!sync_round(1000, best_rtt, best_off)) {
+            err = "Clock sync failed: " + hostport;
+            close();
+            return false;
+        }
+    }
+    offset_ = best_off;
+    rtt_ = best_rtt;
+    std::string clk;
+    put_i64(clk, offset_);
+    put_i64(clk, rtt_);
+    f.clear();
+    append_frame(f, FrameType::Clock, clk);
+    if (!send_all(f)) {
+        err = "Failed to send clock: " + hostport;
+        close();
+        return false;
+    }
+    last_sync_ = now_ns();
+    enc_.reset(new RowEncoder(cols.size()));
+    return true;
+}
+
+bool StreamClient::send_all(const std::string& s) {
+    size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = ::send(fd_, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += (size_t)n;
+    }
+    sent_ += s.size();
+    return true;
+}
+
+// One blocking Sync/SyncAck exchange; keeps the lowest-RTT estimate.
+bool StreamClient::sync_round(int timeout_ms, int64_t& best_rtt, int64_t& best_off) {
+    std::string p, f;
+    const int64_t c0 = now_ns();
+    put_i64(p, c0);
+    append_frame(f, FrameType::Sync, p);
+    if (!send_all(f)) return false;
+
+    char buf[256];
+    for (;;) {
+        const size_t fs = frame_size(in_.data(), in_.data() + in_.size());
+        if (fs == SIZE_MAX) return false;
+        if (fs) {
+            const char* q = in_.data() + kFrameHeader;
+            int64_t echo = 0, s1 = 0;
+            const bool ack = (FrameType)in_[0] == FrameType::SyncAck &&
+                             get_i64(q, in_.data() + fs, echo) && get_i64(q, in_.data() + fs, s1);
+            in_.erase(0, fs);
+            if (ack && echo == c0) {
+                const int64_t c2 = now_ns();
+                if (c2 - c0 < best_rtt) {
+                    best_rtt = c2 - c0;
+                    best_off = c0 + (c2 - c0) / 2 - s1;
+                }
+                return true;
+            }
+            continue;
+        }
+        pollfd pfd{fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, timeout_ms) <= 0) return false;
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        in_.append(buf, (size_t)n);
+    }
+}
+
+// Drain SyncAcks from periodic resyncs without blocking; every kResyncWindow
+// acks, publish the best one.
+void StreamClient::poll_acks() {
+    char buf[256];
+    for (;;) {
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) break;
+        in_.append(buf, (size_t)n);
+    }
+    const int64_t c2 = now_ns();
+    for (size_t fs; (fs = frame_size(in_.data(), in_.data() + in_.size())) != 0 && fs != SIZE_MAX;) {
+        const char* q = in_.data() + kFrameHeader;
+        int64_t c0 = 0, s1 = 0;
+        if ((FrameType)in_[0] == FrameType::SyncAck &&
+            get_i64(q, in_.data() + fs, c0) && get_i64(q, in_.data() + fs, s1)) {
+            // Acks queued behind a batch read late; a larger rtt just loses the window.
+            if (c2 - c0 < win_rtt_) {
+                win_rtt_ = c2 - c0;
+                win_off_ = c0 + (c2 - c0) / 2 - s1;
+            }
+            win_n_++;
+        }
+        in_.erase(0, fs);
+    }
+    if (win_n_ >= kResyncWindow) {
+        offset_ = win_off_;
+        rtt_ = win_rtt_;
+        std::string clk;
+        put_i64(clk, offset_);
+        put_i64(clk, rtt_);
+        append_frame(out_, FrameType::Clock, clk);
+        win_rtt_ = INT64_MAX;
+        win_n_ = 0;
+    }
+}
+
+bool StreamClient::push(int64_t ts_ns, const double* v) {
+    if (fd_ < 0) return false;
+    enc_->add(ts_ns, v);
+    return (enc_->rows() >= batch_) ? flush() : true;
+}
+
+bool StreamClient::flush() {
+    if (fd_ < 0) return false;
+    poll_acks();
+    enc_->take(out_);
+    const int64_t t = now_ns();
+    if (t - last_sync_ >= kResyncNs) {
+        std::string p;
+        put_i64(p, t);
+        append_frame(out_, FrameType::Sync, p);
+        last_sync_ = t;
+    }
+    const bool ok = out_.empty() || send_all(out_);
+    out_.clear();
+    return ok;
+}
+
+void StreamClient::close() {
+    if (fd_ < 0) return;
+    if (enc_) flush();
+    ::shutdown(fd_, SHUT_WR);
+    ::close(fd_);
+    fd_ = -1;
+    enc_.reset();
+    in_.clear();
+}
+
+} // namespace dvfs
@@ -0,0 +1,79 @@
+// sysfs.cpp
+#include "dvfs/sysfs.hpp"
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace dvfs {
+
+std::optional<std::string> read_text(const std::string& path) {
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == EAGAIN) { ::usleep(1000); continue; }
+            return std::nullopt;
+        }
+        char buf[4096];
+        ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
+        int e = errno;
+        ::close(fd);
+
+        if (n < 0) {
+            if (e == EAGAIN) { ::usleep(1000); continue; }
+            return std::nullopt;
+        }
+        buf[n] = '\0';
+        std::string s(buf);
+        while (!s.empty() && (s.back()=='\n' || s.back()=='\r' || s.back()==' ' || s.back()=='\t')) s.pop_back();
+        return s;
+    }
+    return std::nullopt;
+}
+
+std::optional<long long> read_ll(const std::string& path) {
+    auto t = read_text(path);
+    if (!t) return std::nullopt;
+    long long v;
+    auto r = std::from_chars(t->data(), t->data() + t->size(), v);
+    if (r.ec != std::errc() || r.ptr != t->data() + t->size()) return std::nullopt;
+    return v;
+}
+
+bool write_text(const std::string& path, const std::string& val) {
+    int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0) return false;
+    std::string v = val;
+    if (v.empty() || v.back() != '\n') v.push_back('\n');
+    ssize_t n = ::write(fd, v.c_str(), v.size());
+    ::close(fd);
+    return n == (ssize_t)v.size();
+}
+
+std::optional<std::string> read_file(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return std::nullopt;
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+bool exists(const std::string& p) { return fs::exists(p); }
+
+std::vector<std::string> list_dirs(const std::string& root) {
+    std::vector<std::string> out;
+    if (!fs::exists(root)) return out;
+    for (auto const& e : fs::directory_iterator(root)) {
+        if (e.is_directory()) out.push_back(e.path().string());
+    }
+    return out;
+}
+
+} // namespace dvfs
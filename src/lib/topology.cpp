@@ -0,0 +1,109 @@
+// topology.cpp
+#include "dvfs/topology.hpp"
+
+#include <filesystem>
+
+#include "dvfs/sysfs.hpp"
+
+namespace fs = std::filesystem;
+
+namespace dvfs {
+
+std::optional<std::string> find_cpu_policy_dir() {
+    // /sys/devices/system/cpu/cpufreq/policy*
+    const std::string a = "/sys/devices/system/cpu/cpufreq";
+    if (exists(a)) {
+        for (auto& d : list_dirs(a)) {
+            if (fs::path(d).filename().string().rfind("policy", 0) == 0 &&
+                exists(d + "/scaling_cur_freq")) {
+                return d;
+            }
+        }
+    }
+    // fallback
+    const std::string b = "/sys/devices/system/cpu/cpu0/cpufreq";
+    if (exists(b) && exists(b + "/scaling_cur_freq")) return b;
+    return std::nullopt;
+}
+
+std::optional<std::string> find_gpu_devfreq_dir() {
+    // Jetson Orin typically: /sys/class/devfreq/17000000.gpu
+    const std::string root = "/sys/class/devfreq";
+    if (!exists(root)) return std::nullopt;
+
+    auto is_blacklisted = [](const std::string& name) {
+        return (name.find("nvjpg") != std::string::npos) ||
+               (name.find("nvenc") != std::string::npos) ||
+               (name.find("nvdec") != std::string::npos) ||
+               (name.find("vic")   != std::string::npos) ||
+               (name.find("se")    != std::string::npos);
+    };
+
+    // Prefer obvious GPU-like names
+    for (auto& d : list_dirs(root)) {
+        std::string name = fs::path(d).filename().string();
+        if (is_blacklisted(name)) continue;
+        if ((name.find("ga10b") != std::string::npos || name.find("gpu") != std::string::npos) &&
+            exists(d + "/cur_freq") && exists(d + "/available_frequencies")) {
+            return d;
+        }
+    }
+    // Fallback: any devfreq that has cur_freq + available_frequencies
+    for (auto& d : list_dirs(root)) {
+        std::string name = fs::path(d).filename().string();
+        if (is_blacklisted(name)) continue;
+        if (exists(d + "/cur_freq") && exists(d + "/available_frequencies")) return d;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> find_thermal_zone_by_keywords(const std::vector<std::string>& kws) {
+    const std::string tzroot = "/sys/class/thermal";
+    if (!exists(tzroot)) return std::nullopt;
+    for (auto const& e : fs::directory_iterator(tzroot)) {
+        if (!e.is_directory()) continue;
+        auto name = e.path().filename().string();
+        if (name.find("thermal_zone") == std::string::npos) continue;
+        auto type = read_text(e.path().string() + "/type");
+        if (!type) continue;
+        for (auto& kw : kws) {
+            if (type->find(kw) != std::string::npos) return e.path().string();
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> find_pwm_fan_cooling_device_dir() {
+    // Find /sys/class/thermal/cooling_device*/type == pwm-fan
+    const std::string root = "/sys/class/thermal";
+    if (!exists(root)) return std::nullopt;
+    for (auto const& e : fs::directory_iterator(root)) {
+        if (!e.is_directory()) continue;
+        auto name = e.path().filename().string();
+        if (name.rfind("cooling_device", 0) != 0) continue;
+        auto type = read_text(e.path().string() + "/type");
+        if (type && type->find("pwm-fan") != std::string::npos) return e.path().string();
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> find_hwmon_attr(const std::string& spec) {
+    auto slash = spec.find('/');
+    if (slash == std::string::npos) return std::nullopt;
+    const std::string name = spec.substr(0, slash), attr = spec.substr(slash + 1);
+    for (auto& d : list_dirs("/sys/class/hwmon")) {
+        auto n = read_text(d + "/name");
+        if (n && *n == name && exists(d + "/" + attr)) return d + "/" + attr;
+    }
+    return std::nullopt;
+}
+
+Topology Topology::discover() {
+    Topology t;
+    t.cpufreq = find_cpu_policy_dir();
+    t.gpu     = find_gpu_devfreq_dir();
+    t.fan     = find_pwm_fan_cooling_device_dir();
+    return t;
+}
+
+} // namespace dvfs
@@ -0,0 +1,113 @@
+// tuner.cpp
+#include "dvfs/tuner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <time.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+int64_t process_cpu_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool parse_budget(const std::string& s, double& out) {
+    if (s.empty()) return false;
+    const bool pct = s.back() == '%';
+    double v = parse_num(s.data(), s.data() + s.size() - (pct ? 1 : 0));
+    if (pct) v /= 100.0;
+    if (!(v > 0.0 && v < 1.0)) return false;
+    out = v;
+    return true;
+}
+
+OverheadTuner::OverheadTuner(Sampler& smp, double budget, int floor_ms, int max_ms)
+    : smp_(smp), budget_(budget), floor_ms_(floor_ms), max_ms_(std::max(floor_ms, max_ms)),
+      slow_(smp.sensors().size(), 1) {
+    smp_.set_profiling(true);
+    smp_.reset_costs();
+}
+
+bool OverheadTuner::tick(int& period_ms, std::string& note) {
+    const int64_t now = now_ns();
+    const int64_t cpu = process_cpu_ns();
+    if (win_t0_ == 0) {
+        win_t0_ = now;
+        win_cpu0_ = cpu;
+        return false;
+    }
+    win_ticks_++;
+    const int64_t wall = now - win_t0_;
+    if (wall < kWindowNs || win_ticks_ < 5) return false;
+
+    last_ = (double)(cpu - win_cpu0_) / (double)wall;
+    const double tick_cost = (double)(cpu - win_cpu0_) / (double)win_ticks_;
+    const auto& sens = smp_.sensors();
+    const int old_period = period_ms;
+    char buf[256];
+    note.clear();
+
+    auto apply = [&](int p) {
+        smp_.retime(p);
+        for (size_t i = 0; i < sens.size(); ++i) if (slow_[i] > 1) smp_.set_every(i, sens[i].every * slow_[i]);
+    };
+
+    if (last_ > budget_) {
+        // Most expensive sensor per tick that can still be slowed.
+        size_t hot = sens.size();
+        double hot_cost = 0.0;
+        for (size_t i = 0; i < sens.size(); ++i) {
+            const double c = (double)sens[i].cost_ns / (double)win_ticks_;
+            if (c > hot_cost && sens[i].every * 2 * period_ms <= max_ms_) { hot = i; hot_cost = c; }
+        }
+        if (hot < sens.size() && hot_cost >= 0.25 * tick_cost) {
+            slow_[hot] *= 2;
+            smp_.set_every(hot, sens[hot].every * 2);
+            std::snprintf(buf, sizeof(buf), "%s every %d ticks (%d ms): %.0f us/tick, overhead %.2f%% > %.2f%%",
+                          sens[hot].spec.name.c_str(), sens[hot].every, sens[hot].every * period_ms,
+                          hot_cost / 1e3, last_ * 100, budget_ * 100);
+            note = buf;
+        } else {
+            period_ms = std::min(max_ms_, (int)std::ceil(period_ms * last_ / budget_ * 1.1));
+        }
+    } else if (last_ < 0.5 * budget_) {
+        if (period_ms > floor_ms_) {
+            // Aim for ~80% of budget at the shorter period.
+            period_ms = std::max(floor_ms_, (int)std::ceil(period_ms * last_ / (0.8 * budget_)));
+        } else {
+            // Restore the cheapest slowed sensor first.
+            size_t best = sens.size();
+            for (size_t i = 0; i < sens.size(); ++i) {
+                if (slow_[i] > 1 && (best == sens.size() || sens[i].cost_ns < sens[best].cost_ns)) best = i;
+            }
+            if (best < sens.size()) {
+                slow_[best] /= 2;
+                smp_.set_every(best, std::max(1, sens[best].every / 2));
+                std::snprintf(buf, sizeof(buf), "%s every %d ticks (%d ms): overhead %.2f%% < %.2f%%",
+                              sens[best].spec.name.c_str(), sens[best].every, sens[best].every * period_ms,
+                              last_ * 100, budget_ * 100 / 2);
+                note = buf;
+            }
+        }
+    }
+    if (period_ms != old_period) {
+        apply(period_ms);
+        std::snprintf(buf, sizeof(buf), "period %d -> %d ms: overhead %.2f%% (budget %.2f%%)",
+                      old_period, period_ms, last_ * 100, budget_ * 100);
+        note = buf;
+    }
+
+    smp_.reset_costs();
+    win_t0_ = now;
+    win_cpu0_ = cpu;
+    win_ticks_ = 0;
+    return !note.empty();
+}
+
+} // namespace dvfs
@@ -0,0 +1,155 @@
+// uclamp.cpp
+#include "dvfs/uclamp.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "dvfs/sysfs.hpp"
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+namespace {
+
+// struct sched_attr, SCHED_ATTR_SIZE_VER1 (util clamps); glibc has no wrapper.
+struct SchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
+constexpr uint64_t kFlagKeepAll = 0x08 | 0x10;  // SCHED_FLAG_KEEP_POLICY | KEEP_PARAMS
+constexpr uint64_t kFlagClampMin = 0x20;
+constexpr uint64_t kFlagClampMax = 0x40;
+
+std::string cgroup_pct(double pct) {
+    if (pct >= 100.0) return "max";
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%.2f", pct < 0 ? 0.0 : pct);
+    return buf;
+}
+
+} // namespace
+
+bool get_task_uclamp(int tid, Uclamp& out, std::string& err) {
+    SchedAttr a{};
+    if (::syscall(SYS_sched_getattr, tid, &a, (unsigned)sizeof(a), 0u) != 0) {
+        err = "sched_getattr(" + std::to_string(tid) + "): " + std::strerror(errno);
+        return false;
+    }
+    if (a.size < sizeof(a)) {
+        err = "kernel without util clamping (sched_attr size " + std::to_string(a.size) + ")";
+        return false;
+    }
+    out.min = (int)a.sched_util_min;
+    out.max = (int)a.sched_util_max;
+    return true;
+}
+
+bool set_task_uclamp(int tid, const Uclamp& u, std::string& err) {
+    // Only the sides given get their flag: with the flag set the kernel reads
+    // (u32)-1 as "reset to default", which would wipe the other side.
+    if (u.min < 0 && u.max < 0) return true;
+    SchedAttr a{};
+    a.size = sizeof(a);
+    a.sched_flags = kFlagKeepAll | (u.min >= 0 ? kFlagClampMin : 0) | (u.max >= 0 ? kFlagClampMax : 0);
+    a.sched_util_min = (uint32_t)std::max(u.min, 0);
+    a.sched_util_max = (uint32_t)std::max(u.max, 0);
+    if (::syscall(SYS_sched_setattr, tid, &a, 0u) != 0) {
+        err = "sched_setattr(" + std::to_string(tid) + "): " + std::strerror(errno);
+        if (errno == EOPNOTSUPP) err += " (kernel without CONFIG_UCLAMP_TASK)";
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> process_threads(int pid) {
+    std::vector<int> out;
+    for (auto& d : list_dirs("/proc/" + std::to_string(pid) + "/task")) {
+        const auto slash = d.rfind('/');
+        out.push_back(std::atoi(d.c_str() + (slash == std::string::npos ? 0 : slash + 1)));
+    }
+    if (out.empty()) out.push_back(pid);
+    return out;
+}
+
+bool set_cgroup_uclamp(const std::string& cgroup, double min_pct, double max_pct, std::string& err) {
+    bool ok = true;
+    if (min_pct >= 0 && !write_text(cgroup + "/cpu.uclamp.min", cgroup_pct(min_pct))) {
+        err = "Failed to write: " + cgroup + "/cpu.uclamp.min";
+        ok = false;
+    }
+    if (max_pct >= 0 && !write_text(cgroup + "/cpu.uclamp.max", cgroup_pct(max_pct))) {
+        err = "Failed to write: " + cgroup + "/cpu.uclamp.max";
+        ok = false;
+    }
+    return ok;
+}
+
+bool parse_uclamp_value(const std::string& s, int& out) {
+    if (s.empty()) return false;
+    const bool pct = s.back() == '%';
+    char* end = nullptr;
+    const double v = std::strtod(s.c_str(), &end);
+    if (end != s.c_str() + s.size() - (pct ? 1 : 0)) return false;
+    const double x = pct ? v * kUclampScale / 100.0 : v;
+    if (!(x >= 0.0 && x <= kUclampScale)) return false;
+    out = (int)std::lround(x);
+    return true;
+}
+
+// ---- UclampActuator ----
+bool UclampActuator::clamp_process(int pid, const Uclamp& u, std::string& err) {
+    bool any = false;
+    for (int tid : process_threads(pid)) {
+        Uclamp orig;
+        if (!tasks_.count(tid)) {
+            if (!get_task_uclamp(tid, orig, err)) continue;
+        }
+        if (!set_task_uclamp(tid, u, err)) continue;
+        tasks_.emplace(tid, orig);
+        any = true;
+    }
+    return any;
+}
+
+bool UclampActuator::clamp_cgroup(const std::string& cgroup, double min_pct, double max_pct, std::string& err) {
+    if (!cgroups_.count(cgroup)) {
+        auto mn = read_text(cgroup + "/cpu.uclamp.min");
+        auto mx = read_text(cgroup + "/cpu.uclamp.max");
+        if (!mn || !mx) {
+            err = "No cpu.uclamp.{min,max} under " + cgroup + " (cgroup v2 with the cpu controller?)";
+            return false;
+        }
+        cgroups_[cgroup] = {*mn, *mx};
+    }
+    return set_cgroup_uclamp(cgroup, min_pct, max_pct, err);
+}
+
+void UclampActuator::restore() {
+    std::string err;
+    for (auto& [tid, u] : tasks_) set_task_uclamp(tid, u, err);
+    for (auto& [cg, v] : cgroups_) {
+        write_text(cg + "/cpu.uclamp.min", v.first);
+        write_text(cg + "/cpu.uclamp.max", v.second);
+    }
+    tasks_.clear();
+    cgroups_.clear();
+}
+
+} // namespace dvfs
@@ -0,0 +1,69 @@
+// util.cpp
+#include "dvfs/util.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <system_error>
+
+namespace dvfs {
+
+int64_t now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+double parse_num(const char* b, const char* e) {
+    if (b == e) return std::nan("");
+    double v;
+    auto r = std::from_chars(b, e, v);
+    if (r.ec != std::errc() || r.ptr != e) return std::nan("");
+    return v;
+}
+
+void append_num(std::string& s, double v) {
+    if (!std::isfinite(v)) return;
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    s.append(buf, r.ptr);
+}
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t");
+    size_t e = s.find_last_not_of(" \t");
+    return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+}
+
+std::vector<std::string> config_tokens(const std::string& line) {
+    std::vector<std::string> out;
+    std::string cur;
+    bool in_q = false, any = false;
+    for (char c : line) {
+        if (c == '"') { in_q = !in_q; any = true; continue; }
+        if (!in_q && c == '#') break;
+        if (!in_q && (c == ' ' || c == '\t' || c == '\r')) {
+            if (any) { out.push_back(cur); cur.clear(); any = false; }
+            continue;
+        }
+        cur.push_back(c);
+        any = true;
+    }
+    if (any) out.push_back(cur);
+    return out;
+}
+
+std::vector<std::string> split_top(const std::string& s) {
+    std::vector<std::string> out;
+    int depth = 0;
+    std::string cur;
+    for (char c : s) {
+        if (c == '(') depth++;
+        if (c == ')') depth--;
+        if (c == ',' && depth == 0) { out.push_back(trim(cur)); cur.clear(); continue; }
+        cur.push_back(c);
+    }
+    if (!trim(cur).empty()) out.push_back(trim(cur));
+    return out;
+}
+
+} // namespace dvfs
@@ -0,0 +1,105 @@
+// writer.cpp
+#include "dvfs/writer.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dvfs/util.hpp"
+
+namespace dvfs {
+
+bool BufWriter::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ok_ = fd_ >= 0;
+    return ok_;
+}
+
+void BufWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool BufWriter::flush() {
+    size_t off = 0;
+    while (off < len_ && fd_ >= 0) {
+        ssize_t n = ::write(fd_, buf_.get() + off, len_ - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok_ = false;
+            break;
+        }
+        off += (size_t)n;
+    }
+    len_ = 0;
+    return ok_;
+}
+
+namespace {
+
+std::string fmt_temp_C_1dp(long long mc) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", mc / 1000.0);
+    return std::string(buf);
+}
+
+} // namespace
+
+void append_csv_header(std::string& out, const Sampler& smp) {
+    out += "ts_ns,dt_ns";
+    for (auto& c : smp.columns()) { out.push_back(','); out += c; }
+    out.push_back('\n');
+}
+
+void append_csv_row(std::string& out, const Sampler& smp, const Sample& s) {
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), s.ts_ns).ptr);
+    out.push_back(',');
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), s.dt_ns).ptr);
+    const auto& sens = smp.sensors();
+    for (size_t i = 0; i < s.num.size(); ++i) {
+        out.push_back(',');
+        if (i < sens.size() && sens[i].fmt == SensorFmt::Text) { out += s.text[i]; continue; }
+        const double v = s.num[i];
+        if (i < sens.size() && sens[i].fmt == SensorFmt::Int) {
+            if (!std::isnan(v)) out.append(buf, std::to_chars(buf, buf + sizeof(buf), (int64_t)v).ptr);
+        } else {
+            append_num(out, v);
+        }
+    }
+    out.push_back('\n');
+}
+
+std::vector<std::string> format_watch_lines(const Sampler& smp, const Sample& s) {
+    std::vector<std::string> titles, lines;
+    for (auto& se : smp.sensors()) {
+        if (se.spec.watch.empty()) continue;
+        size_t g = std::find(titles.begin(), titles.end(), se.spec.watch) - titles.begin();
+        if (g == titles.size()) { titles.push_back(se.spec.watch); lines.push_back(se.spec.watch + ":"); }
+        else lines[g] += " |";
+
+        std::string val;
+        const double v = s.num[se.col];
+        if (se.fmt == SensorFmt::Text) val = s.text[se.col].empty() ? "NA" : s.text[se.col];
+        else if (std::isnan(v)) val = "NA";
+        else if (se.spec.unit == "mC") val = fmt_temp_C_1dp((long long)v) + "C";
+        else if (se.psi) {
+            char b[32];
+            std::snprintf(b, sizeof(b), "%.1f%%", v);
+            val = b;
+        }
+        else val = std::to_string((long long)v) + (se.spec.unit == "mW" ? "mW" : "");
+        lines[g] += " " + se.spec.label + "=" + val;
+    }
+    return lines;
+}
+
+} // namespace dvfs